@@ -14,7 +14,15 @@ folder="$(dirname "$filename")"
 filename_only="$(basename "$filename")"
 
 
-pushd "$folder/" > /dev/null
+# Shipped with every bot so it can also run as a zygote (see util/Zygote.h).
+# The image is built from a copy, so the bot's own folder and files stay untouched.
+context="$(mktemp -d)"
+trap 'rm -rf "$context"' EXIT
+mkdir "$context/bot"
+cp -a "$folder/." "$context/bot/"
+cp "$(dirname "$0")/zygote.py" "$context/zygote.py"
+
+pushd "$context/" > /dev/null
 
 podman build -f /home/david/code/BottleBats/bots-scripts/py/Dockerfile -t "$container_name" . --build-arg "filename=./$filename_only"
 
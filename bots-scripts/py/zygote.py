@@ -0,0 +1,296 @@
+#!/usr/bin/env python3
+# Keeps a python runtime with the bot already compiled and its imports loaded,
+# and forks a new bot for every instance the server asks for.
+# The protocol is described in util/Zygote.h.
+import ast
+import ctypes
+import os
+import selectors
+import signal
+import socket
+import sys
+import traceback
+
+
+def local_modules(folder):
+    # Every top level name the bot's folder provides, whatever is found there shadows other modules.
+    names = set()
+    for entry in os.listdir(folder):
+        names.add(entry if os.path.isdir(os.path.join(folder, entry)) else entry.split('.', 1)[0])
+    return names
+
+
+def preload(path):
+    with open(path) as file:
+        source = file.read()
+    tree = ast.parse(source, path)
+
+    # Bot code may only run after isolate(), so only modules from outside the bot's
+    # folder (the standard library and site-packages) are loaded here.
+    folder = sys.path.pop(0)
+    local = local_modules(folder)
+    loaded_before = set(sys.modules)
+    try:
+        # Only top level imports, anything else may depend on the bot running.
+        for node in tree.body:
+            names = []
+            if isinstance(node, ast.Import):
+                names = [alias.name for alias in node.names]
+            elif isinstance(node, ast.ImportFrom) and node.level == 0 and node.module:
+                names = [node.module]
+            for name in names:
+                if name.split('.', 1)[0] in local:
+                    continue
+                try:
+                    __import__(name)
+                except Exception:
+                    pass
+    finally:
+        sys.path.insert(0, folder)
+
+    # Started directly the bot would get its own version of these, also when imported indirectly.
+    for name in set(sys.modules) - loaded_before:
+        if name.split('.', 1)[0] in local:
+            del sys.modules[name]
+
+    return compile(tree, path, 'exec')
+
+
+CLONE_NEWNS = 0x00020000
+CLONE_NEWUSER = 0x10000000
+CLONE_NEWPID = 0x20000000
+MS_NOSUID = 0x2
+MS_NODEV = 0x4
+MS_NOEXEC = 0x8
+MS_REC = 0x4000
+MS_PRIVATE = 0x40000
+PR_SET_PDEATHSIG = 1
+PR_SET_SECCOMP = 22
+SECCOMP_MODE_FILTER = 2
+
+
+class SockFprog(ctypes.Structure):
+    _fields_ = [('len', ctypes.c_ushort), ('filter', ctypes.c_void_p)]
+
+
+class CapHeader(ctypes.Structure):
+    _fields_ = [('version', ctypes.c_uint32), ('pid', ctypes.c_int)]
+
+
+class CapData(ctypes.Structure):
+    _fields_ = [('effective', ctypes.c_uint32), ('permitted', ctypes.c_uint32), ('inheritable', ctypes.c_uint32)]
+
+
+def check(result, what):
+    if result != 0:
+        error = ctypes.get_errno()
+        raise OSError(error, f'{what}: {os.strerror(error)}')
+
+
+def write_file(path, content):
+    with open(path, 'w') as file:
+        file.write(content)
+
+
+def isolate(child_filter):
+    # Siblings must not see each other, so every instance gets its own pid
+    # namespace and /tmp. The namespaces are owned by a new user namespace,
+    # unprivileged users may create those.
+    libc = ctypes.CDLL(None, use_errno=True)
+    uid, gid = os.getuid(), os.getgid()
+    check(libc.unshare(CLONE_NEWUSER | CLONE_NEWNS | CLONE_NEWPID), 'unshare')
+    write_file('/proc/self/setgroups', 'deny')
+    write_file('/proc/self/uid_map', f'{uid} {uid} 1')
+    write_file('/proc/self/gid_map', f'{gid} {gid} 1')
+    check(libc.mount(None, b'/', None, MS_REC | MS_PRIVATE, None), 'mount /')
+    check(libc.mount(b'tmpfs', b'/tmp', b'tmpfs', MS_NOSUID | MS_NODEV, b'size=64m,mode=1777'), 'mount /tmp')
+
+    # Only children enter the new pid namespace, this process stays to pass on the exit.
+    pid = os.fork()
+    if pid != 0:
+        os.close(0)
+        os.close(1)
+        _, status = os.waitpid(pid, 0)
+        if os.WIFSIGNALED(status):
+            if os.WTERMSIG(status) != signal.SIGKILL:
+                signal.signal(os.WTERMSIG(status), signal.SIG_DFL)
+            os.kill(os.getpid(), os.WTERMSIG(status))
+        os._exit(os.WEXITSTATUS(status) if os.WIFEXITED(status) else 1)
+
+    check(libc.prctl(PR_SET_PDEATHSIG, signal.SIGKILL, 0, 0, 0), 'prctl')
+    # Like the sandbox this is a convenience, /proc then only shows this instance.
+    libc.mount(b'proc', b'/proc', b'proc', MS_NOSUID | MS_NODEV | MS_NOEXEC, None)
+
+    # Nothing ran exec, so the capabilities in the new namespace are still there.
+    header = CapHeader(0x20080522, 0)
+    no_capabilities = (CapData * 2)()
+    check(libc.capset(ctypes.byref(header), no_capabilities), 'capset')
+
+    program = ctypes.create_string_buffer(child_filter, len(child_filter))
+    fprog = SockFprog(len(child_filter) // 8, ctypes.cast(program, ctypes.c_void_p))
+    check(libc.prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, ctypes.byref(fprog), 0, 0), 'seccomp')
+
+
+def run_bot(code, path, fds, inherited, cores, child_filter):
+    if cores:
+        try:
+            os.sched_setaffinity(0, cores)
+        except OSError:
+            pass
+
+    if len(fds) > 3:
+        os.write(fds[3], b'0')
+        os.close(fds[3])
+
+    os.dup2(fds[0], 0)
+    os.dup2(fds[1], 1)
+    for fd in fds[:3]:
+        os.close(fd)
+    for sock in inherited:
+        sock.close()
+
+    signal.set_wakeup_fd(-1)
+    signal.signal(signal.SIGCHLD, signal.SIG_DFL)
+    signal.signal(signal.SIGINT, signal.default_int_handler)
+
+    if child_filter is not None:
+        try:
+            isolate(child_filter)
+        except BaseException:
+            traceback.print_exc()
+            os._exit(126)
+
+    exit_code = 0
+    try:
+        exec(code, {'__name__': '__main__', '__file__': path, '__builtins__': __builtins__})
+    except SystemExit as exit_request:
+        if exit_request.code is None:
+            exit_code = 0
+        elif isinstance(exit_request.code, int):
+            exit_code = exit_request.code
+        else:
+            print(exit_request.code, file=sys.stderr)
+            exit_code = 1
+    except BaseException:
+        traceback.print_exc()
+        exit_code = 1
+
+    try:
+        sys.stdout.flush()
+    except Exception:
+        pass
+    os._exit(exit_code)
+
+
+def main():
+    if len(sys.argv) < 2:
+        print('usage: zygote.py <bot file>', file=sys.stderr)
+        return 1
+
+    path = sys.argv[1]
+    control = socket.socket(fileno=os.dup(0))
+
+    # Set by a sandbox, bot code must never run without it.
+    child_filter = os.environ.pop('ZYGOTE_CHILD_FILTER', None)
+    if child_filter is not None:
+        child_filter = bytes.fromhex(child_filter)
+
+    # Imports must resolve as if the bot was started directly.
+    sys.path[0] = os.path.dirname(os.path.abspath(path))
+    sys.argv = sys.argv[1:]
+
+    # Stdin and stdout are the control socket, nothing the bot loads may touch it.
+    null = os.open(os.devnull, os.O_RDONLY)
+    os.dup2(null, 0)
+    os.close(null)
+    os.dup2(2, 1)
+
+    code = preload(path)
+
+    wake_read, wake_write = socket.socketpair()
+    wake_write.setblocking(False)
+    signal.set_wakeup_fd(wake_write.fileno())
+    signal.signal(signal.SIGCHLD, lambda *_: None)
+
+    stopping = []
+    for stop_signal in (signal.SIGINT, signal.SIGTERM):
+        signal.signal(stop_signal, lambda *_: stopping.append(True))
+
+    selector = selectors.DefaultSelector()
+    selector.register(control, selectors.EVENT_READ)
+    selector.register(wake_read, selectors.EVENT_READ)
+
+    children = {}
+
+    def kill(pid):
+        try:
+            os.kill(pid, signal.SIGKILL)
+        except ProcessLookupError:
+            pass
+
+    def reap():
+        while children:
+            pid, status, usage = os.wait4(-1, os.WNOHANG)
+            if pid == 0:
+                return
+            lifetime = children.pop(pid, None)
+            if lifetime is None:
+                continue
+            if os.WIFEXITED(status):
+                report = f'exit {os.WEXITSTATUS(status)}'
+            else:
+                report = f'killed {os.WTERMSIG(status)}'
+            report += (f' {int(usage.ru_utime * 1000000)} {int(usage.ru_stime * 1000000)} {usage.ru_maxrss}'
+                       f' {usage.ru_nvcsw} {usage.ru_nivcsw}\n')
+            try:
+                lifetime.sendall(report.encode())
+            except OSError:
+                pass
+            if lifetime in selector.get_map():
+                selector.unregister(lifetime)
+            lifetime.close()
+
+    control.sendall(b'ready\n')
+
+    while not stopping:
+        for key, _ in selector.select():
+            if key.fileobj is control:
+                message, fds, _, _ = socket.recv_fds(control, 64, 4)
+                if not message:
+                    stopping.append(True)
+                    break
+                if len(fds) < 3:
+                    for fd in fds:
+                        os.close(fd)
+                    control.sendall(b'error\n')
+                    continue
+
+                # "spawn" or "spawn <core>"
+                cores = [int(core) for core in message.split()[1:]]
+
+                pid = os.fork()
+                if pid == 0:
+                    run_bot(code, path, fds, [control, wake_read, wake_write, *children.values()], cores, child_filter)
+
+                for fd in fds[:2] + fds[3:]:
+                    os.close(fd)
+                lifetime = socket.socket(fileno=fds[2])
+                children[pid] = lifetime
+                selector.register(lifetime, selectors.EVENT_READ, pid)
+                control.sendall(b'ok\n')
+            elif key.fileobj is wake_read:
+                wake_read.recv(512)
+                reap()
+            else:
+                # The server gave up on this instance, its exit is still reported.
+                if not key.fileobj.recv(64):
+                    selector.unregister(key.fileobj)
+                    kill(key.data)
+
+    for pid in children:
+        kill(pid)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -6,7 +6,16 @@
 namespace Elevated {
 
 BuildingState::BuildingState(BuildingBlueprint blueprint, EventListener* event_listener)
+    : BuildingState(std::make_shared<BuildingBlueprint const>(std::move(blueprint)), event_listener)
 {
+}
+
+BuildingState::BuildingState(std::shared_ptr<BuildingBlueprint const> shared_blueprint, EventListener* event_listener)
+    : m_blueprint(std::move(shared_blueprint))
+{
+    ASSERT(m_blueprint);
+    auto& blueprint = *m_blueprint;
+
     std::set<Height> floors;
 
     std::vector<Height> start_floors;
@@ -19,21 +28,62 @@ BuildingState::BuildingState(BuildingBlueprint blueprint, EventListener* event_l
 
     m_floors.reserve(floors.size());
     for (auto floor : floors)
-        m_floors.insert({floor, {}});
+        m_floors.insert({floor, {}}).first->second.reserve_groups(blueprint.reachable_per_group.size());
 
 
     ElevatorID id {0};
 
+    m_elevators_per_group.resize(blueprint.reachable_per_group.size());
     for (auto& elevator : blueprint.elevators) {
         ASSERT(elevator.group < blueprint.reachable_per_group.size());
+        m_elevators_per_group[elevator.group].push_back(id);
         m_elevators.emplace_back(id++, elevator, start_floors[elevator.group]);
     }
+    m_kinematics.assign(m_elevators);
 
-    m_group_reachable = std::move(blueprint.reachable_per_group);
     m_event_listener = event_listener;
     ASSERT(m_event_listener);
 }
 
+void BuildingState::run_groups_in_parallel(std::shared_ptr<util::WorkerPool> workers)
+{
+    m_workers = std::move(workers);
+    if (m_workers)
+        m_elevator_events.resize(m_elevators.size());
+    else
+        m_elevator_events.clear();
+}
+
+std::optional<BuildingState::UpdateResult> BuildingState::update_elevator(ElevatorState& elevator, Time steps, EventListener& listener)
+{
+    ASSERT(elevator.current_state() != ElevatorState::State::DoorsOpen);
+    Height initial_height = elevator.height();
+    auto result = elevator.update(steps);
+    switch (result) {
+    case ElevatorState::ElevatorUpdateResult::Nothing:
+        if (auto new_height = elevator.height(); new_height != initial_height)
+            listener.on_elevator_moved(m_current_time, distance_between(initial_height, new_height), initial_height, elevator);
+        else
+            listener.on_elevator_stopped(m_current_time, steps, elevator);
+        break;
+    case ElevatorState::ElevatorUpdateResult::DoorsOpened: {
+        ASSERT(m_floors.contains(elevator.height()));
+        if (auto new_height = elevator.height(); new_height != initial_height)
+            listener.on_elevator_moved(m_current_time, distance_between(initial_height, new_height), initial_height, elevator);
+
+        listener.on_elevator_opened_doors(m_current_time, elevator);
+        return UpdateResult{UpdateResult::Type::DoorsOpened, elevator.id};
+    }
+    case ElevatorState::ElevatorUpdateResult::DoorsClosed:
+        ASSERT(initial_height == elevator.height());
+        ASSERT(m_floors.contains(elevator.height()));
+        listener.on_elevator_closed_doors(m_current_time, elevator);
+        return UpdateResult{UpdateResult::Type::DoorsClosed, elevator.id};
+    }
+
+    return {};
+}
+
 std::vector<BuildingState::UpdateResult> BuildingState::update_until(Time target_time)
 {
     ASSERT(m_event_listener);
@@ -49,70 +99,104 @@ std::vector<BuildingState::UpdateResult> BuildingState::update_until(Time target
 
     std::vector<UpdateResult> elevators_closed_doors;
 
-    for (auto& elevator : m_elevators) {
-        ASSERT(elevator.current_state() != ElevatorState::State::DoorsOpen);
-        Height initial_height = elevator.height();
-        auto result = elevator.update(steps);
-        switch (result) {
-        case ElevatorState::ElevatorUpdateResult::Nothing:
-            if (auto new_height = elevator.height(); new_height != initial_height)
-                m_event_listener->on_elevator_moved(m_current_time, distance_between(initial_height, new_height), initial_height, elevator);
-            else
-                m_event_listener->on_elevator_stopped(m_current_time, steps, elevator);
-            break;
-        case ElevatorState::ElevatorUpdateResult::DoorsOpened: {
-            ASSERT(m_floors.contains(elevator.height()));
-            if (auto new_height = elevator.height(); new_height != initial_height)
-                m_event_listener->on_elevator_moved(m_current_time, distance_between(initial_height, new_height), initial_height, elevator);
-
-            m_event_listener->on_elevator_opened_doors(m_current_time, elevator);
-            elevators_closed_doors.push_back({UpdateResult::Type::DoorsOpened, elevator.id});
-            break;
+    if (!m_workers) {
+        // Elevators which are just travelling are moved all at once, only the rest need the full update.
+        m_kinematics.advance_travelling(steps, m_moved_elevators);
+        for (auto& elevator : m_elevators) {
+            if (m_moved_elevators[elevator.id]) {
+                Height initial_height = elevator.height();
+                m_kinematics.apply_travel(elevator);
+                m_event_listener->on_elevator_moved(m_current_time, distance_between(initial_height, elevator.height()), initial_height, elevator);
+                continue;
+            }
+            if (auto result = update_elevator(elevator, steps, *m_event_listener); result.has_value())
+                elevators_closed_doors.push_back(*result);
+            m_kinematics.sync(elevator);
         }
-        case ElevatorState::ElevatorUpdateResult::DoorsClosed:
-            ASSERT(initial_height == elevator.height());
-            ASSERT(m_floors.contains(elevator.height()));
-            m_event_listener->on_elevator_closed_doors(m_current_time, elevator);
-            elevators_closed_doors.push_back({UpdateResult::Type::DoorsClosed, elevator.id});
-            break;
+        return elevators_closed_doors;
+    }
+
+    std::vector<std::optional<UpdateResult>> results(m_elevators.size());
+    m_workers->run(m_elevators_per_group.size(), [&](size_t group) {
+        for (auto id : m_elevators_per_group[group]) {
+            results[id] = update_elevator(m_elevators[id], steps, m_elevator_events[id]);
+            m_kinematics.sync(m_elevators[id]);
         }
+    });
+
+    for (ElevatorID id = 0; id < m_elevators.size(); ++id) {
+        m_elevator_events[id].replay_into(*m_event_listener);
+        if (results[id].has_value())
+            elevators_closed_doors.push_back(*results[id]);
     }
 
     return elevators_closed_doors;
 }
 
-void BuildingState::transfer_passengers(ElevatorID id, ElevatorState::PassengerCallback const& callback)
+void BuildingState::transfer_elevator(ElevatorState& elevator, ElevatorState::PassengerCallback const& callback, EventListener& listener)
 {
-    ASSERT(id < m_elevators.size());
-    auto& elevator = m_elevators[id];
     ASSERT(elevator.current_state() == ElevatorState::State::DoorsOpen);
     if (elevator.current_state() != ElevatorState::State::DoorsOpen)
         return;
 
-    auto& floor_stopped_at = m_floors[elevator.height()];
-    auto transferred = elevator.transfer_passengers(floor_stopped_at, callback);
+    auto floor_or_end = m_floors.find(elevator.height());
+    ASSERT(floor_or_end != m_floors.end());
+    auto transferred = elevator.transfer_passengers(floor_or_end->second, callback);
+    m_kinematics.sync(elevator);
     for (auto& arrived_passenger_id : transferred.dropped_off_passengers)
-        m_event_listener->on_passenger_leave_elevator(m_current_time, arrived_passenger_id, elevator.height());
+        listener.on_passenger_leave_elevator(m_current_time, arrived_passenger_id, elevator.height());
 
     for (auto& picked_up_passenger : transferred.picked_up_passengers)
-        m_event_listener->on_passenger_enter_elevator(m_current_time, picked_up_passenger, elevator.id);
+        listener.on_passenger_enter_elevator(m_current_time, picked_up_passenger, elevator.id);
 }
 
-std::optional<size_t> BuildingState::add_request(PassengerBlueprint passenger)
+void BuildingState::transfer_passengers(ElevatorID id, ElevatorState::PassengerCallback const& callback)
+{
+    ASSERT(id < m_elevators.size());
+    transfer_elevator(m_elevators[id], callback, *m_event_listener);
+}
+
+void BuildingState::transfer_passengers(std::vector<Transfer> const& transfers)
+{
+    if (!m_workers || transfers.size() < 2) {
+        for (auto& transfer : transfers)
+            transfer_passengers(transfer.id, transfer.callback);
+        return;
+    }
+
+    // Keep the given order within a group, elevators at the same floor compete for the same passengers.
+    std::vector<std::vector<Transfer const*>> transfers_per_group(m_elevators_per_group.size());
+    for (auto& transfer : transfers) {
+        ASSERT(transfer.id < m_elevators.size());
+        transfers_per_group[m_elevators[transfer.id].group_id].push_back(&transfer);
+    }
+
+    m_workers->run(transfers_per_group.size(), [&](size_t group) {
+        for (auto* transfer : transfers_per_group[group])
+            transfer_elevator(m_elevators[transfer->id], transfer->callback, m_elevator_events[transfer->id]);
+    });
+
+    for (auto& transfer : transfers)
+        m_elevator_events[transfer.id].replay_into(*m_event_listener);
+}
+
+std::optional<FloorQueue::Index> BuildingState::add_request(PassengerBlueprint passenger)
 {
     ASSERT(m_event_listener);
     ASSERT(m_floors.contains(passenger.from));
     ASSERT(m_floors.contains(passenger.to));
-    ASSERT(passenger.group < m_group_reachable.size());
-    ASSERT(m_group_reachable[passenger.group].contains(passenger.from));
+    auto& group_reachable = m_blueprint->reachable_per_group;
+    ASSERT(passenger.group < group_reachable.size());
+    ASSERT(group_reachable[passenger.group].contains(passenger.from));
 
-    if (passenger.group >= m_group_reachable.size() || !m_group_reachable[passenger.group].contains(passenger.from))
+    if (passenger.group >= group_reachable.size() || !group_reachable[passenger.group].contains(passenger.from))
         return {};
 
     ASSERT(m_next_passenger_id != 0);
-    auto& new_passenger = m_floors[passenger.from].emplace_back(m_next_passenger_id++, passenger);
-    m_event_listener->on_request_created(m_current_time + 1, new_passenger);
-    return m_floors[passenger.from].size() - 1u;
+    auto& queue = m_floors[passenger.from];
+    auto index = queue.add(Passenger { m_next_passenger_id++, passenger });
+    m_event_listener->on_request_created(m_current_time + 1, queue.at(index));
+    return index;
 }
 
 bool BuildingState::send_elevator(ElevatorID id, Height target)
@@ -125,33 +209,26 @@ bool BuildingState::send_elevator(ElevatorID id, Height target)
 
     auto& elevator = m_elevators[id];
 
-    if (!m_group_reachable[elevator.group_id].contains(target))
+    if (!m_blueprint->reachable_per_group[elevator.group_id].contains(target))
         return false;
 
     m_event_listener->on_elevator_set_target(m_current_time, target, elevator);
     elevator.set_target(target);
+    m_kinematics.sync(elevator);
 
     return true;
 }
 
 std::optional<Time> BuildingState::next_event_at() const
 {
-    std::optional<Time> first_time;
-    for (auto& elevator : m_elevators) {
-        auto time_or_none = elevator.time_until_next_event();
-        if (!time_or_none.has_value())
-            continue;
-
-        Time next_value = m_current_time + time_or_none.value();
-
-        if (!first_time.has_value() || first_time.value() > next_value)
-            first_time = next_value;
-    }
+    auto time_until_next_event = m_kinematics.min_time_until_next_event();
+    if (!time_until_next_event.has_value())
+        return {};
 
-    return first_time;
+    return m_current_time + time_until_next_event.value();
 }
 
-std::vector<Passenger> const &BuildingState::passengers_at(Height height) const {
+FloorQueue const& BuildingState::passengers_at(Height height) const {
     ASSERT(m_floors.contains(height));
     return m_floors.find(height)->second;
 }
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "Elevator.h"
+#include "ElevatorKinematics.h"
 #include "Types.h"
+#include "stats/EventBuffer.h"
 #include "stats/Listener.h"
 #include "generation/Generation.h"
+#include "../../util/WorkerPool.h"
 #include <optional>
 #include <unordered_map>
 #include <vector>
@@ -13,12 +16,14 @@ namespace Elevated {
 class BuildingState {
 public:
     explicit BuildingState(BuildingBlueprint blueprint, EventListener* event_listener);
+    // The blueprint is only read so it can be shared between many buildings.
+    BuildingState(std::shared_ptr<BuildingBlueprint const> blueprint, EventListener* event_listener);
 
     BuildingState() = default;
 
     [[nodiscard]] std::optional<Time> next_event_at() const;
 
-    std::optional<size_t> add_request(PassengerBlueprint passenger);
+    std::optional<FloorQueue::Index> add_request(PassengerBlueprint passenger);
     bool send_elevator(ElevatorID, Height target);
 
     struct UpdateResult {
@@ -33,7 +38,25 @@ public:
     std::vector<UpdateResult> update_until(Time target_time);
     void transfer_passengers(ElevatorID id, ElevatorState::PassengerCallback const& callback = [](Passenger const&){ return true; });
 
-    [[nodiscard]] std::vector<Passenger> const& passengers_at(Height) const;
+    struct Transfer {
+        ElevatorID id;
+        ElevatorState::PassengerCallback callback = [](Passenger const&) { return true; };
+    };
+    // Transfers for multiple elevators, in parallel mode the groups are handled concurrently
+    // so callbacks must be safe to call from another thread. The callbacks are decided before
+    // any of the transfers, so they cannot depend on the state after the earlier ones.
+    void transfer_passengers(std::vector<Transfer> const& transfers);
+
+    // Groups only share the floor queues of which they only touch their own part,
+    // so with workers the elevators of each group are updated on a separate thread.
+    // Events are buffered per elevator and given to the listener in elevator order,
+    // which gives exactly the same events (and order) as the sequential mode for the same
+    // updates and transfers. Simulation only uses this for update_until, the transfers
+    // happen one elevator at a time (see Simulation::tick).
+    void run_groups_in_parallel(std::shared_ptr<util::WorkerPool> workers);
+    [[nodiscard]] bool runs_groups_in_parallel() const { return m_workers != nullptr; }
+
+    [[nodiscard]] FloorQueue const& passengers_at(Height) const;
     [[nodiscard]] ElevatorState const& elevator(ElevatorID) const;
     [[nodiscard]] size_t num_elevators() const { return m_elevators.size(); }
     [[nodiscard]] Time current_time() const { return m_current_time; }
@@ -43,9 +66,18 @@ public:
     std::vector<Height> all_floors() const;
 
 private:
-    std::unordered_map<Height, std::vector<Passenger>> m_floors;
+    std::optional<UpdateResult> update_elevator(ElevatorState& elevator, Time steps, EventListener& listener);
+    void transfer_elevator(ElevatorState& elevator, ElevatorState::PassengerCallback const& callback, EventListener& listener);
+
+    std::unordered_map<Height, FloorQueue> m_floors;
     std::vector<ElevatorState> m_elevators;
-    std::vector<std::unordered_set<Height>> m_group_reachable;
+    ElevatorKinematics m_kinematics;
+    std::vector<uint8_t> m_moved_elevators;
+    std::shared_ptr<BuildingBlueprint const> m_blueprint;
+
+    std::shared_ptr<util::WorkerPool> m_workers;
+    std::vector<std::vector<ElevatorID>> m_elevators_per_group;
+    std::vector<EventBuffer> m_elevator_events;
 
     Time m_current_time{0};
     EventListener* m_event_listener{nullptr};
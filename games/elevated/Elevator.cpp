@@ -2,10 +2,120 @@
 #include "../../util/Assertions.h"
 #include <algorithm>
 #include <iterator>
-#include <numeric>
 
 namespace Elevated {
 
+FloorQueue::FloorQueue(std::initializer_list<Passenger> passengers)
+{
+    for (auto& passenger : passengers)
+        add(passenger);
+}
+
+FloorQueue::Index FloorQueue::add(Passenger passenger)
+{
+    Index index { passenger.group, passenger.direction(), 0 };
+    auto& queue = queue_for(index.group, index.direction);
+    ASSERT(queue.empty() || queue.back().id < passenger.id);
+
+    index.index = queue.size();
+    queue.push_back(passenger);
+    return index;
+}
+
+void FloorQueue::reserve_groups(GroupID groups)
+{
+    if (groups > m_queues_per_group.size())
+        m_queues_per_group.resize(groups);
+}
+
+size_t FloorQueue::size() const
+{
+    size_t total = 0;
+    for (auto& queues : m_queues_per_group)
+        total += queues[0].size() + queues[1].size();
+    return total;
+}
+
+bool FloorQueue::empty() const
+{
+    return std::all_of(m_queues_per_group.begin(), m_queues_per_group.end(), [](DirectionQueues const& queues) {
+        return queues[0].empty() && queues[1].empty();
+    });
+}
+
+Passenger const& FloorQueue::at(Index index) const
+{
+    auto& queue = waiting(index.group, index.direction);
+    ASSERT(index.index < queue.size());
+    return queue[index.index];
+}
+
+std::vector<Passenger> const& FloorQueue::waiting(GroupID group, Direction direction) const
+{
+    static std::vector<Passenger> const no_passengers;
+    if (group >= m_queues_per_group.size())
+        return no_passengers;
+
+    return m_queues_per_group[group][static_cast<size_t>(direction)];
+}
+
+std::vector<Passenger>& FloorQueue::queue_for(GroupID group, Direction direction)
+{
+    if (group >= m_queues_per_group.size())
+        m_queues_per_group.resize(group + 1);
+
+    return m_queues_per_group[group][static_cast<size_t>(direction)];
+}
+
+std::vector<Passenger> FloorQueue::in_arrival_order() const
+{
+    std::vector<Passenger> passengers;
+    passengers.reserve(size());
+    for (auto& queues : m_queues_per_group) {
+        for (auto& queue : queues)
+            passengers.insert(passengers.end(), queue.begin(), queue.end());
+    }
+
+    std::sort(passengers.begin(), passengers.end(), [](Passenger const& lhs, Passenger const& rhs) {
+        return lhs.id < rhs.id;
+    });
+    return passengers;
+}
+
+std::vector<Height> ElevatorState::TravellingPassengers::destinations() const
+{
+    std::vector<Height> heights;
+    heights.reserve(m_destinations.size());
+    for (auto& [destination, _] : m_destinations)
+        heights.push_back(destination);
+
+    return heights;
+}
+
+void ElevatorState::TravellingPassengers::add(TravellingPassenger passenger)
+{
+    m_destinations[passenger.to].push_back(passenger);
+    ++m_size;
+    m_filled_capacity += passenger.capacity;
+}
+
+std::vector<ElevatorState::TravellingPassenger> ElevatorState::TravellingPassengers::remove_all_to(Height destination)
+{
+    auto it_or_end = m_destinations.find(destination);
+    if (it_or_end == m_destinations.end())
+        return {};
+
+    auto arrived = std::move(it_or_end->second);
+    m_destinations.erase(it_or_end);
+
+    ASSERT(m_size >= arrived.size());
+    m_size -= arrived.size();
+    for (auto& passenger : arrived)
+        m_filled_capacity -= passenger.capacity;
+
+    return arrived;
+}
+
 std::optional<Time> ElevatorState::time_until_next_event() const
 {
     if (m_state == State::Stopped || m_state == State::DoorsOpen)
@@ -113,56 +223,68 @@ void ElevatorState::set_target(Height floor)
 
 Capacity ElevatorState::dropoff_passengers(TransferredPassengers& transferred)
 {
-    auto not_at_arrival = [height= m_height](TravellingPassenger const& passenger) {
-        return passenger.to != height;
-    };
-
-    auto reached_destination = std::partition(m_passengers.begin(), m_passengers.end(), not_at_arrival);
+    auto arrived = m_passengers.remove_all_to(m_height);
 
-    transferred.dropped_off_passengers.reserve(std::distance(reached_destination, m_passengers.end()));
-    std::transform(reached_destination, m_passengers.end(), std::back_inserter(transferred.dropped_off_passengers), [](TravellingPassenger const& passenger) {
+    transferred.dropped_off_passengers.reserve(arrived.size());
+    std::transform(arrived.begin(), arrived.end(), std::back_inserter(transferred.dropped_off_passengers), [](TravellingPassenger const& passenger) {
         return passenger.id;
     });
 
-    m_passengers.erase(reached_destination, m_passengers.end());
     return filled_capacity();
 }
 
-Capacity ElevatorState::filled_capacity() const
-{
-    return std::accumulate(m_passengers.begin(), m_passengers.end(), Capacity {0},
-        [](Capacity accumulator, TravellingPassenger const& passenger) {
-            return accumulator + passenger.capacity;
-        });
-}
-
-void ElevatorState::pickup_passengers(std::vector<Passenger>& waiting_passengers, TransferredPassengers& transferred, Capacity capacity_left, std::function<bool(Passenger const&)> const& callback)
+void ElevatorState::pickup_passengers(FloorQueue& waiting_passengers, TransferredPassengers& transferred, Capacity capacity_left, std::function<bool(Passenger const&)> const& callback)
 {
-    auto in_group = [&](Passenger const& passenger) {
-        return passenger.group == group_id;
-    };
-
-    auto end = waiting_passengers.end();
-    auto start = std::find_if(waiting_passengers.begin(), end, in_group);
+    // Passengers of other groups are never touched, but we do have to visit both
+    // directions in arrival order to keep the first come first serve behavior.
+    auto& up = waiting_passengers.queue_for(group_id, Direction::Up);
+    auto& down = waiting_passengers.queue_for(group_id, Direction::Down);
 
-    if (start == end)
+    if (up.empty() && down.empty())
         return;
 
-    for (auto it = start; it != end; ++it) {
-        if (in_group(*it) && it->capacity <= capacity_left && callback(*it)) {
-            transferred.picked_up_passengers.emplace_back(*it);
-            m_passengers.push_back({it->id, it->to, it->capacity});
-            capacity_left -= it->capacity;
+    struct Cursor {
+        std::vector<Passenger>& queue;
+        size_t read { 0 };
+        size_t write { 0 };
+
+        bool done() const { return read == queue.size(); }
+        bool has_capacity_free_left() const
+        {
+            return std::any_of(std::next(queue.begin(), read), queue.end(), [](Passenger const& passenger) {
+                return passenger.capacity == 0;
+            });
+        }
+    };
+
+    Cursor up_cursor { up };
+    Cursor down_cursor { down };
+
+    while (!up_cursor.done() || !down_cursor.done()) {
+        bool take_up = down_cursor.done() || (!up_cursor.done() && up[up_cursor.read].id < down[down_cursor.read].id);
+        auto& cursor = take_up ? up_cursor : down_cursor;
+        auto& passenger = cursor.queue[cursor.read++];
+
+        if (passenger.capacity <= capacity_left && callback(passenger)) {
+            transferred.picked_up_passengers.emplace_back(passenger);
+            m_passengers.add({passenger.id, passenger.to, passenger.capacity});
+            capacity_left -= passenger.capacity;
+            // Once full only passengers without any capacity can still get in.
+            if (passenger.capacity > 0 && capacity_left == 0 && !up_cursor.has_capacity_free_left() && !down_cursor.has_capacity_free_left())
+                break;
         } else {
-            *start = *it;
-            ++start;
+            if (cursor.write != cursor.read - 1)
+                cursor.queue[cursor.write] = passenger;
+            ++cursor.write;
         }
     }
 
-    waiting_passengers.erase(start, end);
+    // Closes the gap left by the picked up passengers, anyone not visited stays behind it.
+    up.erase(std::next(up.begin(), up_cursor.write), std::next(up.begin(), up_cursor.read));
+    down.erase(std::next(down.begin(), down_cursor.write), std::next(down.begin(), down_cursor.read));
 }
 
-ElevatorState::TransferredPassengers ElevatorState::transfer_passengers(std::vector<Passenger>& waiting_passengers, std::function<bool(Passenger const&)> const& callback)
+ElevatorState::TransferredPassengers ElevatorState::transfer_passengers(FloorQueue& waiting_passengers, std::function<bool(Passenger const&)> const& callback)
 {
     ASSERT(m_state == State::DoorsOpen);
     m_state = State::DoorsClosing;
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <iterator>
+#include <map>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
@@ -30,10 +33,48 @@ struct Passenger {
     bool operator==(Passenger const& rhs) const {
         return id == rhs.id && from == rhs.from && to == rhs.to && group == rhs.group && capacity == rhs.capacity;
     }
+
+    [[nodiscard]] Direction direction() const { return direction_between(from, to); }
 };
 
+// The passengers waiting on a single floor, split per group and direction.
+// Within each queue passengers are kept in the order they were added which
+// must be in increasing id order (which the building guarantees).
+// Elevators of different groups only touch their own queues, so they can pick up
+// passengers concurrently once the queues for all groups exist.
+class FloorQueue {
+public:
+    struct Index {
+        GroupID group { 0 };
+        Direction direction { Direction::Up };
+        size_t index { 0 };
+    };
+
+    FloorQueue() = default;
+    FloorQueue(std::initializer_list<Passenger> passengers);
+
+    Index add(Passenger passenger);
+    void reserve_groups(GroupID groups);
+
+    [[nodiscard]] Passenger const& at(Index index) const;
+    [[nodiscard]] std::vector<Passenger> const& waiting(GroupID group, Direction direction) const;
+    [[nodiscard]] bool has_waiting(GroupID group, Direction direction) const { return !waiting(group, direction).empty(); }
+
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] bool empty() const;
+
+    [[nodiscard]] std::vector<Passenger> in_arrival_order() const;
 
-    class ElevatorState {
+private:
+    friend class ElevatorState;
+
+    std::vector<Passenger>& queue_for(GroupID group, Direction direction);
+
+    using DirectionQueues = std::array<std::vector<Passenger>, 2>;
+    std::vector<DirectionQueues> m_queues_per_group;
+};
+
+class ElevatorState {
 public:
     struct TravellingPassenger {
         PassengerID id;
@@ -41,6 +82,69 @@ public:
         Capacity capacity;
     };
 
+    // The passengers inside an elevator grouped by their destination, iterates
+    // from the lowest destination to the highest.
+    class TravellingPassengers {
+        using Destinations = std::map<Height, std::vector<TravellingPassenger>>;
+    public:
+        class Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = TravellingPassenger;
+            using difference_type = std::ptrdiff_t;
+            using pointer = TravellingPassenger const*;
+            using reference = TravellingPassenger const&;
+
+            Iterator() = default;
+            explicit Iterator(Destinations::const_iterator destination)
+                : m_destination(destination)
+            {
+            }
+
+            reference operator*() const { return m_destination->second[m_index]; }
+            pointer operator->() const { return &m_destination->second[m_index]; }
+
+            Iterator& operator++()
+            {
+                if (++m_index == m_destination->second.size()) {
+                    ++m_destination;
+                    m_index = 0;
+                }
+                return *this;
+            }
+
+            Iterator operator++(int)
+            {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+
+            bool operator==(Iterator const& other) const { return m_destination == other.m_destination && m_index == other.m_index; }
+
+        private:
+            Destinations::const_iterator m_destination;
+            size_t m_index { 0 };
+        };
+
+        [[nodiscard]] Iterator begin() const { return Iterator { m_destinations.begin() }; }
+        [[nodiscard]] Iterator end() const { return Iterator { m_destinations.end() }; }
+        [[nodiscard]] size_t size() const { return m_size; }
+        [[nodiscard]] bool empty() const { return m_size == 0; }
+        [[nodiscard]] Capacity filled_capacity() const { return m_filled_capacity; }
+
+        [[nodiscard]] std::vector<Height> destinations() const;
+
+        void add(TravellingPassenger passenger);
+        std::vector<TravellingPassenger> remove_all_to(Height destination);
+
+    private:
+        // Invariant: never contains an empty vector, this keeps iteration simple.
+        Destinations m_destinations;
+        size_t m_size { 0 };
+        Capacity m_filled_capacity { 0 };
+    };
+
     enum class State {
         Stopped,
         Travelling,
@@ -66,7 +170,7 @@ public:
     ElevatorUpdateResult update(Time steps);
     void set_target(Height floor);
 
-    [[nodiscard]] std::vector<TravellingPassenger> const& passengers() const {
+    [[nodiscard]] TravellingPassengers const& passengers() const {
         return m_passengers;
     }
 
@@ -84,7 +188,7 @@ public:
     [[nodiscard]] State current_state() const { return m_state; }
     [[nodiscard]] Height target_height() const { return m_target_height; }
     [[nodiscard]] Height height() const { return m_height; }
-    [[nodiscard]] Capacity filled_capacity() const;
+    [[nodiscard]] Capacity filled_capacity() const { return m_passengers.filled_capacity(); }
 
     struct TransferredPassengers {
         std::vector<ElevatorID> dropped_off_passengers;
@@ -93,13 +197,16 @@ public:
 
     using PassengerCallback = std::function<bool(Passenger const&)>;
 
-    TransferredPassengers transfer_passengers(std::vector<Passenger>& waiting_passengers, PassengerCallback const& callback = [](auto&) { return true; });
+    TransferredPassengers transfer_passengers(FloorQueue& waiting_passengers, PassengerCallback const& callback = [](auto&) { return true; });
 
 private:
+    friend class ElevatorKinematics;
+    friend class AsyncEventPipeline;
+
     Height m_height{0};
     Height m_target_height{0};
     State m_state = State::Stopped;
-    std::vector<TravellingPassenger> m_passengers;
+    TravellingPassengers m_passengers;
 
     Time m_time_until_next_state { 0 };
 
@@ -111,7 +218,7 @@ private:
         return speed * steps;
     }
 
-    void pickup_passengers(std::vector<Passenger>& waiting_passengers, TransferredPassengers&, Capacity capacity_left, PassengerCallback const& callback);
+    void pickup_passengers(FloorQueue& waiting_passengers, TransferredPassengers&, Capacity capacity_left, PassengerCallback const& callback);
     Capacity dropoff_passengers(TransferredPassengers&);
     void move_to_target(Height distance);
 };
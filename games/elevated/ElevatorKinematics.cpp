@@ -0,0 +1,160 @@
+#include "ElevatorKinematics.h"
+#include "../../util/Assertions.h"
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define ELEVATED_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+namespace Elevated {
+
+#ifdef ELEVATED_AVX2_KERNEL
+
+namespace {
+
+__attribute__((target("avx2"))) inline __m256i unsigned_greater(__m256i lhs, __m256i rhs)
+{
+    auto const sign = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+    return _mm256_cmpgt_epi32(_mm256_xor_si256(lhs, sign), _mm256_xor_si256(rhs, sign));
+}
+
+__attribute__((target("avx2"))) size_t advance_travelling_avx2(size_t count, Time steps, Height* heights, Height const* targets, Height const* speeds,
+    uint32_t const* travelling, Time* times_until_next_state, Time* times_until_next_event, uint8_t* moved)
+{
+    auto const steps_vector = _mm256_set1_epi32(static_cast<int>(steps));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        auto height = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(heights + i));
+        auto target = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(targets + i));
+        auto speed = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(speeds + i));
+        auto is_travelling = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(travelling + i));
+        auto next_state = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(times_until_next_state + i));
+        auto next_event = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(times_until_next_event + i));
+
+        auto moves = _mm256_and_si256(is_travelling, unsigned_greater(next_state, steps_vector));
+        auto distance = _mm256_mullo_epi32(speed, steps_vector);
+        auto going_up = unsigned_greater(target, height);
+        auto new_height = _mm256_blendv_epi8(_mm256_sub_epi32(height, distance), _mm256_add_epi32(height, distance), going_up);
+        auto moved_steps = _mm256_and_si256(moves, steps_vector);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(heights + i), _mm256_blendv_epi8(height, new_height, moves));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(times_until_next_state + i), _mm256_sub_epi32(next_state, moved_steps));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(times_until_next_event + i), _mm256_sub_epi32(next_event, moved_steps));
+
+        auto mask = _mm256_movemask_ps(_mm256_castsi256_ps(moves));
+        for (size_t lane = 0; lane < 8; ++lane)
+            moved[i + lane] = (mask >> lane) & 1;
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) std::pair<Time, size_t> min_time_avx2(size_t count, Time const* times)
+{
+    auto minimum = _mm256_set1_epi32(-1);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        minimum = _mm256_min_epu32(minimum, _mm256_loadu_si256(reinterpret_cast<__m256i const*>(times + i)));
+
+    alignas(32) Time lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), minimum);
+    return { *std::min_element(std::begin(lanes), std::end(lanes)), i };
+}
+
+}
+
+bool ElevatorKinematics::has_vector_kernel()
+{
+    static bool const supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+#else
+
+bool ElevatorKinematics::has_vector_kernel()
+{
+    return false;
+}
+
+#endif
+
+void ElevatorKinematics::assign(std::vector<ElevatorState> const& elevators)
+{
+    m_height.resize(elevators.size());
+    m_target.resize(elevators.size());
+    m_speed.resize(elevators.size());
+    m_travelling.resize(elevators.size());
+    m_time_until_next_state.resize(elevators.size());
+    m_time_until_next_event.resize(elevators.size());
+
+    for (auto& elevator : elevators)
+        sync(elevator);
+}
+
+void ElevatorKinematics::sync(ElevatorState const& elevator)
+{
+    ASSERT(elevator.id < size());
+    auto id = elevator.id;
+    m_height[id] = elevator.height();
+    m_target[id] = elevator.target_height();
+    m_speed[id] = elevator.speed;
+    m_travelling[id] = elevator.current_state() == ElevatorState::State::Travelling ? static_cast<uint32_t>(-1) : 0u;
+    m_time_until_next_state[id] = elevator.m_time_until_next_state;
+    m_time_until_next_event[id] = elevator.time_until_next_event().value_or(no_event);
+}
+
+void ElevatorKinematics::advance_travelling(Time steps, std::vector<uint8_t>& moved, Kernel kernel)
+{
+    size_t count = size();
+    moved.resize(count);
+
+    size_t start = 0;
+#ifdef ELEVATED_AVX2_KERNEL
+    if (kernel == Kernel::Best && has_vector_kernel())
+        start = advance_travelling_avx2(count, steps, m_height.data(), m_target.data(), m_speed.data(), m_travelling.data(),
+            m_time_until_next_state.data(), m_time_until_next_event.data(), moved.data());
+#else
+    (void)kernel;
+#endif
+
+    // Written without branches so compilers can still vectorize this when there is no explicit kernel.
+    for (size_t i = start; i < count; ++i) {
+        uint32_t moves = m_travelling[i] & (0u - static_cast<uint32_t>(steps < m_time_until_next_state[i]));
+        Height distance = m_speed[i] * steps;
+        Height new_height = m_target[i] > m_height[i] ? m_height[i] + distance : m_height[i] - distance;
+        m_height[i] = (new_height & moves) | (m_height[i] & ~moves);
+        m_time_until_next_state[i] -= steps & moves;
+        m_time_until_next_event[i] -= steps & moves;
+        moved[i] = moves & 1u;
+    }
+}
+
+void ElevatorKinematics::apply_travel(ElevatorState& elevator) const
+{
+    ASSERT(elevator.id < size());
+    ASSERT(elevator.current_state() == ElevatorState::State::Travelling);
+    ASSERT(distance_between(elevator.m_height, m_target[elevator.id]) > distance_between(elevator.m_height, m_height[elevator.id]));
+    elevator.m_height = m_height[elevator.id];
+    elevator.m_time_until_next_state = m_time_until_next_state[elevator.id];
+}
+
+std::optional<Time> ElevatorKinematics::min_time_until_next_event(Kernel kernel) const
+{
+    Time minimum = no_event;
+    size_t start = 0;
+#ifdef ELEVATED_AVX2_KERNEL
+    if (kernel == Kernel::Best && has_vector_kernel())
+        std::tie(minimum, start) = min_time_avx2(size(), m_time_until_next_event.data());
+#else
+    (void)kernel;
+#endif
+
+    for (size_t i = start; i < size(); ++i)
+        minimum = std::min(minimum, m_time_until_next_event[i]);
+
+    if (minimum == no_event)
+        return {};
+    return minimum;
+}
+
+}
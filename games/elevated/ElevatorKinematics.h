@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Elevator.h"
+#include "Types.h"
+#include <optional>
+#include <vector>
+
+namespace Elevated {
+
+// Structure of arrays copy of the moving parts of all elevators in a building.
+// The elevators themselves stay the source of truth, after anything other than
+// advance_travelling changes an elevator it has to be synced again.
+// This allows moving all travelling elevators and finding the next event in one
+// (vectorized) pass instead of going through each elevator separately.
+class ElevatorKinematics {
+public:
+    enum class Kernel {
+        Scalar,
+        Best,
+    };
+
+    static bool has_vector_kernel();
+
+    void assign(std::vector<ElevatorState> const& elevators);
+    void sync(ElevatorState const& elevator);
+
+    // Moves all travelling elevators which do not arrive within the steps, moved is set to 1
+    // for those and apply_travel must be used to write their new position back to the elevator.
+    // All other elevators are untouched and should still be updated normally.
+    void advance_travelling(Time steps, std::vector<uint8_t>& moved, Kernel kernel = Kernel::Best);
+    void apply_travel(ElevatorState& elevator) const;
+
+    [[nodiscard]] std::optional<Time> min_time_until_next_event(Kernel kernel = Kernel::Best) const;
+
+    [[nodiscard]] size_t size() const { return m_height.size(); }
+
+private:
+    constexpr static Time no_event = static_cast<Time>(-1);
+
+    std::vector<Height> m_height;
+    std::vector<Height> m_target;
+    std::vector<Height> m_speed;
+    std::vector<uint32_t> m_travelling;
+    std::vector<Time> m_time_until_next_state;
+    std::vector<Time> m_time_until_next_event;
+};
+
+}
@@ -14,6 +14,13 @@ Simulation::Simulation(std::unique_ptr<ScenarioGenerator> generator, std::unique
     ASSERT(m_algorithm);
 }
 
+void sort_elevators_by_group(BuildingBlueprint& blueprint)
+{
+    std::sort(blueprint.elevators.begin(), blueprint.elevators.end(), [](auto const& lhs, auto const& rhs) {
+        return lhs.group < rhs.group;
+    });
+}
+
 bool Simulation::setup_for_run()
 {
     if (!m_generator) {
@@ -22,15 +29,18 @@ bool Simulation::setup_for_run()
     }
 
     auto building_result = m_generator->generate_building();
-    std::sort(building_result.blueprint().elevators.begin(), building_result.blueprint().elevators.end(), [](auto const& lhs, auto const& rhs) {
-        return lhs.group < rhs.group;
-    });
+    sort_elevators_by_group(building_result.blueprint());
 
     if (building_result.has_error()) {
         m_result = {SimulatorResult::Type::GenerationFailed, building_result.errors()};
         return false;
     }
 
+    if (m_shared_blueprint && *m_shared_blueprint != building_result.blueprint()) {
+        m_result = {SimulatorResult::Type::GenerationFailed, {"Generated building differs from the shared building"}};
+        return false;
+    }
+
     auto accepted = m_algorithm->accept_scenario_description(building_result);
 
     if (accepted.type != ElevatedAlgorithm::ScenarioAccepted::Type::Accepted) {
@@ -44,11 +54,55 @@ bool Simulation::setup_for_run()
 
     m_event_distributor.on_initial_building(building_result.blueprint());
 
-    m_building = BuildingState { building_result.extract_blueprint(), &m_event_distributor };
+    EventListener* listener = &m_event_distributor;
+    if (m_listener_pipeline)
+        listener = m_listener_pipeline.get();
+
+    if (m_shared_blueprint)
+        m_building = BuildingState { m_shared_blueprint, listener };
+    else
+        m_building = BuildingState { building_result.extract_blueprint(), listener };
+    if (m_group_workers)
+        m_building.run_groups_in_parallel(m_group_workers);
+
+    if (m_listener_pipeline) {
+        std::vector<ElevatorState> elevators;
+        elevators.reserve(m_building.num_elevators());
+        for (ElevatorID id = 0; id < m_building.num_elevators(); ++id)
+            elevators.push_back(m_building.elevator(id));
+        m_listener_pipeline->start(std::move(elevators));
+    }
 
     return true;
 }
 
+void Simulation::run_groups_in_parallel(size_t threads)
+{
+    ASSERT(m_result.type == SimulatorResult::Type::Starting);
+    if (threads > 1)
+        m_group_workers = std::make_shared<util::WorkerPool>(threads);
+    else
+        m_group_workers.reset();
+}
+
+void Simulation::share_building(std::shared_ptr<BuildingBlueprint const> blueprint)
+{
+    ASSERT(m_result.type == SimulatorResult::Type::Starting);
+    m_shared_blueprint = std::move(blueprint);
+}
+
+void Simulation::run_listeners_async(size_t queued_events)
+{
+    ASSERT(m_result.type == SimulatorResult::Type::Starting);
+    m_listener_pipeline = std::make_unique<AsyncEventPipeline>(m_event_distributor, queued_events);
+}
+
+void Simulation::flush_listeners()
+{
+    if (m_listener_pipeline)
+        m_listener_pipeline->flush();
+}
+
 constexpr Time extra_time_after_last_request = 100000;
 
 std::optional<Time> min_time(NextRequests requests, std::optional<Time> building_time, std::optional<Time> timer_time) {
@@ -105,18 +159,18 @@ Simulation::SimulationDone Simulation::tick()
     ASSERT(m_generator->next_requests_at() > running_until || next_request_time == running_until);
 
     std::vector<ElevatorID> elevators_closed;
-    {
-        for (auto& elevator_update : elevator_updates) {
-            if (elevator_update.type == BuildingState::UpdateResult::Type::DoorsOpened) {
-                auto callback = m_algorithm->on_doors_open(running_until, elevator_update.id, m_building);
-                if (callback.has_value())
-                    m_building.transfer_passengers(elevator_update.id, callback.value());
-                else
-                    m_building.transfer_passengers(elevator_update.id);
-            } else {
-                ASSERT(elevator_update.type == BuildingState::UpdateResult::Type::DoorsClosed);
-                elevators_closed.push_back(elevator_update.id);
-            }
+    // Also with groups in parallel every transfer happens before the algorithm is asked about the next
+    // elevator, as it may look at the floor queues and loads in on_doors_open.
+    for (auto& elevator_update : elevator_updates) {
+        if (elevator_update.type == BuildingState::UpdateResult::Type::DoorsOpened) {
+            auto callback = m_algorithm->on_doors_open(running_until, elevator_update.id, m_building);
+            if (callback.has_value())
+                m_building.transfer_passengers(elevator_update.id, callback.value());
+            else
+                m_building.transfer_passengers(elevator_update.id);
+        } else {
+            ASSERT(elevator_update.type == BuildingState::UpdateResult::Type::DoorsClosed);
+            elevators_closed.push_back(elevator_update.id);
         }
     }
 
@@ -185,6 +239,7 @@ SimulatorResult Simulation::run_full_simulation()
         done = tick();
     } while(done == SimulationDone::No);
     ASSERT(!m_result.is_in_progress());
+    flush_listeners();
     return m_result;
 }
 
@@ -4,6 +4,7 @@
 #include "generation/Generation.h"
 #include "Building.h"
 #include "algorithm/Algorithm.h"
+#include "stats/AsyncEventPipeline.h"
 
 namespace Elevated {
 
@@ -30,6 +31,9 @@ struct SimulatorResult {
     }
 };
 
+// Sorts the elevators such that all elevators of a group have consecutive ids.
+void sort_elevators_by_group(BuildingBlueprint& blueprint);
+
 class Simulation {
 public:
     Simulation(std::unique_ptr<ScenarioGenerator> generator, std::unique_ptr<ElevatedAlgorithm> algorithm);
@@ -41,6 +45,7 @@ public:
         return listener;
     }
 
+    // With async listeners, listeners must be added before the simulation starts.
     void add_listener(std::shared_ptr<EventListener> listener) { m_event_distributor.add_listener(std::move(listener)); }
     bool remove_listener(EventListener* listener) { return m_event_distributor.remove_listener(listener); }
 
@@ -51,6 +56,22 @@ public:
 
     SimulatorResult run_full_simulation();
 
+    // Updates the elevators of different groups on separate threads, only useful for
+    // buildings with multiple (big) groups. Must be called before the simulation starts.
+    void run_groups_in_parallel(size_t threads);
+
+    // Uses the given (already sorted) blueprint instead of a private copy, the generator
+    // must still generate the exact same building otherwise the generation fails.
+    // Must be called before the simulation starts.
+    void share_building(std::shared_ptr<BuildingBlueprint const> blueprint);
+
+    // Gives the events to the listeners on a separate thread, run_full_simulation
+    // waits for the listeners to catch up before returning. Otherwise call
+    // flush_listeners() before reading from a listener.
+    // Must be called before the simulation starts.
+    void run_listeners_async(size_t queued_events = 4096);
+    void flush_listeners();
+
     SimulatorResult result() const;
 
     enum class SimulationDone {
@@ -65,6 +86,9 @@ private:
     std::unique_ptr<ElevatedAlgorithm> m_algorithm;
     BuildingState m_building;
     EventDistributor m_event_distributor;
+    std::shared_ptr<util::WorkerPool> m_group_workers;
+    std::shared_ptr<BuildingBlueprint const> m_shared_blueprint;
+    std::unique_ptr<AsyncEventPipeline> m_listener_pipeline;
 
     SimulatorResult m_result{SimulatorResult::Type::Starting, {}};
 
@@ -0,0 +1,171 @@
+#include "SimulationBatch.h"
+#include "../../util/Assertions.h"
+#include <algorithm>
+
+namespace Elevated {
+
+class SimulationBatch::StatsCollector final : public EventListener {
+public:
+    Stats stats;
+
+    virtual void on_request_created(Time at, Passenger const& passenger) override
+    {
+        // Passenger ids are handed out consecutively so plain vectors suffice instead of maps.
+        if (passenger.id >= m_created_at.size()) {
+            m_created_at.resize(passenger.id + 1);
+            m_entered_at.resize(passenger.id + 1);
+        }
+        m_created_at[passenger.id] = at;
+        ++stats.requests;
+    }
+
+    virtual void on_passenger_enter_elevator(Time at, Passenger const& passenger, ElevatorID) override
+    {
+        ASSERT(passenger.id < m_created_at.size());
+        Time wait_time = at - m_created_at[passenger.id];
+        stats.total_wait_time += wait_time;
+        stats.max_wait_time = std::max(stats.max_wait_time, wait_time);
+        m_entered_at[passenger.id] = at;
+    }
+
+    virtual void on_passenger_leave_elevator(Time at, PassengerID id, Height) override
+    {
+        ASSERT(id < m_entered_at.size());
+        Time travel_time = at - m_entered_at[id];
+        stats.total_travel_time += travel_time;
+        stats.max_travel_time = std::max(stats.max_travel_time, travel_time);
+        ++stats.delivered;
+    }
+
+    virtual void on_elevator_opened_doors(Time, ElevatorState const&) override
+    {
+        ++stats.doors_opened;
+    }
+
+    virtual void on_elevator_moved(Time, Height distance, Height, ElevatorState const&) override
+    {
+        stats.distance_travelled += distance;
+    }
+
+private:
+    std::vector<Time> m_created_at;
+    std::vector<Time> m_entered_at;
+};
+
+SimulationBatch::SimulationBatch(size_t simulations, GeneratorFactory const& make_generator, AlgorithmFactory const& make_algorithm)
+    : m_collectors(std::make_shared<std::vector<StatsCollector>>(simulations))
+    , m_results(simulations)
+{
+    if (simulations == 0)
+        return;
+
+    // A separate generator is used for this as generating the building may affect the generator,
+    // so the building is generated once more than there are simulations.
+    auto building = make_generator(0)->generate_building();
+    if (!building.has_error()) {
+        sort_elevators_by_group(building.blueprint());
+        m_blueprint = std::make_shared<BuildingBlueprint const>(building.extract_blueprint());
+    }
+
+    m_simulations.reserve(simulations);
+    for (size_t i = 0; i < simulations; ++i) {
+        auto& simulation = m_simulations.emplace_back(make_generator(i), make_algorithm(i));
+        if (m_blueprint)
+            simulation.share_building(m_blueprint);
+
+        // Aliases the collector vector so no allocation per simulation is needed.
+        simulation.add_listener(std::shared_ptr<EventListener>(m_collectors, &(*m_collectors)[i]));
+    }
+}
+
+void SimulationBatch::run_range(size_t begin, size_t end)
+{
+    std::vector<size_t> running(end - begin);
+    for (size_t i = 0; i < running.size(); ++i)
+        running[i] = begin + i;
+
+    while (!running.empty()) {
+        std::erase_if(running, [&](size_t index) {
+            if (m_simulations[index].tick() == Simulation::SimulationDone::No)
+                return false;
+
+            m_results[index] = m_simulations[index].result();
+            (*m_collectors)[index].stats.total_time = m_simulations[index].building().current_time();
+            return true;
+        });
+    }
+}
+
+void SimulationBatch::run(util::WorkerPool* workers)
+{
+    ASSERT(!m_done);
+    if (!workers || workers->size() == 1) {
+        run_range(0, size());
+    } else {
+        size_t ranges = std::min(workers->size(), size());
+        workers->run(ranges, [&](size_t range) {
+            run_range(range * size() / ranges, (range + 1) * size() / ranges);
+        });
+    }
+    m_done = true;
+}
+
+SimulatorResult const& SimulationBatch::result(size_t index) const
+{
+    ASSERT(m_done);
+    ASSERT(index < size());
+    return m_results[index];
+}
+
+SimulationBatch::Stats const& SimulationBatch::stats(size_t index) const
+{
+    ASSERT(m_done);
+    ASSERT(index < size());
+    return (*m_collectors)[index].stats;
+}
+
+SimulationBatch::Summary SimulationBatch::summary() const
+{
+    ASSERT(m_done);
+    Summary summary;
+    summary.simulations = size();
+
+    uint64_t delivered = 0;
+    uint64_t wait_time = 0;
+    uint64_t travel_time = 0;
+    uint64_t distance = 0;
+    uint64_t doors_opened = 0;
+    uint64_t total_time = 0;
+
+    for (size_t i = 0; i < size(); ++i) {
+        ++summary.results[m_results[i].type];
+        if (m_results[i].type != SimulatorResult::Type::SuccessFull)
+            continue;
+
+        auto& stats = (*m_collectors)[i].stats;
+        ++summary.successful;
+        delivered += stats.delivered;
+        wait_time += stats.total_wait_time;
+        travel_time += stats.total_travel_time;
+        distance += stats.distance_travelled;
+        doors_opened += stats.doors_opened;
+        total_time += stats.total_time;
+        summary.max_wait_time = std::max(summary.max_wait_time, stats.max_wait_time);
+        summary.max_travel_time = std::max(summary.max_travel_time, stats.max_travel_time);
+    }
+
+    if (delivered > 0) {
+        summary.avg_wait_time = (double)wait_time / (double)delivered;
+        summary.avg_travel_time = (double)travel_time / (double)delivered;
+    }
+
+    if (summary.successful > 0) {
+        summary.avg_distance_travelled = (double)distance / (double)summary.successful;
+        summary.avg_doors_opened = (double)doors_opened / (double)summary.successful;
+        summary.avg_total_time = (double)total_time / (double)summary.successful;
+    }
+
+    return summary;
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Simulation.h"
+#include "../../util/WorkerPool.h"
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Elevated {
+
+// Runs many independent simulations of the same building, for example to tune an
+// in process algorithm over a lot of seeds. Every simulation still generates the
+// building, as its generator sets up its requests from it, but it is only compared
+// with one shared blueprint which all simulations use instead of keeping a copy.
+// The statistics live in one contiguous block instead of separate listeners per
+// simulation, the simulations themselves are separate objects.
+class SimulationBatch {
+public:
+    using GeneratorFactory = std::function<std::unique_ptr<ScenarioGenerator>(size_t index)>;
+    using AlgorithmFactory = std::function<std::unique_ptr<ElevatedAlgorithm>(size_t index)>;
+
+    // Every generator must generate the same building, simulations which do not fail with GenerationFailed.
+    SimulationBatch(size_t simulations, GeneratorFactory const& make_generator, AlgorithmFactory const& make_algorithm);
+
+    SimulationBatch(SimulationBatch const&) = delete;
+    SimulationBatch& operator=(SimulationBatch const&) = delete;
+
+    struct Stats {
+        uint64_t requests { 0 };
+        uint64_t delivered { 0 };
+        uint64_t total_wait_time { 0 };
+        Time max_wait_time { 0 };
+        uint64_t total_travel_time { 0 };
+        Time max_travel_time { 0 };
+        uint64_t distance_travelled { 0 };
+        uint64_t doors_opened { 0 };
+        Time total_time { 0 };
+    };
+
+    struct Summary {
+        size_t simulations { 0 };
+        size_t successful { 0 };
+        std::unordered_map<SimulatorResult::Type, size_t> results;
+
+        // Only over the successful simulations.
+        double avg_wait_time { 0 };
+        Time max_wait_time { 0 };
+        double avg_travel_time { 0 };
+        Time max_travel_time { 0 };
+        double avg_distance_travelled { 0 };
+        double avg_doors_opened { 0 };
+        double avg_total_time { 0 };
+    };
+
+    // Ticks all simulations in turn until every one of them is done, each tick moves a
+    // simulation to its own next event so they do not run in lockstep. With workers the
+    // simulations are split into consecutive ranges, one for each worker.
+    void run(util::WorkerPool* workers = nullptr);
+
+    [[nodiscard]] size_t size() const { return m_simulations.size(); }
+    [[nodiscard]] BuildingBlueprint const* blueprint() const { return m_blueprint.get(); }
+
+    [[nodiscard]] Simulation const& simulation(size_t index) const { return m_simulations[index]; }
+    [[nodiscard]] SimulatorResult const& result(size_t index) const;
+    [[nodiscard]] Stats const& stats(size_t index) const;
+
+    [[nodiscard]] Summary summary() const;
+
+private:
+    class StatsCollector;
+
+    void run_range(size_t begin, size_t end);
+
+    std::shared_ptr<BuildingBlueprint const> m_blueprint;
+    std::vector<Simulation> m_simulations;
+    std::shared_ptr<std::vector<StatsCollector>> m_collectors;
+    std::vector<SimulatorResult> m_results;
+    bool m_done { false };
+};
+
+}
@@ -17,6 +17,15 @@ constexpr Height distance_between(Height one, Height two) {
     return two - one;
 }
 
+enum class Direction : uint8_t {
+    Up,
+    Down,
+};
+
+constexpr Direction direction_between(Height from, Height to) {
+    return to > from ? Direction::Up : Direction::Down;
+}
+
 static_assert(uint32_t{} == 0);
 
 }
@@ -28,7 +28,7 @@ ElevatedAlgorithm::ScenarioAccepted::ScenarioAccepted(Type type_, std::vector<st
 {
 }
 
-AlgorithmInput AlgorithmInput::new_request(Height at, size_t index) {
+AlgorithmInput AlgorithmInput::new_request(Height at, FloorQueue::Index index) {
     AlgorithmInput input;
     input.m_type = Type::NewRequestMade;
     input.m_request_height = at;
@@ -109,9 +109,7 @@ ElevatorID AlgorithmInput::elevator_id() const {
 
 Passenger const& AlgorithmInput::request(BuildingState const& building) const {
     ASSERT(m_type == Type::NewRequestMade);
-    auto& queue = building.passengers_at(m_request_height);
-    ASSERT(m_request_index < queue.size());
-    return queue[m_request_index];
+    return building.passengers_at(m_request_height).at(m_request_index);
 }
 
 Height AlgorithmInput::request_height() const
@@ -120,7 +118,7 @@ Height AlgorithmInput::request_height() const
     return m_request_height;
 }
 
-size_t AlgorithmInput::request_index() const
+FloorQueue::Index AlgorithmInput::request_index() const
 {
     ASSERT(m_type == Type::NewRequestMade);
     return m_request_index;
@@ -10,7 +10,7 @@ namespace Elevated {
 
 class AlgorithmInput {
 public:
-    static AlgorithmInput new_request(Height at, size_t index);
+    static AlgorithmInput new_request(Height at, FloorQueue::Index index);
     static AlgorithmInput elevator_closed_doors(ElevatorID);
     static AlgorithmInput timer_fired();
 
@@ -24,14 +24,14 @@ public:
     ElevatorID elevator_id() const;
     Passenger const& request(BuildingState const&) const;
     Height request_height() const;
-    size_t request_index() const;
+    FloorQueue::Index request_index() const;
 private:
     AlgorithmInput() = default;
 
     Type m_type;
     ElevatorID m_elevator_id = -1;
     Height m_request_height = -1;
-    size_t m_request_index = -1;
+    FloorQueue::Index m_request_index;
 };
 
 class AlgorithmResponse {
@@ -2,7 +2,6 @@
 #include "../../../util/Assertions.h"
 #include <algorithm>
 #include <charconv>
-#include <numeric>
 #include <set>
 #include <sstream>
 
@@ -20,11 +19,38 @@ ProcessAlgorithm::ProcessAlgorithm(std::vector<std::string> command, InfoLevel i
 
 ProcessAlgorithm::~ProcessAlgorithm()
 {
-    if (m_process) {
-        m_process->writeToWithTimeout("stop\n", 50);
-        std::string fake_line;
-        m_process->readLineWithTimeout(fake_line, 50);
-    }
+    stop_process();
+}
+
+void ProcessAlgorithm::stop_process()
+{
+    if (!m_process)
+        return;
+
+    m_process->writeToWithTimeout("stop\n", 50);
+    std::string fake_line;
+    m_process->readLineWithTimeout(fake_line, 50);
+    m_usage = m_process->stop().usage;
+    m_process.reset();
+}
+
+void ProcessAlgorithm::limit_on_cpu_time(size_t wall_factor)
+{
+    ASSERT(wall_factor >= 1);
+    m_cpu_limit_wall_factor = wall_factor;
+}
+
+std::optional<util::SubProcess::ResourceUsage> ProcessAlgorithm::resource_usage()
+{
+    stop_process();
+    return m_usage;
+}
+
+std::optional<std::string> ProcessAlgorithm::send_and_wait(std::string_view message, size_t milliseconds, size_t* time_taken)
+{
+    if (m_cpu_limit_wall_factor.has_value())
+        return m_process->sendAndWaitForResponseWithCpuLimit(message, milliseconds, milliseconds * *m_cpu_limit_wall_factor, time_taken);
+    return m_process->sendAndWaitForResponse(message, milliseconds, time_taken);
 }
 
 void ProcessAlgorithm::write_building(BuildingGenerationResult const& building, std::ostringstream& stream)
@@ -64,9 +90,24 @@ void ProcessAlgorithm::write_building(BuildingGenerationResult const& building,
     }
 }
 
+void ProcessAlgorithm::run_in_sandbox(util::SubProcess::Sandbox sandbox)
+{
+    m_sandbox = std::move(sandbox);
+}
+
+void ProcessAlgorithm::spawn_from(std::shared_ptr<util::Zygote> zygote)
+{
+    m_zygote = std::move(zygote);
+}
+
 ElevatedAlgorithm::ScenarioAccepted ProcessAlgorithm::accept_scenario_description(BuildingGenerationResult const& building)
 {
-    m_process = util::SubProcess::create(m_command, m_stderr_handling, m_working_directory);
+    if (m_zygote)
+        m_process = m_zygote->spawn();
+    else if (m_sandbox.has_value())
+        m_process = util::SubProcess::create_sandboxed(m_command, *m_sandbox, m_stderr_handling);
+    else
+        m_process = util::SubProcess::create(m_command, m_stderr_handling, m_working_directory);
     if (!m_process) {
         return ScenarioAccepted::failed({ "Failed to start process", make_command_string() });
     }
@@ -99,7 +140,7 @@ ElevatedAlgorithm::ScenarioAccepted ProcessAlgorithm::accept_scenario_descriptio
 
     size_t start_up_time;
     auto val = std::move(*message.rdbuf()).str();
-    auto result = m_process->sendAndWaitForResponse(val, 1500, &start_up_time);
+    auto result = send_and_wait(val, 1500, &start_up_time);
     if (!result.has_value())
         return ScenarioAccepted::failed({ "Process failed to respond to setup, command: ", make_command_string() });
 
@@ -117,11 +158,7 @@ void ProcessAlgorithm::write_elevator_base(const ElevatorState& elevator, std::o
     stream << elevator.id << ' '
            << elevator.group_id << ' '
            << elevator.height();
-    std::set<Height> targets;
-    std::transform(elevator.passengers().begin(), elevator.passengers().end(),
-        std::inserter(targets, targets.begin()), [](ElevatorState::TravellingPassenger const& passenger){
-            return passenger.to;
-        });
+    auto targets = elevator.passengers().destinations();
 
     stream << ' ' << targets.size() << ' ';
 
@@ -146,17 +183,8 @@ void ProcessAlgorithm::write_elevator_closed(BuildingState const& building, Elev
 
     stream << " still-waiting ";
     auto const& queue = building.passengers_at(elevator.height());
-    auto [up, down] = std::accumulate(queue.begin(), queue.end(), std::pair<bool, bool>{false, false},
-        [&](auto acc, Passenger const& entry){
-            ASSERT(entry.from == elevator.height());
-            if (entry.group != elevator.group_id)
-                return acc;
-            bool request_up = entry.to > entry.from;
-            return std::pair<bool, bool>{
-                acc.first || request_up,
-                acc.second || !request_up,
-            };
-        });
+    bool up = queue.has_waiting(elevator.group_id, Direction::Up);
+    bool down = queue.has_waiting(elevator.group_id, Direction::Down);
 
     if (up && down)
         stream << "up,down";
@@ -183,21 +211,15 @@ void ProcessAlgorithm::write_new_request(Passenger const& request, std::ostrings
         stream << "down";
 }
 
-bool ProcessAlgorithm::should_write_new_request(BuildingState const& building, Height target, size_t index)
+bool ProcessAlgorithm::should_write_new_request(BuildingState const& building, Height target, FloorQueue::Index index)
 {
     ASSERT(m_info_level == InfoLevel::Low);
-    auto& queue = building.passengers_at(target);
-    ASSERT(queue.size() > index);
-    auto& request = queue[index];
-    bool going_up = request.to > request.from;
-
-    return std::none_of(queue.begin(), std::next(queue.begin(), index), [&](Passenger const& item) {
-        if (item.group != request.group)
-            return false;
+    [[maybe_unused]] auto& queue = building.passengers_at(target).waiting(index.group, index.direction);
+    ASSERT(queue.size() > index.index);
 
-        bool also_going_up = item.to > item.from;
-        return going_up == also_going_up;
-    });
+    // Only the first passenger of a group going in a direction is announced,
+    // everyone after that is already covered by that request.
+    return index.index == 0;
 }
 
 static std::optional<uint64_t> parse_unsigned(std::string_view view) {
@@ -250,7 +272,7 @@ std::vector<AlgorithmResponse> ProcessAlgorithm::on_inputs(Time at, BuildingStat
 
     size_t time_taken;
     size_t time_left = 500;
-    auto result = m_process->sendAndWaitForResponse(message.str(), time_left, &time_taken);
+    auto result = send_and_wait(message.str(), time_left, &time_taken);
     if (!result.has_value())
         return { AlgorithmResponse::algorithm_failed({ "Process failed to respond to messages, command: ", make_command_string(), "input: ", message.str() }) };
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../../../util/Process.h"
+#include "../../../util/Zygote.h"
 #include "Algorithm.h"
 #include <sstream>
 
@@ -20,6 +21,18 @@ public:
     ProcessAlgorithm& operator=(ProcessAlgorithm const&) = delete;
     ~ProcessAlgorithm();
 
+    // Start the command in this sandbox instead of as a normal process.
+    void run_in_sandbox(util::SubProcess::Sandbox sandbox);
+    // Get the process from this zygote instead of starting the command.
+    void spawn_from(std::shared_ptr<util::Zygote> zygote);
+
+    // Judge response times on the cpu time of the process, it may take up to
+    // wall_factor times as long on the clock (when the machine is busy).
+    void limit_on_cpu_time(size_t wall_factor);
+
+    // Stops the process, so only call this once the simulation is done.
+    std::optional<util::SubProcess::ResourceUsage> resource_usage();
+
     ScenarioAccepted accept_scenario_description(BuildingGenerationResult const& building) override;
     std::optional<ElevatorState::PassengerCallback> on_doors_open(Time time_1, ElevatorID id, BuildingState const& state) override;
     std::vector<AlgorithmResponse> on_inputs(Time at, BuildingState const& building, std::vector<AlgorithmInput> inputs) override;
@@ -29,7 +42,7 @@ public:
     void write_elevator_base(ElevatorState const& elevator, std::ostringstream& stream) const;
     void write_elevator_closed(BuildingState const&, ElevatorID, std::ostringstream& stream) const;
     void write_new_request(Passenger const&, std::ostringstream&) const;
-    bool should_write_new_request(BuildingState const&, Height target, size_t index);
+    bool should_write_new_request(BuildingState const&, Height target, FloorQueue::Index index);
 
     std::string make_command_string() const;
 private:
@@ -38,6 +51,13 @@ private:
     InfoLevel m_info_level;
     util::SubProcess::StderrState m_stderr_handling;
     std::string m_working_directory;
+    std::optional<util::SubProcess::Sandbox> m_sandbox;
+    std::shared_ptr<util::Zygote> m_zygote;
+    std::optional<size_t> m_cpu_limit_wall_factor;
+    std::optional<util::SubProcess::ResourceUsage> m_usage;
+
+    void stop_process();
+    std::optional<std::string> send_and_wait(std::string_view message, size_t milliseconds, size_t* time_taken);
     enum class PassengerFilter {
         UpOnly,
         DownOnly
@@ -3,6 +3,8 @@
 #include <elevated/Simulation.h>
 #include <elevated/algorithm/ProcessAlgorithm.h>
 #include <elevated/generation/FullGenerators.h>
+#include <elevated/generation/PipelinedGenerator.h>
+#include <elevated/generation/ScenarioFile.h>
 #include <elevated/generation/factory/NamedScenarios.h>
 #include <elevated/generation/factory/StringSettings.h>
 #include <elevated/stats/ElevatorStatsListener.h>
@@ -25,6 +27,13 @@ int main(int argc, char** argv) {
     std::vector<std::string> command;
     std::string input = "named-scenario(h1)";
     std::string cwd = "";
+    std::string scenario_file = "";
+    size_t group_threads = 1;
+    bool pipeline_requests = false;
+    bool async_listeners = false;
+    std::string sandbox_root = "";
+    bool zygote = false;
+    bool cpu_limit = false;
 
     bool in_flags = true;
 
@@ -41,6 +50,15 @@ int main(int argc, char** argv) {
 
                 input = argv[i];
                 continue;
+            } else if (val == "--gen-file") {
+                if (i == argc - 1) {
+                    std::cout << "Must give scenario file after --gen-file\n";
+                    return 1;
+                }
+                i++;
+
+                scenario_file = argv[i];
+                continue;
             } else if (val == "--cwd") {
                 if (i == argc - 1) {
                     std::cout << "Must give working directory after --cwd\n";
@@ -50,6 +68,36 @@ int main(int argc, char** argv) {
 
                 cwd = argv[i];
                 continue;
+            } else if (val == "--group-threads") {
+                if (i == argc - 1) {
+                    std::cout << "Must give number of threads after --group-threads\n";
+                    return 1;
+                }
+                i++;
+
+                group_threads = std::stoul(argv[i]);
+                continue;
+            } else if (val == "--pipeline-requests") {
+                pipeline_requests = true;
+                continue;
+            } else if (val == "--async-listeners") {
+                async_listeners = true;
+                continue;
+            } else if (val == "--sandbox") {
+                if (i == argc - 1) {
+                    std::cout << "Must give root directory after --sandbox\n";
+                    return 1;
+                }
+                i++;
+
+                sandbox_root = argv[i];
+                continue;
+            } else if (val == "--zygote") {
+                zygote = true;
+                continue;
+            } else if (val == "--cpu-limit") {
+                cpu_limit = true;
+                continue;
             }
         }
 
@@ -62,7 +110,11 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    auto scenario_result = parse_scenario(input, rand());
+    ScenarioResult scenario_result;
+    if (scenario_file.empty())
+        scenario_result = parse_scenario(input, rand());
+    else
+        scenario_result.generator = std::make_unique<MappedScenarioGenerator>(scenario_file);
 
     auto generator = std::move(scenario_result.generator);
 
@@ -77,10 +129,36 @@ int main(int argc, char** argv) {
     for (auto& s : scenario_result.errors)
         std::cerr << s << '\n';
 
+    if (pipeline_requests)
+        generator = std::make_unique<PipelinedScenarioGenerator>(std::move(generator));
 
-    std::unique_ptr<ElevatedAlgorithm> algorithm = std::make_unique<ProcessAlgorithm>(command, ProcessAlgorithm::InfoLevel::Low, util::SubProcess::StderrState::Forwarded, std::move(cwd));
+    std::optional<util::SubProcess::Sandbox> sandbox;
+    if (!sandbox_root.empty()) {
+        sandbox.emplace();
+        sandbox->root_directory = sandbox_root;
+    }
+
+    auto process_algorithm = std::make_unique<ProcessAlgorithm>(command, ProcessAlgorithm::InfoLevel::Low, util::SubProcess::StderrState::Forwarded, std::move(cwd));
+    if (zygote) {
+        // Mostly useful to check a zygote works, a single run gains nothing from it.
+        std::shared_ptr<util::Zygote> started = util::Zygote::start(command, sandbox, util::SubProcess::StderrState::Forwarded);
+        if (!started) {
+            std::cerr << "Failed to start zygote\n";
+            return 1;
+        }
+        process_algorithm->spawn_from(std::move(started));
+    } else if (sandbox.has_value()) {
+        process_algorithm->run_in_sandbox(std::move(*sandbox));
+    }
+    if (cpu_limit)
+        process_algorithm->limit_on_cpu_time(4);
+    auto* process = process_algorithm.get();
+    std::unique_ptr<ElevatedAlgorithm> algorithm = std::move(process_algorithm);
 
     Simulation simulation { std::move(generator), std::move(algorithm) };
+    simulation.run_groups_in_parallel(group_threads);
+    if (async_listeners)
+        simulation.run_listeners_async();
 
     auto passenger_stats_listener = simulation.construct_and_add_listener<PassengerStatsListener>();
     auto power_stats = simulation.construct_and_add_listener<PowerStatsListener>();
@@ -131,4 +209,9 @@ int main(int argc, char** argv) {
     for (auto& message : result.output_messages)
         std::cout << "  " << message << '\n';
 
+    if (auto usage = process->resource_usage(); usage.has_value()) {
+        std::cout << "Bot used " << usage->user_microseconds / 1000 << "ms user and " << usage->system_microseconds / 1000 << "ms system cpu time"
+                  << ", peak memory " << usage->peak_memory_kilobytes << "kB\n";
+    }
+
 }
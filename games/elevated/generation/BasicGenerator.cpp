@@ -1,14 +1,20 @@
 #include "BasicGenerator.h"
 #include "../../../util/Assertions.h"
 
+#include <cmath>
 #include <iterator>
 
 namespace Elevated {
 
-IndependentRequestGenerator::IndependentRequestGenerator(long seed, size_t requests, double mean)
-    : m_engine(seed)
+// Large enough to amortize the virtual call, small enough to stay in cache.
+static constexpr size_t counter_block_size = 4096;
+
+IndependentRequestGenerator::IndependentRequestGenerator(long seed, size_t requests, double mean, RandomSource source)
+    : m_source(source)
+    , m_engine(seed)
     , m_exp_dist(mean)
     , m_requests_left(requests)
+    , m_counter_random(static_cast<uint64_t>(seed))
 {
 }
 
@@ -19,8 +25,42 @@ void IndependentRequestGenerator::accept_building(const BuildingGenerationResult
         return;
     }
 
-    m_next_request_at = static_cast<Time>(m_exp_dist(m_engine));
+    if (m_source == RandomSource::Engine) {
+        m_next_request_at = static_cast<Time>(m_exp_dist(m_engine));
+        inner_accept_building(result);
+        return;
+    }
+
     inner_accept_building(result);
+    // The generator cannot make requests for a building it rejected.
+    if (!result.has_error())
+        generate_block();
+}
+
+void IndependentRequestGenerator::generate_block()
+{
+    ASSERT(m_source == RandomSource::Counter);
+    size_t count = std::min(counter_block_size, m_requests_left);
+    ASSERT(count > 0);
+
+    m_random_values.resize(count * values_per_request);
+    m_counter_random.fill(m_generated_requests * values_per_request, m_random_values);
+
+    Time arrival = m_generated_requests == 0 ? 0 : m_block_times.back();
+    m_block_times.resize(count);
+    double mean = m_exp_dist.lambda();
+    for (size_t i = 0; i < count; ++i) {
+        // Inverse of the exponential distribution, truncated like the engine version.
+        arrival += static_cast<Time>(-std::log1p(-util::CounterRandom::unit(m_random_values[i * values_per_request])) / mean);
+        m_block_times[i] = arrival;
+    }
+
+    m_block.resize(count);
+    generate_requests(m_random_values, m_block);
+
+    m_generated_requests += count;
+    m_block_index = 0;
+    m_next_request_at = m_block_times.front();
 }
 
 NextRequests IndependentRequestGenerator::next_requests_at()
@@ -32,12 +72,30 @@ NextRequests IndependentRequestGenerator::next_requests_at()
 }
 
 std::vector<PassengerBlueprint> IndependentRequestGenerator::requests_at(Time time)
+{
+    std::vector<PassengerBlueprint> requests;
+    append_requests_at(time, requests);
+    return requests;
+}
+
+void IndependentRequestGenerator::append_requests_at(Time time, std::vector<PassengerBlueprint>& requests)
 {
     if (time < m_next_request_at || !m_requests_left)
-        return {};
+        return;
     ASSERT(time == m_next_request_at);
 
-    std::vector<PassengerBlueprint> requests;
+    if (m_source == RandomSource::Counter) {
+        while (m_requests_left && m_block_times[m_block_index] == time) {
+            requests.push_back(m_block[m_block_index]);
+            --m_requests_left;
+            if (++m_block_index == m_block.size() && m_requests_left)
+                generate_block();
+        }
+
+        if (m_requests_left)
+            m_next_request_at = m_block_times[m_block_index];
+        return;
+    }
 
     Time next_step = 0;
     while (next_step == 0 && m_requests_left) {
@@ -47,12 +105,10 @@ std::vector<PassengerBlueprint> IndependentRequestGenerator::requests_at(Time ti
     }
 
     m_next_request_at += next_step;
-
-    return requests;
 }
 
-UniformFloorGenerator::UniformFloorGenerator(long seed, size_t amount, double mean, Capacity capacity)
-    : IndependentRequestGenerator(seed, amount, mean)
+UniformFloorGenerator::UniformFloorGenerator(long seed, size_t amount, double mean, Capacity capacity, RandomSource source)
+    : IndependentRequestGenerator(seed, amount, mean, source)
     , m_capacity(capacity)
 {
 }
@@ -91,8 +147,27 @@ PassengerBlueprint UniformFloorGenerator::generate_request(std::minstd_rand& eng
     return {from, to, group, m_capacity};
 }
 
-GroundFloorGenerator::GroundFloorGenerator(long seed, size_t amount, double mean, Height ground_floor, Capacity capacity)
-    : IndependentRequestGenerator(seed, amount, mean)
+void UniformFloorGenerator::generate_requests(std::span<uint32_t const> random_values, std::span<PassengerBlueprint> requests)
+{
+    using util::CounterRandom;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        auto values = random_values.subspan(i * values_per_request, values_per_request);
+        GroupID group = CounterRandom::bounded(values[1], static_cast<uint32_t>(m_group_reachable.size()));
+        auto const& reachable = m_group_reachable[group];
+        auto floors = static_cast<uint32_t>(reachable.size());
+
+        // Pick the destination out of the other floors so no retries are needed.
+        auto from_index = CounterRandom::bounded(values[2], floors);
+        auto to_index = CounterRandom::bounded(values[3], floors - 1);
+        if (to_index >= from_index)
+            ++to_index;
+
+        requests[i] = { reachable[from_index], reachable[to_index], group, m_capacity };
+    }
+}
+
+GroundFloorGenerator::GroundFloorGenerator(long seed, size_t amount, double mean, Height ground_floor, Capacity capacity, RandomSource source)
+    : IndependentRequestGenerator(seed, amount, mean, source)
     , m_ground_floor(ground_floor)
     , m_capacity(capacity)
 {
@@ -146,6 +221,17 @@ PassengerBlueprint GroundFloorGenerator::generate_request(std::minstd_rand& engi
     };
 }
 
+void GroundFloorGenerator::generate_requests(std::span<uint32_t const> random_values, std::span<PassengerBlueprint> requests)
+{
+    using util::CounterRandom;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        auto values = random_values.subspan(i * values_per_request, values_per_request);
+        auto& to = m_travel_info[CounterRandom::bounded(values[1], static_cast<uint32_t>(m_travel_info.size()))];
+        GroupID group = to.reachable_from[CounterRandom::bounded(values[2], static_cast<uint32_t>(to.reachable_from.size()))];
+        requests[i] = { m_ground_floor, to.height, group, m_capacity };
+    }
+}
+
 HardcodedBuildingGenerator::HardcodedBuildingGenerator(std::vector<std::pair<size_t, std::vector<Height>>> building_description, Capacity elevator_capacity)
 {
     std::unordered_set<Height> all_floors;
@@ -208,11 +294,18 @@ NextRequests TransformingRequestGenerator::next_requests_at()
 
 std::vector<PassengerBlueprint> TransformingRequestGenerator::requests_at(Time time)
 {
-    auto requests = m_base_generator->requests_at(time);
-    std::for_each(requests.begin(), requests.end(), [&](auto& request) {
+    std::vector<PassengerBlueprint> requests;
+    append_requests_at(time, requests);
+    return requests;
+}
+
+void TransformingRequestGenerator::append_requests_at(Time time, std::vector<PassengerBlueprint>& requests)
+{
+    auto first_new = requests.size();
+    m_base_generator->append_requests_at(time, requests);
+    std::for_each(requests.begin() + static_cast<std::ptrdiff_t>(first_new), requests.end(), [&](auto& request) {
         transform(request);
     });
-    return requests;
 }
 
 ForceDirectionGenerator::ForceDirectionGenerator(std::unique_ptr<RequestGenerator> generator, ForceDirectionGenerator::Operation operation, long seed, double flip_chance)
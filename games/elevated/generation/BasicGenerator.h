@@ -1,8 +1,10 @@
 #pragma once
 
 #include "Generation.h"
+#include "../../../util/CounterRandom.h"
 
 #include <random>
+#include <span>
 
 namespace Elevated {
 
@@ -18,27 +20,51 @@ private:
 
 class IndependentRequestGenerator : public RequestGenerator {
 public:
-    IndependentRequestGenerator(long seed, size_t amount, double mean);
+    enum class RandomSource {
+        // Draws every request from a std::minstd_rand, one at a time.
+        Engine,
+        // Generates requests in blocks from util::CounterRandom, gives different requests than Engine.
+        Counter,
+    };
+
+    // Every request in Counter mode uses this many random values, the first is for the arrival time.
+    static constexpr size_t values_per_request = 4;
+
+    IndependentRequestGenerator(long seed, size_t amount, double mean, RandomSource source = RandomSource::Engine);
 
     virtual void accept_building(const BuildingGenerationResult& result) final;
     virtual NextRequests next_requests_at() final;
     virtual std::vector<PassengerBlueprint> requests_at(Time time) final;
+    virtual void append_requests_at(Time time, std::vector<PassengerBlueprint>& requests) final;
 
     virtual PassengerBlueprint generate_request(std::minstd_rand& engine) = 0;
+    // Fills requests using values_per_request random values for each request, except the first of each.
+    virtual void generate_requests(std::span<uint32_t const> random_values, std::span<PassengerBlueprint> requests) = 0;
     virtual void inner_accept_building(const BuildingGenerationResult& result) = 0;
 private:
+    void generate_block();
+
+    RandomSource m_source;
     std::minstd_rand m_engine;
     std::exponential_distribution<double> m_exp_dist;
     size_t m_requests_left;
     Time m_next_request_at{0};
+
+    util::CounterRandom m_counter_random;
+    size_t m_generated_requests{0};
+    std::vector<uint32_t> m_random_values;
+    std::vector<PassengerBlueprint> m_block;
+    std::vector<Time> m_block_times;
+    size_t m_block_index{0};
 };
 
 class UniformFloorGenerator final : public IndependentRequestGenerator {
 public:
-    UniformFloorGenerator(long seed, size_t amount, double mean, Capacity capacity = 1);
+    UniformFloorGenerator(long seed, size_t amount, double mean, Capacity capacity = 1, RandomSource source = RandomSource::Engine);
 
     virtual void inner_accept_building(const BuildingGenerationResult& result) override;
     virtual PassengerBlueprint generate_request(std::minstd_rand& engine) override;
+    virtual void generate_requests(std::span<uint32_t const> random_values, std::span<PassengerBlueprint> requests) override;
 
 private:
     std::vector<std::vector<Height>> m_group_reachable;
@@ -47,10 +73,11 @@ private:
 
 class GroundFloorGenerator final : public IndependentRequestGenerator {
 public:
-    GroundFloorGenerator(long seed, size_t amount, double mean, Height ground_floor, Capacity capacity = 1);
+    GroundFloorGenerator(long seed, size_t amount, double mean, Height ground_floor, Capacity capacity = 1, RandomSource source = RandomSource::Engine);
 
     virtual void inner_accept_building(const BuildingGenerationResult& result) override;
     virtual PassengerBlueprint generate_request(std::minstd_rand& engine) override;
+    virtual void generate_requests(std::span<uint32_t const> random_values, std::span<PassengerBlueprint> requests) override;
 
 private:
     struct FloorInfo {
@@ -72,6 +99,7 @@ public:
     virtual void accept_building(const BuildingGenerationResult& result) final;
     virtual NextRequests next_requests_at() final;
     virtual std::vector<PassengerBlueprint> requests_at(Time time) final;
+    virtual void append_requests_at(Time time, std::vector<PassengerBlueprint>& requests) final;
 
     virtual void transform(PassengerBlueprint&) = 0;
 private:
@@ -54,6 +54,12 @@ bool NextRequests::operator>(NextRequests const& other) const
     return *this != other && !(*this < other);
 }
 
+void RequestGenerator::append_requests_at(Time time, std::vector<PassengerBlueprint>& requests)
+{
+    auto new_requests = requests_at(time);
+    requests.insert(requests.end(), new_requests.begin(), new_requests.end());
+}
+
 SplitGenerator::SplitGenerator(std::unique_ptr<BuildingGenerator> building_generator, std::unique_ptr<RequestGenerator> request_generator)
     : m_building_generator(std::move(building_generator))
     , m_request_generator(std::move(request_generator))
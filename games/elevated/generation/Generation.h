@@ -13,11 +13,15 @@ struct BuildingBlueprint {
         GroupID group;
         Capacity max_capacity{1};
         Height speed{1};
+
+        bool operator==(Elevator const&) const = default;
     };
 
     std::vector<std::unordered_set<Height>> reachable_per_group;
     std::vector<Elevator> elevators;
 
+    bool operator==(BuildingBlueprint const&) const = default;
+
 //    Time time_to_open_doors; FIXME: Fixed per building (or all really) for now?
 //    Time time_to_close_doors; FIXME: Fixed per building (or all really) for now?
 };
@@ -102,6 +106,9 @@ public:
 
     virtual NextRequests next_requests_at() = 0;
     virtual std::vector<PassengerBlueprint> requests_at(Time time) = 0;
+
+    // Same as requests_at but appends to the given requests, so combining generators can share one buffer.
+    virtual void append_requests_at(Time time, std::vector<PassengerBlueprint>& requests);
 };
 
 class BuildingGenerator {
@@ -1,5 +1,6 @@
 #include "MetaGenerators.h"
 #include "Generation.h"
+#include <algorithm>
 
 namespace Elevated {
 RequestCombiner::RequestCombiner(std::vector<std::unique_ptr<RequestGenerator>> generators)
@@ -11,13 +12,41 @@ void RequestCombiner::accept_building(const BuildingGenerationResult& result)
 {
     for (auto& generator : m_generators)
         generator->accept_building(result);
+
+    // The generators only know their first requests after seeing the building.
+    m_queue_built = false;
+}
+
+void RequestCombiner::queue_generator(size_t index)
+{
+    auto next = m_generators[index]->next_requests_at();
+    if (next.type == NextRequests::Type::At)
+        m_queue.emplace(next.next_request_time, index);
+    else if (next.type == NextRequests::Type::Unknown)
+        m_unknown.push_back(index);
+}
+
+void RequestCombiner::build_queue()
+{
+    m_queue = {};
+    m_unknown.clear();
+    m_was_queued.assign(m_generators.size(), false);
+    for (size_t i = 0; i < m_generators.size(); ++i)
+        queue_generator(i);
+    m_queue_built = true;
 }
 
 NextRequests RequestCombiner::next_requests_at()
 {
+    if (!m_queue_built)
+        build_queue();
+
     NextRequests next = NextRequests::done();
-    for (auto& generator : m_generators) {
-        auto this_next = generator->next_requests_at();
+    if (!m_queue.empty())
+        next = NextRequests::at(m_queue.top().first);
+
+    for (auto index : m_unknown) {
+        auto this_next = m_generators[index]->next_requests_at();
         if (this_next < next)
             next = this_next;
     }
@@ -28,14 +57,45 @@ NextRequests RequestCombiner::next_requests_at()
 std::vector<PassengerBlueprint> RequestCombiner::requests_at(Time time)
 {
     std::vector<PassengerBlueprint> blueprints;
+    append_requests_at(time, blueprints);
+    return blueprints;
+}
+
+void RequestCombiner::append_requests_at(Time time, std::vector<PassengerBlueprint>& requests)
+{
+    if (!m_queue_built)
+        build_queue();
 
-    for (auto& generator : m_generators) {
-        auto specific_blueprints = generator->requests_at(time);
-        blueprints.insert(blueprints.end(), specific_blueprints.begin(), specific_blueprints.end());
+    // Generators which are not due would not give any requests, so they are not asked.
+    m_due.clear();
+    while (!m_queue.empty() && m_queue.top().first <= time) {
+        m_due.push_back(m_queue.top().second);
+        m_queue.pop();
     }
 
-    return blueprints;
-}
+    if (m_unknown.empty()) {
+        std::sort(m_due.begin(), m_due.end());
+        for (auto index : m_due) {
+            m_generators[index]->append_requests_at(time, requests);
+            queue_generator(index);
+        }
+        return;
+    }
+
+    // Interleave with the unknown generators so the requests stay in generator order.
+    auto due_count = m_due.size();
+    m_due.insert(m_due.end(), m_unknown.begin(), m_unknown.end());
+    for (size_t i = 0; i < due_count; ++i)
+        m_was_queued[m_due[i]] = true;
+    std::sort(m_due.begin(), m_due.end());
 
+    for (auto index : m_due) {
+        m_generators[index]->append_requests_at(time, requests);
+        if (m_was_queued[index]) {
+            m_was_queued[index] = false;
+            queue_generator(index);
+        }
+    }
 }
 
+}
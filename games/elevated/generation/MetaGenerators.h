@@ -1,6 +1,9 @@
 #pragma once
 
 #include "Generation.h"
+
+#include <queue>
+
 namespace Elevated {
 
 class RequestCombiner final : public RequestGenerator {
@@ -10,6 +13,7 @@ public:
     void accept_building(const BuildingGenerationResult& result) override;
     NextRequests next_requests_at() override;
     std::vector<PassengerBlueprint> requests_at(Time time) override;
+    void append_requests_at(Time time, std::vector<PassengerBlueprint>& requests) override;
 
     template<typename... Generators>
     static std::unique_ptr<RequestCombiner> create(Generators... generators) {
@@ -19,7 +23,21 @@ public:
     }
 
 private:
+    void build_queue();
+    void queue_generator(size_t index);
+
     std::vector<std::unique_ptr<RequestGenerator>> m_generators;
+
+    // Generators with a known next time, keyed on that time and then their index so
+    // requests at the same time keep the order of the generators.
+    using QueuedGenerator = std::pair<Time, size_t>;
+    std::priority_queue<QueuedGenerator, std::vector<QueuedGenerator>, std::greater<>> m_queue;
+    // Generators which do not know their next time have to be asked every time.
+    std::vector<size_t> m_unknown;
+    std::vector<size_t> m_due;
+    // Which of m_due came from the queue, only set while handing out requests.
+    std::vector<bool> m_was_queued;
+    bool m_queue_built { false };
 };
 
 }
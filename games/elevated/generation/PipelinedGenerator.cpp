@@ -0,0 +1,93 @@
+#include "PipelinedGenerator.h"
+
+namespace Elevated {
+
+PipelinedScenarioGenerator::PipelinedScenarioGenerator(std::unique_ptr<ScenarioGenerator> generator, size_t queued_times)
+    : m_generator(std::move(generator))
+    , m_entries(queued_times)
+{
+    ASSERT(m_generator);
+}
+
+PipelinedScenarioGenerator::~PipelinedScenarioGenerator()
+{
+    stop_producing();
+}
+
+void PipelinedScenarioGenerator::stop_producing()
+{
+    if (!m_producer.joinable())
+        return;
+
+    m_entries.close();
+    m_producer.join();
+}
+
+BuildingGenerationResult PipelinedScenarioGenerator::generate_building()
+{
+    ASSERT(!m_producer.joinable());
+    auto building = m_generator->generate_building();
+    if (!building.has_error()) {
+        m_direct = false;
+        m_producer = std::thread([this] { produce(); });
+    }
+    return building;
+}
+
+void PipelinedScenarioGenerator::produce()
+{
+    while (m_entries.wait_for_space()) {
+        Entry entry { m_generator->next_requests_at(), {} };
+        if (entry.next.type == NextRequests::Type::At)
+            entry.requests = m_generator->requests_at(entry.next.next_request_time);
+
+        bool last = entry.next.type != NextRequests::Type::At;
+        [[maybe_unused]] bool pushed = m_entries.try_emplace(std::move(entry));
+        ASSERT(pushed);
+        if (last)
+            return;
+    }
+}
+
+PipelinedScenarioGenerator::Entry& PipelinedScenarioGenerator::front()
+{
+    ASSERT(!m_direct);
+    [[maybe_unused]] bool has_item = m_entries.wait_for_item();
+    ASSERT(has_item);
+    auto* entry = m_entries.front();
+    ASSERT(entry);
+    return *entry;
+}
+
+NextRequests PipelinedScenarioGenerator::next_requests_at()
+{
+    if (m_direct)
+        return m_generator->next_requests_at();
+
+    auto& entry = front();
+    if (entry.next.type == NextRequests::Type::Unknown) {
+        // The producer has stopped, so the generator can be used from this thread now.
+        m_entries.pop();
+        stop_producing();
+        m_direct = true;
+        return m_generator->next_requests_at();
+    }
+
+    return entry.next;
+}
+
+std::vector<PassengerBlueprint> PipelinedScenarioGenerator::requests_at(Time time)
+{
+    if (m_direct)
+        return m_generator->requests_at(time);
+
+    auto& entry = front();
+    if (entry.next.type != NextRequests::Type::At || entry.next.next_request_time != time)
+        return {};
+
+    auto requests = std::move(entry.requests);
+    m_entries.pop();
+    return requests;
+}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Generation.h"
+#include "../../../util/SpscRing.h"
+#include <thread>
+
+namespace Elevated {
+
+// Runs the requests of another generator on a separate thread ahead of the simulation,
+// so generating them overlaps with waiting on the algorithm.
+// The building is still generated on the calling thread.
+class PipelinedScenarioGenerator final : public ScenarioGenerator {
+public:
+    explicit PipelinedScenarioGenerator(std::unique_ptr<ScenarioGenerator> generator, size_t queued_times = 64);
+    ~PipelinedScenarioGenerator() override;
+
+    BuildingGenerationResult generate_building() override;
+
+    NextRequests next_requests_at() override;
+
+    std::vector<PassengerBlueprint> requests_at(Time time) override;
+
+private:
+    struct Entry {
+        NextRequests next;
+        std::vector<PassengerBlueprint> requests;
+    };
+
+    void produce();
+    Entry& front();
+    void stop_producing();
+
+    std::unique_ptr<ScenarioGenerator> m_generator;
+    util::SpscRing<Entry> m_entries;
+    std::thread m_producer;
+
+    // Generators which do not know their next requests cannot run ahead,
+    // once that happens the generator is used directly again.
+    bool m_direct { true };
+};
+
+}
@@ -0,0 +1,138 @@
+#include "RequestTrace.h"
+#include "../../../util/Assertions.h"
+
+namespace Elevated {
+
+std::shared_ptr<RequestTrace const> RequestTrace::record(ScenarioGenerator& generator)
+{
+    std::shared_ptr<RequestTrace> trace { new RequestTrace(generator.generate_building()) };
+    trace->m_offsets.push_back(0);
+
+    // A failed building never gets to the requests in a simulation either.
+    if (trace->m_building.has_error())
+        return trace;
+
+    while (true) {
+        auto next = generator.next_requests_at();
+        if (next.type == NextRequests::Type::Done)
+            break;
+
+        if (next.type == NextRequests::Type::Unknown)
+            return nullptr;
+
+        // A simulation would fail on this, which is only reproduced by a live generator.
+        if (!trace->m_times.empty() && next.next_request_time <= trace->m_times.back())
+            return nullptr;
+
+        auto requests = generator.requests_at(next.next_request_time);
+        trace->m_times.push_back(next.next_request_time);
+        trace->m_requests.insert(trace->m_requests.end(), requests.begin(), requests.end());
+        trace->m_offsets.push_back(static_cast<uint32_t>(trace->m_requests.size()));
+    }
+
+    trace->m_times.shrink_to_fit();
+    trace->m_offsets.shrink_to_fit();
+    trace->m_requests.shrink_to_fit();
+    return trace;
+}
+
+std::vector<PassengerBlueprint> RequestTrace::requests_at(size_t index) const
+{
+    ASSERT(index < m_times.size());
+    return { m_requests.begin() + m_offsets[index], m_requests.begin() + m_offsets[index + 1] };
+}
+
+TraceScenarioGenerator::TraceScenarioGenerator(std::shared_ptr<RequestTrace const> trace)
+    : m_trace(std::move(trace))
+{
+    ASSERT(m_trace);
+}
+
+BuildingGenerationResult TraceScenarioGenerator::generate_building()
+{
+    return m_trace->building();
+}
+
+NextRequests TraceScenarioGenerator::next_requests_at()
+{
+    if (m_next >= m_trace->request_times())
+        return NextRequests::done();
+    return m_trace->time_at(m_next);
+}
+
+std::vector<PassengerBlueprint> TraceScenarioGenerator::requests_at([[maybe_unused]] Time time)
+{
+    ASSERT(m_next < m_trace->request_times());
+    ASSERT(time == m_trace->time_at(m_next));
+    return m_trace->requests_at(m_next++);
+}
+
+RequestTraceCache::RequestTraceCache(size_t capacity)
+    : m_capacity(capacity)
+{
+    ASSERT(m_capacity > 0);
+}
+
+std::shared_ptr<RequestTrace const> RequestTraceCache::trace_for(std::string const& scenario, long seed, GeneratorFactory const& make_generator)
+{
+    std::promise<std::shared_ptr<RequestTrace const>> promise;
+    std::shared_future<std::shared_ptr<RequestTrace const>> existing;
+    {
+        std::lock_guard lock(m_lock);
+        Key key { scenario, seed };
+        if (auto it = m_lookup.find(key); it != m_lookup.end()) {
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            existing = it->second->second;
+        } else {
+            // Threads still waiting on an evicted trace keep their own future of it.
+            m_entries.emplace_front(key, promise.get_future().share());
+            m_lookup.emplace(std::move(key), m_entries.begin());
+            if (m_entries.size() > m_capacity) {
+                m_lookup.erase(m_entries.back().first);
+                m_entries.pop_back();
+            }
+        }
+    }
+
+    // Wait outside of the lock as the trace may still be recording on another thread.
+    if (existing.valid())
+        return existing.get();
+
+    std::shared_ptr<RequestTrace const> trace;
+    try {
+        if (auto generator = make_generator(); generator)
+            trace = RequestTrace::record(*generator);
+    } catch (...) {
+        forget(Key { scenario, seed });
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    promise.set_value(trace);
+    return trace;
+}
+
+void RequestTraceCache::forget(Key const& key)
+{
+    std::lock_guard lock(m_lock);
+    auto it = m_lookup.find(key);
+    if (it == m_lookup.end())
+        return;
+    m_entries.erase(it->second);
+    m_lookup.erase(it);
+}
+
+size_t RequestTraceCache::size() const
+{
+    std::lock_guard lock(m_lock);
+    return m_entries.size();
+}
+
+void RequestTraceCache::clear()
+{
+    std::lock_guard lock(m_lock);
+    m_lookup.clear();
+    m_entries.clear();
+}
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Generation.h"
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace Elevated {
+
+// The full output of a scenario generator, recorded once so it can be replayed by
+// any number of simulations without generating the requests again.
+// Immutable after recording so it can be shared between threads.
+class RequestTrace {
+public:
+    // Returns nullptr if the generator cannot be recorded up front, that is
+    // when it does not know when its next requests are.
+    static std::shared_ptr<RequestTrace const> record(ScenarioGenerator& generator);
+
+    [[nodiscard]] BuildingGenerationResult const& building() const { return m_building; }
+
+    [[nodiscard]] size_t request_times() const { return m_times.size(); }
+    [[nodiscard]] size_t total_requests() const { return m_requests.size(); }
+
+    [[nodiscard]] Time time_at(size_t index) const { return m_times[index]; }
+    [[nodiscard]] std::vector<PassengerBlueprint> requests_at(size_t index) const;
+
+private:
+    explicit RequestTrace(BuildingGenerationResult building)
+        : m_building(std::move(building))
+    {
+    }
+
+    BuildingGenerationResult m_building;
+
+    // The requests of m_times[i] are m_requests[m_offsets[i]] up to m_requests[m_offsets[i + 1]].
+    std::vector<Time> m_times;
+    std::vector<uint32_t> m_offsets;
+    std::vector<PassengerBlueprint> m_requests;
+};
+
+class TraceScenarioGenerator final : public ScenarioGenerator {
+public:
+    explicit TraceScenarioGenerator(std::shared_ptr<RequestTrace const> trace);
+
+    BuildingGenerationResult generate_building() override;
+
+    NextRequests next_requests_at() override;
+
+    std::vector<PassengerBlueprint> requests_at(Time time) override;
+
+private:
+    std::shared_ptr<RequestTrace const> m_trace;
+    size_t m_next { 0 };
+};
+
+// Recorded traces keyed by scenario string and seed. Every key is only recorded
+// once, even when multiple threads ask for the same scenario at the same time.
+// Keeps at most capacity traces, dropping the least recently used one.
+class RequestTraceCache {
+public:
+    explicit RequestTraceCache(size_t capacity = 32);
+
+    using GeneratorFactory = std::function<std::unique_ptr<ScenarioGenerator>()>;
+
+    // Returns nullptr if the generator could not be made or could not be recorded,
+    // this is also remembered so the caller should fall back to a live generator.
+    std::shared_ptr<RequestTrace const> trace_for(std::string const& scenario, long seed, GeneratorFactory const& make_generator);
+
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] size_t capacity() const { return m_capacity; }
+    void clear();
+
+private:
+    using Key = std::pair<std::string, long>;
+    using Entry = std::pair<Key, std::shared_future<std::shared_ptr<RequestTrace const>>>;
+
+    void forget(Key const& key);
+
+    size_t m_capacity;
+
+    mutable std::mutex m_lock;
+    // Most recently used at the front.
+    std::list<Entry> m_entries;
+    std::map<Key, std::list<Entry>::iterator> m_lookup;
+};
+
+}
@@ -0,0 +1,203 @@
+#include "ScenarioFile.h"
+#include "../../../util/Assertions.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace Elevated {
+
+using namespace ScenarioFile;
+
+template<typename T>
+static void write_value(std::ofstream& stream, T const& value)
+{
+    stream.write(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+static std::optional<std::string> write_scenario(ScenarioGenerator& generator, std::ofstream& stream)
+{
+    auto building = generator.generate_building();
+    if (building.has_error())
+        return "Building has error not writing to file";
+
+    auto& blueprint = building.blueprint();
+
+    FileHeader header {};
+    std::memcpy(header.magic, ScenarioFile::magic, sizeof(header.magic));
+    header.version = ScenarioFile::version;
+    header.group_count = static_cast<uint32_t>(blueprint.reachable_per_group.size());
+    header.elevator_count = static_cast<uint32_t>(blueprint.elevators.size());
+    // Written again once the request count is known.
+    write_value(stream, header);
+
+    for (auto& reachable : blueprint.reachable_per_group) {
+        std::vector<Height> floors { reachable.begin(), reachable.end() };
+        std::sort(floors.begin(), floors.end());
+        write_value(stream, static_cast<uint32_t>(floors.size()));
+        stream.write(reinterpret_cast<char const*>(floors.data()), static_cast<std::streamsize>(floors.size() * sizeof(Height)));
+    }
+
+    for (auto& elevator : blueprint.elevators)
+        write_value(stream, ElevatorRecord { elevator.group, elevator.max_capacity, elevator.speed });
+
+    while (static_cast<size_t>(stream.tellp()) % alignof(RequestRecord) != 0)
+        stream.put('\0');
+    header.requests_offset = static_cast<uint64_t>(stream.tellp());
+
+    std::optional<Time> last_time;
+    while (true) {
+        auto next = generator.next_requests_at();
+        if (next.type == NextRequests::Type::Done)
+            break;
+        if (next.type == NextRequests::Type::Unknown)
+            return "Generator does not know when its next requests are";
+        if (last_time.has_value() && next.next_request_time <= *last_time)
+            return "Generator requests are not in order";
+        last_time = next.next_request_time;
+
+        for (auto& request : generator.requests_at(next.next_request_time)) {
+            write_value(stream, RequestRecord { next.next_request_time, request.from, request.to, request.group, request.capacity });
+            ++header.request_count;
+        }
+    }
+
+    stream.seekp(0);
+    write_value(stream, header);
+    return std::nullopt;
+}
+
+std::optional<std::string> write_scenario_file(ScenarioGenerator& generator, std::string const& path)
+{
+    // Only renamed to path once complete, so a failed write never leaves a partial scenario behind.
+    auto partial_path = path + ".partial";
+    std::ofstream stream(partial_path, std::ios::binary | std::ios::trunc);
+    if (!stream)
+        return "Could not open " + partial_path;
+
+    auto error = write_scenario(generator, stream);
+    stream.close();
+    if (!error.has_value() && !stream)
+        error = "Failed to write " + partial_path;
+
+    std::error_code filesystem_error;
+    if (!error.has_value()) {
+        std::filesystem::rename(partial_path, path, filesystem_error);
+        if (filesystem_error)
+            error = "Could not move the scenario to " + path + ": " + filesystem_error.message();
+    }
+
+    if (error.has_value())
+        std::filesystem::remove(partial_path, filesystem_error);
+    return error;
+}
+
+MappedScenarioGenerator::MappedScenarioGenerator(std::string const& path)
+{
+    load(path);
+}
+
+void MappedScenarioGenerator::load(std::string const& path)
+{
+    m_file = util::MappedFile::open(path);
+    if (!m_file) {
+        m_failed_string = "Could not open scenario file " + path;
+        return;
+    }
+
+    auto bytes = m_file->bytes();
+    size_t offset = 0;
+    auto read = [&]<typename T>(T& value) {
+        if (bytes.size() - offset < sizeof(T))
+            return false;
+        std::memcpy(&value, bytes.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    };
+
+    FileHeader header {};
+    if (!read(header) || std::memcmp(header.magic, ScenarioFile::magic, sizeof(header.magic)) != 0) {
+        m_failed_string = "Not a scenario file";
+        return;
+    }
+
+    if (header.version != ScenarioFile::version) {
+        m_failed_string = "Unsupported scenario file version " + std::to_string(header.version);
+        return;
+    }
+
+    m_building.reachable_per_group.resize(header.group_count);
+    for (auto& reachable : m_building.reachable_per_group) {
+        uint32_t floor_count = 0;
+        if (!read(floor_count) || floor_count > (bytes.size() - offset) / sizeof(Height)) {
+            m_failed_string = "Scenario file is truncated";
+            return;
+        }
+        for (uint32_t i = 0; i < floor_count; ++i) {
+            Height floor {};
+            read(floor);
+            reachable.insert(floor);
+        }
+    }
+
+    m_building.elevators.reserve(header.elevator_count);
+    for (uint32_t i = 0; i < header.elevator_count; ++i) {
+        ElevatorRecord elevator {};
+        if (!read(elevator)) {
+            m_failed_string = "Scenario file is truncated";
+            return;
+        }
+        m_building.elevators.push_back({ elevator.group, elevator.max_capacity, elevator.speed });
+    }
+
+    if (header.requests_offset < offset || header.requests_offset % alignof(RequestRecord) != 0
+        || header.requests_offset > bytes.size()
+        || header.request_count > (bytes.size() - header.requests_offset) / sizeof(RequestRecord)) {
+        m_failed_string = "Scenario file is truncated";
+        return;
+    }
+
+    // The mapping is page aligned and the offset is aligned to the records, so they can be used in place.
+    // The order is not checked here, that would read the whole file up front. Files are written
+    // in order, and should one not be the simulation fails once the request times go backwards.
+    m_requests = { reinterpret_cast<RequestRecord const*>(bytes.data() + header.requests_offset), static_cast<size_t>(header.request_count) };
+}
+
+BuildingGenerationResult MappedScenarioGenerator::generate_building()
+{
+    BuildingGenerationResult result { m_building };
+    if (!m_failed_string.empty())
+        result.add_error(m_failed_string);
+    return result;
+}
+
+NextRequests MappedScenarioGenerator::next_requests_at()
+{
+    if (m_next >= m_requests.size())
+        return NextRequests::done();
+    return m_requests[m_next].at;
+}
+
+std::span<RequestRecord const> MappedScenarioGenerator::request_records_at(Time time)
+{
+    ASSERT(m_next < m_requests.size());
+    ASSERT(time == m_requests[m_next].at);
+
+    size_t start = m_next;
+    while (m_next < m_requests.size() && m_requests[m_next].at == time)
+        ++m_next;
+
+    return m_requests.subspan(start, m_next - start);
+}
+
+std::vector<PassengerBlueprint> MappedScenarioGenerator::requests_at(Time time)
+{
+    auto records = request_records_at(time);
+    std::vector<PassengerBlueprint> blueprints;
+    blueprints.reserve(records.size());
+    for (auto& record : records)
+        blueprints.push_back(record.blueprint());
+    return blueprints;
+}
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Generation.h"
+#include "../../../util/MappedFile.h"
+#include <optional>
+#include <span>
+#include <string>
+
+namespace Elevated {
+
+// Binary scenario files, meant to be mapped into memory instead of parsed.
+// All values are stored in native byte order. A file consists of:
+//  - FileHeader
+//  - For every group: a uint32_t count followed by that many reachable Heights (sorted)
+//  - For every elevator: an ElevatorRecord
+//  - Padding up to header.requests_offset
+//  - header.request_count RequestRecords sorted by time
+namespace ScenarioFile {
+
+static constexpr char magic[8] = { 'E', 'L', 'E', 'V', 'S', 'C', 'N', '\0' };
+static constexpr uint32_t version = 1;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint32_t group_count;
+    uint32_t elevator_count;
+    uint64_t request_count;
+    uint64_t requests_offset;
+};
+
+struct ElevatorRecord {
+    GroupID group;
+    Capacity max_capacity;
+    Height speed;
+};
+
+struct RequestRecord {
+    Time at;
+    Height from;
+    Height to;
+    GroupID group;
+    Capacity capacity;
+
+    [[nodiscard]] PassengerBlueprint blueprint() const { return { from, to, group, capacity }; }
+};
+
+static_assert(sizeof(FileHeader) == 40);
+static_assert(sizeof(ElevatorRecord) == 12);
+static_assert(sizeof(RequestRecord) == 20);
+
+}
+
+// Runs the generator to the end and writes everything it generates to path.
+// Returns the reason if the scenario could not be written, path is then left untouched.
+std::optional<std::string> write_scenario_file(ScenarioGenerator& generator, std::string const& path);
+
+// Serves a scenario file directly from the mapped file, the requests are never all loaded.
+class MappedScenarioGenerator final : public ScenarioGenerator {
+public:
+    explicit MappedScenarioGenerator(std::string const& path);
+
+    BuildingGenerationResult generate_building() override;
+
+    NextRequests next_requests_at() override;
+
+    std::vector<PassengerBlueprint> requests_at(Time time) override;
+
+    // Same as requests_at but without copying the requests out of the file.
+    std::span<ScenarioFile::RequestRecord const> request_records_at(Time time);
+
+    [[nodiscard]] size_t total_requests() const { return m_requests.size(); }
+
+private:
+    void load(std::string const& path);
+
+    std::unique_ptr<util::MappedFile> m_file;
+    BuildingBlueprint m_building;
+    std::span<ScenarioFile::RequestRecord const> m_requests;
+    size_t m_next { 0 };
+    std::string m_failed_string;
+};
+
+}
@@ -0,0 +1,127 @@
+#include "CompiledScenario.h"
+#include "FactoryFactory.h"
+#include "OutputSettings.h"
+
+namespace Elevated {
+
+namespace {
+
+// Keeps every value as it is, like OutputSettings but without writing anything.
+class ReplaySettings final : public GeneratorSettings {
+public:
+    void varargsValue(std::string_view, const std::function<void(GeneratorSettings&, size_t, bool)>& func, size_t& count) override
+    {
+        for (size_t i = 0; i < count; i++)
+            func(*this, i, false);
+    }
+
+    void boolValue(std::string_view, bool&) override { }
+    void stringValue(std::string_view, std::string&) override { }
+    void optionValue(std::string_view, size_t&, const std::vector<std::string>&) override { }
+
+    bool hasFailed() override { return m_failed; }
+
+protected:
+    void startGroup(const std::string&) override { }
+    void endGroup(const std::string&) override { }
+    void getIntegerValue(std::string_view, int&, int, int) override { }
+    void getUnsignedValue(std::string_view, uint32_t&, int, int) override { }
+    void getDoubleValue(std::string_view, double&, double, double) override { }
+
+    void addError(const std::string&, bool error) override
+    {
+        if (error)
+            m_failed = true;
+    }
+
+private:
+    bool m_failed { false };
+};
+
+}
+
+CompiledScenario::CompiledScenario(std::string value)
+    : m_value(std::move(value))
+    , m_factory(scenarioFactories().createGenerator("root"))
+{
+}
+
+CompiledScenario::CompileResult CompiledScenario::compile(std::string const& value)
+{
+    auto scenario = std::make_shared<CompiledScenario>(value);
+    // The seed does not matter here, only the values which end up in the factories.
+    auto result = parse_scenario_into(*scenario->m_factory, value, 0);
+
+    CompileResult compiled;
+    compiled.errors = std::move(result.errors);
+    if (result.generator) {
+        OutputSettings output;
+        scenario->m_factory->visit(output);
+        scenario->m_canonical = output.value();
+        compiled.scenario = std::move(scenario);
+    }
+    return compiled;
+}
+
+std::unique_ptr<ScenarioGenerator> CompiledScenario::instantiate(long seed) const
+{
+    ReplaySettings settings;
+    settings.set_initial_seed(seed);
+
+    std::lock_guard lock(m_lock);
+    auto generator = m_factory->visit(settings);
+    ASSERT(!settings.hasFailed());
+    return generator;
+}
+
+ScenarioCache::ScenarioCache(size_t capacity)
+    : m_capacity(capacity)
+{
+    ASSERT(m_capacity > 0);
+}
+
+CompiledScenario::CompileResult ScenarioCache::compile(std::string const& value)
+{
+    {
+        std::lock_guard lock(m_lock);
+        if (auto it = m_lookup.find(value); it != m_lookup.end()) {
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            return it->second->second;
+        }
+    }
+
+    // Compiled outside the lock, if another thread compiles the same string meanwhile one of them is kept.
+    auto compiled = CompiledScenario::compile(value);
+
+    std::lock_guard lock(m_lock);
+    if (auto it = m_lookup.find(value); it != m_lookup.end()) {
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return it->second->second;
+    }
+
+    m_entries.emplace_front(value, compiled);
+    m_lookup.emplace(value, m_entries.begin());
+    if (m_entries.size() > m_capacity) {
+        m_lookup.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+    return compiled;
+}
+
+ScenarioResult ScenarioCache::parse(std::string const& value, long seed)
+{
+    auto compiled = compile(value);
+    ScenarioResult result {};
+    result.errors = std::move(compiled.errors);
+    if (compiled.scenario)
+        result.generator = compiled.scenario->instantiate(seed);
+    return result;
+}
+
+size_t ScenarioCache::size() const
+{
+    std::lock_guard lock(m_lock);
+    return m_entries.size();
+}
+
+}
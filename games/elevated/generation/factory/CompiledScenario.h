@@ -0,0 +1,70 @@
+#pragma once
+
+#include "../Generation.h"
+#include "GeneratorSettings.h"
+#include "StringSettings.h"
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Elevated {
+
+// A scenario string parsed once. The factories keep every parsed value, so making a
+// generator for a seed only walks the factories again without reading the string.
+// instantiate gives the same generator as parse_scenario with that seed.
+class CompiledScenario {
+public:
+    struct CompileResult {
+        // Null if the scenario string is invalid.
+        std::shared_ptr<CompiledScenario const> scenario;
+        // The errors and warnings as parse_scenario reports them.
+        std::vector<std::string> errors;
+    };
+
+    static CompileResult compile(std::string const& value);
+
+    [[nodiscard]] std::unique_ptr<ScenarioGenerator> instantiate(long seed) const;
+
+    [[nodiscard]] std::string const& value() const { return m_value; }
+
+    // The scenario written out with every value, strings giving the same scenario
+    // (e.g. with different spacing) have the same canonical form.
+    [[nodiscard]] std::string const& canonical() const { return m_canonical; }
+
+    explicit CompiledScenario(std::string value);
+
+private:
+    std::string m_value;
+    std::string m_canonical;
+
+    // Visiting the factories updates their state (to the same values), so it must not happen concurrently.
+    mutable std::mutex m_lock;
+    std::unique_ptr<CompoundGenerator<ScenarioGenerator>> m_factory;
+};
+
+// Compiled scenarios keyed by scenario string, evicting the least recently used.
+class ScenarioCache {
+public:
+    explicit ScenarioCache(size_t capacity = 64);
+
+    CompiledScenario::CompileResult compile(std::string const& value);
+
+    // Drop in replacement for parse_scenario.
+    ScenarioResult parse(std::string const& value, long seed);
+
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] size_t capacity() const { return m_capacity; }
+
+private:
+    size_t m_capacity;
+
+    mutable std::mutex m_lock;
+    using Entry = std::pair<std::string, CompiledScenario::CompileResult>;
+    // Most recently used at the front.
+    std::list<Entry> m_entries;
+    std::unordered_map<std::string, std::list<Entry>::iterator> m_lookup;
+};
+
+}
@@ -25,7 +25,7 @@ static GeneratorFactories<BuildingGenerator> s_buildingFactories;
 static GeneratorFactories<FloorGenerator> s_floor_factories;
 static GeneratorFactories<ElevatorGenerator> s_elevator_factories;
 
-static std::vector<std::string> scenarios_names = {"h1", "basic-1", "basic-2", "basic-3", "basic-4", "koppele-1", "koppele-2", "koppele-3", "ruben-1", "ruben-1-2", "ruben-2", "ruben-2-2", "meta-1", "meta-2", "meta-3", "meta-4", "reverse-1", "reverse-2", "reverse-3"};
+static std::vector<std::string> scenarios_names = {"h1", "basic-1", "basic-2", "basic-3", "basic-4", "koppele-1", "koppele-2", "koppele-3", "ruben-1", "ruben-1-2", "ruben-2", "ruben-2-2", "meta-1", "meta-2", "meta-3", "meta-4", "reverse-1", "reverse-2", "reverse-3", "stress-1", "stress-2"};
 static std::vector<std::string> building_names = {"basic-1", "basic-2", "basic-3", "basic-4", "koppele", "ruben-1", "ruben-1-2", "ruben-2", "ruben-2-2", "meta"};
 static void init_factories() {
 
@@ -224,28 +224,36 @@ static void init_factories() {
         return std::make_unique<ForceDirectionGenerator>(std::move(created_requests), operation, settings.next_seed(), chance);
     });
 
-    s_requestFactories.addLambdaFactory("uniform-random", [amount = uint32_t(1u), mean = 0.1, capacity = 1u](GeneratorSettings& settings) mutable -> std::unique_ptr<RequestGenerator> {
-        settings.unsignedValue("Amount", amount, 1);
-        settings.doubleValue("Mean arrival time (exponential)", mean);
-        settings.unsignedValue("Capacity", capacity, 0);
-        if (mean <= 0.0) {
-            settings.encounteredError("Mean must be positive");
-            return nullptr;
-        }
-        return std::make_unique<UniformFloorGenerator>(settings.next_seed(), amount, mean, capacity);
-    });
+    // The bulk variants generate different requests from the same seed, but are a lot faster for many requests.
+    // Their amount range is too large for a slider, so the gui shows an input field for it.
+    using RandomSource = IndependentRequestGenerator::RandomSource;
+    constexpr int max_bulk_amount = 100'000'000;
+    for (auto [prefix, source, max_uniform_amount, max_ground_floor_amount] : {
+             std::tuple { "", RandomSource::Engine, 100, 1000 },
+             std::tuple { "bulk-", RandomSource::Counter, max_bulk_amount, max_bulk_amount } }) {
+        s_requestFactories.addLambdaFactory(std::string(prefix) + "uniform-random", [source, max_amount = max_uniform_amount, amount = uint32_t(1u), mean = 0.1, capacity = 1u](GeneratorSettings& settings) mutable -> std::unique_ptr<RequestGenerator> {
+            settings.unsignedValue("Amount", amount, 1, max_amount);
+            settings.doubleValue("Mean arrival time (exponential)", mean);
+            settings.unsignedValue("Capacity", capacity, 0);
+            if (mean <= 0.0) {
+                settings.encounteredError("Mean must be positive");
+                return nullptr;
+            }
+            return std::make_unique<UniformFloorGenerator>(settings.next_seed(), amount, mean, capacity, source);
+        });
 
-    s_requestFactories.addLambdaFactory("ground-floor-random", [amount = uint32_t(1u), mean = 0.1, capacity = 1u, ground_floor = 1u](GeneratorSettings& settings) mutable -> std::unique_ptr<RequestGenerator> {
-        settings.unsignedValue("Amount", amount, 1, 1000);
-        settings.doubleValue("Mean arrival time (exponential)", mean, 0.0, 1000.0);
-        settings.unsignedValue("Ground floor", ground_floor, 0, 1000);
-        settings.unsignedValue("Capacity", capacity, 0, 10000);
-        if (mean <= 0.0) {
-            settings.encounteredError("Mean must be positive");
-            return nullptr;
-        }
-        return std::make_unique<GroundFloorGenerator>(settings.next_seed(), amount, mean, ground_floor, capacity);
-    });
+        s_requestFactories.addLambdaFactory(std::string(prefix) + "ground-floor-random", [source, max_amount = max_ground_floor_amount, amount = uint32_t(1u), mean = 0.1, capacity = 1u, ground_floor = 1u](GeneratorSettings& settings) mutable -> std::unique_ptr<RequestGenerator> {
+            settings.unsignedValue("Amount", amount, 1, max_amount);
+            settings.doubleValue("Mean arrival time (exponential)", mean, 0.0, 1000.0);
+            settings.unsignedValue("Ground floor", ground_floor, 0, 1000);
+            settings.unsignedValue("Capacity", capacity, 0, 10000);
+            if (mean <= 0.0) {
+                settings.encounteredError("Mean must be positive");
+                return nullptr;
+            }
+            return std::make_unique<GroundFloorGenerator>(settings.next_seed(), amount, mean, ground_floor, capacity, source);
+        });
+    }
 }
 
 GeneratorFactories<ScenarioGenerator>& scenarioFactories() {
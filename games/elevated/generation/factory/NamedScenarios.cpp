@@ -133,6 +133,17 @@ std::unique_ptr<ScenarioGenerator> reverse_meta(size_t num_requests, long seed)
                 ));
 }
 
+std::unique_ptr<ScenarioGenerator> stress(size_t num_requests, long seed)
+{
+    using RandomSource = IndependentRequestGenerator::RandomSource;
+    return std::make_unique<SplitGenerator>(
+        meta_building(),
+        RequestCombiner::create(
+            std::make_unique<GroundFloorGenerator>(seed * 2, num_requests / 2, 0.5, 0, 1, RandomSource::Counter),
+            std::make_unique<UniformFloorGenerator>((long)(seed ^ 0xDF23847DD), num_requests / 2, 0.5, 1, RandomSource::Counter)
+                ));
+}
+
 std::unique_ptr<ScenarioGenerator> named_scenario(std::string string)
 {
     if (string == "h1")
@@ -209,6 +220,17 @@ std::unique_ptr<ScenarioGenerator> named_scenario(std::string string)
         }
     }
 
+    if (string.starts_with("stress-")) {
+        std::string_view details = string;
+        details.remove_prefix(7);
+
+        if (details == "1") {
+            return stress(100000, 5);
+        } else if (details == "2") {
+            return stress(1000000, 57);
+        }
+    }
+
     return nullptr;
 }
 
@@ -1,5 +1,5 @@
 #include "OutputSettings.h"
-
+#include <charconv>
 
 namespace Elevated {
 
@@ -78,7 +78,13 @@ void OutputSettings::getUnsignedValue(std::string_view, uint32_t& value, int, in
 }
 
 void OutputSettings::getDoubleValue(std::string_view, double& value, double, double) {
-    write(value);
+    // The shortest form which reads back as exactly the same value, the stream default
+    // of 6 significant digits would make different scenarios look the same.
+    char buffer[32];
+    auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    ASSERT(error == std::errc {});
+    std::string_view written { buffer, static_cast<size_t>(end - buffer) };
+    write(written);
 }
 
 void OutputSettings::addError(const std::string& message, bool error) {
@@ -4,17 +4,14 @@
 #include "FactoryFactory.h"
 #include "OutputSettings.h"
 
+#include <charconv>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <map>
 
 namespace Elevated {
 
-static const std::locale& customLocale()
-{
-    static auto locale = std::locale::classic();
-    return locale;
-}
-
 bool isOpeningParen(char c)
 {
     return c == '(' || c == '[' || c == '{';
@@ -47,6 +44,90 @@ StringSettings::StringSettings(std::string value)
 
 // end same with ),],}
 
+// Finds the longest prefix of value which istream extraction of T would consume.
+// Returns that length and whether the end of value was reached while looking.
+template<typename T>
+static std::pair<size_t, bool> scanNumber(std::string_view value)
+{
+    size_t index = 0;
+    auto isDigit = [&] { return index < value.size() && value[index] >= '0' && value[index] <= '9'; };
+
+    if (index < value.size() && (value[index] == '+' || value[index] == '-'))
+        ++index;
+
+    bool foundDigits = false;
+    while (isDigit()) {
+        ++index;
+        foundDigits = true;
+    }
+
+    if constexpr (std::is_floating_point_v<T>) {
+        if (index < value.size() && value[index] == '.') {
+            ++index;
+            while (isDigit()) {
+                ++index;
+                foundDigits = true;
+            }
+        }
+
+        if (foundDigits && index < value.size() && (value[index] == 'e' || value[index] == 'E')) {
+            ++index;
+            if (index < value.size() && (value[index] == '+' || value[index] == '-'))
+                ++index;
+            while (isDigit())
+                ++index;
+        }
+    }
+
+    return { index, index == value.size() };
+}
+
+// Converts exactly the scanned characters with the same results as istream extraction
+// in the classic locale, including the value written on failure.
+template<typename T>
+static bool convertNumber(std::string_view scanned, T& ref)
+{
+    bool negative = !scanned.empty() && scanned.front() == '-';
+    if (!scanned.empty() && (scanned.front() == '+' || (negative && !std::is_signed_v<T>)))
+        scanned.remove_prefix(1);
+
+    if constexpr (std::is_floating_point_v<T>) {
+        T value {};
+        auto [end, error] = std::from_chars(scanned.data(), scanned.data() + scanned.size(), value);
+        if (error == std::errc::result_out_of_range) {
+            // Underflow is accepted by istream but not by from_chars, let strtod decide.
+            std::string copy { scanned };
+            value = std::strtod(copy.c_str(), nullptr);
+            if (value == HUGE_VAL || value == -HUGE_VAL) {
+                ref = value > 0 ? std::numeric_limits<T>::max() : -std::numeric_limits<T>::max();
+                return false;
+            }
+            ref = value;
+            return true;
+        }
+        if (error != std::errc {} || end != scanned.data() + scanned.size()) {
+            ref = 0;
+            return false;
+        }
+        ref = value;
+        return true;
+    } else {
+        T value {};
+        auto [end, error] = std::from_chars(scanned.data(), scanned.data() + scanned.size(), value);
+        if (error == std::errc::result_out_of_range) {
+            ref = negative && std::is_signed_v<T> ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+            return false;
+        }
+        if (error != std::errc {} || end != scanned.data() + scanned.size()) {
+            ref = 0;
+            return false;
+        }
+        // Like istream, negative values wrap around for unsigned types.
+        ref = negative && !std::is_signed_v<T> ? static_cast<T>(-value) : value;
+        return true;
+    }
+}
+
 template<typename T>
 bool StringSettings::readFromPartialString(T& ref, size_t to)
 {
@@ -56,21 +137,15 @@ bool StringSettings::readFromPartialString(T& ref, size_t to)
         stringError("No more characters left to read from", true, m_location);
         return false;
     }
-    std::string value = m_value.substr(m_location, to - m_location);
-    std::istringstream stream(value);
-    stream.imbue(customLocale());
-    stream >> ref;
-
-    bool succeeded = !stream.fail();
-    //    if (!succeeded) {
-    //        stringError(fmt::format("Failed to read {} from '{}'", typeid(T).name(), value), true,
-    //        m_location, to);
-    //    }
-    if (!stream.eof()) {
-        std::string leftOverString;
-        size_t currentIndex = static_cast<size_t>(stream.tellg());
-        std::getline(stream, leftOverString);
-        stringError("Unused input, skipping over: '" + leftOverString + "'", true,
+    std::string_view value = std::string_view { m_value }.substr(m_location, to - m_location);
+    auto [scannedLength, reachedEnd] = scanNumber<T>(value);
+    bool succeeded = convertNumber(value.substr(0, scannedLength), ref);
+
+    if (!reachedEnd) {
+        // A failed extraction does not know its position (tellg gives -1) and has nothing left to skip.
+        size_t currentIndex = succeeded ? scannedLength : static_cast<size_t>(-1);
+        std::string_view leftOver = succeeded ? value.substr(scannedLength) : std::string_view {};
+        stringError("Unused input, skipping over: '" + std::string(leftOver) + "'", true,
             m_location + currentIndex, to);
     }
     consumeSeparator(to);
@@ -358,15 +433,13 @@ void StringSettings::stringError(const std::string& message, bool error, size_t
         // probably nothing
         from = m_location;
     }
-    std::stringstream ss;
-
-    ss << message;
+    std::string fullMessage = message;
 
     for (auto it = m_groups.rbegin(); it != m_groups.rend(); it++) {
-        ss << " while processing'" << std::get<2>(*it) << "' ";
+        fullMessage += " while processing'" + std::get<2>(*it) + "' ";
     }
 
-    m_errors.push_back(ErrorMessage { ss.str(), error, from, to });
+    m_errors.push_back(ErrorMessage { std::move(fullMessage), error, from, to });
 }
 
 void StringSettings::varargsValue(std::string_view name,
@@ -506,13 +579,18 @@ void StringSettings::consumeSeparator(size_t loc)
 }
 
 ScenarioResult parse_scenario(const std::string& value, long initial_seed)
+{
+    auto factory = scenarioFactories().createGenerator("root");
+    return parse_scenario_into(*factory, value, initial_seed);
+}
+
+ScenarioResult parse_scenario_into(CompoundGenerator<ScenarioGenerator>& factory, const std::string& value, long initial_seed)
 {
     StringSettings bSettings { value };
     ProxyOutputSettings settings { bSettings };
     settings.set_initial_seed(initial_seed);
-    auto factory = scenarioFactories().createGenerator("root");
     ScenarioResult result{};
-    result.generator = factory->visit(settings);
+    result.generator = factory.visit(settings);
     if (bSettings.hasFailed())
         result.generator = nullptr;
 
@@ -17,6 +17,9 @@ struct ScenarioResult {
 
 ScenarioResult parse_scenario(const std::string& value, long initial_seed);
 
+// Same as parse_scenario but visits the given factory, which keeps all parsed values afterwards.
+ScenarioResult parse_scenario_into(CompoundGenerator<ScenarioGenerator>& factory, const std::string& value, long initial_seed);
+
 class StringSettings : public GeneratorSettings {
 private:
     std::string m_value;
@@ -0,0 +1,164 @@
+#include "AsyncEventPipeline.h"
+#include "../../../util/Assertions.h"
+
+namespace Elevated {
+
+AsyncEventPipeline::AsyncEventPipeline(EventListener& target, size_t queued_events)
+    : m_target(target)
+    , m_records(queued_events)
+{
+}
+
+AsyncEventPipeline::~AsyncEventPipeline()
+{
+    if (!m_consumer.joinable())
+        return;
+
+    m_records.close();
+    m_consumer.join();
+}
+
+void AsyncEventPipeline::start(std::vector<ElevatorState> elevators)
+{
+    ASSERT(!m_consumer.joinable());
+    m_elevators = std::move(elevators);
+    for (auto& elevator : m_elevators) {
+        for (auto& passenger : elevator.passengers())
+            m_elevator_of_passenger.emplace(passenger.id, elevator.id);
+    }
+    m_consumer = std::thread([this] { consume(); });
+}
+
+void AsyncEventPipeline::flush()
+{
+    // Without being started no event can have been given.
+    if (!m_consumer.joinable())
+        return;
+    m_records.wait_until_empty();
+}
+
+AsyncEventPipeline::Record AsyncEventPipeline::passenger_record(Record::Type type, Time at, Passenger const& passenger, uint32_t first)
+{
+    return { type, ElevatorState::State::Stopped, at, first, 0, passenger.id, passenger.from, passenger.to, passenger.group, passenger.capacity };
+}
+
+AsyncEventPipeline::Record AsyncEventPipeline::elevator_record(Record::Type type, Time at, ElevatorState const& elevator, uint32_t first, uint32_t second)
+{
+    return { type, elevator.current_state(), at, first, second, elevator.id, elevator.height(), elevator.target_height(), 0, 0 };
+}
+
+void AsyncEventPipeline::push(Record const& record)
+{
+    ASSERT(m_consumer.joinable());
+    while (!m_records.try_emplace(record)) {
+        if (!m_records.wait_for_space())
+            return;
+    }
+}
+
+void AsyncEventPipeline::on_request_created(Time at, Passenger const& passenger)
+{
+    push(passenger_record(Record::Type::RequestCreated, at, passenger, 0));
+}
+
+void AsyncEventPipeline::on_passenger_enter_elevator(Time at, Passenger const& passenger, ElevatorID id)
+{
+    push(passenger_record(Record::Type::PassengerEntered, at, passenger, id));
+}
+
+void AsyncEventPipeline::on_passenger_leave_elevator(Time at, PassengerID id, Height height)
+{
+    push({ Record::Type::PassengerLeft, ElevatorState::State::Stopped, at, id, height, 0, 0, 0, 0, 0 });
+}
+
+void AsyncEventPipeline::on_elevator_opened_doors(Time at, ElevatorState const& elevator)
+{
+    push(elevator_record(Record::Type::DoorsOpened, at, elevator, 0, 0));
+}
+
+void AsyncEventPipeline::on_elevator_closed_doors(Time at, ElevatorState const& elevator)
+{
+    push(elevator_record(Record::Type::DoorsClosed, at, elevator, 0, 0));
+}
+
+void AsyncEventPipeline::on_elevator_set_target(Time at, Height new_target, ElevatorState const& elevator)
+{
+    push(elevator_record(Record::Type::TargetSet, at, elevator, new_target, 0));
+}
+
+void AsyncEventPipeline::on_elevator_stopped(Time at, Time duration, ElevatorState const& elevator)
+{
+    push(elevator_record(Record::Type::Stopped, at, elevator, duration, 0));
+}
+
+void AsyncEventPipeline::on_elevator_moved(Time at, Height distance, Height before_height, ElevatorState const& elevator)
+{
+    push(elevator_record(Record::Type::Moved, at, elevator, distance, before_height));
+}
+
+void AsyncEventPipeline::consume()
+{
+    while (m_records.wait_for_item()) {
+        // Only pop after dispatching, so an empty ring means every event was handled.
+        dispatch(*m_records.front());
+        m_records.pop();
+    }
+}
+
+ElevatorState& AsyncEventPipeline::follow_elevator(Record const& record)
+{
+    ASSERT(record.id < m_elevators.size());
+    auto& elevator = m_elevators[record.id];
+    elevator.m_height = record.height;
+    elevator.m_target_height = record.target_height;
+    elevator.m_state = record.state;
+    return elevator;
+}
+
+void AsyncEventPipeline::dispatch(Record const& record)
+{
+    auto passenger = [&] {
+        return Passenger { record.id, PassengerBlueprint { record.height, record.target_height, record.group, record.capacity } };
+    };
+
+    switch (record.type) {
+    case Record::Type::RequestCreated:
+        m_target.on_request_created(record.at, passenger());
+        break;
+    case Record::Type::PassengerEntered: {
+        ASSERT(record.first < m_elevators.size());
+        m_elevators[record.first].m_passengers.add({ record.id, record.target_height, record.capacity });
+        m_elevator_of_passenger[record.id] = record.first;
+        m_target.on_passenger_enter_elevator(record.at, passenger(), record.first);
+        break;
+    }
+    case Record::Type::PassengerLeft: {
+        // Everyone going to this floor leaves at once, the other leave events of this floor find nobody.
+        auto elevator_or_end = m_elevator_of_passenger.find(record.first);
+        ASSERT(elevator_or_end != m_elevator_of_passenger.end());
+        if (elevator_or_end != m_elevator_of_passenger.end()) {
+            m_elevators[elevator_or_end->second].m_passengers.remove_all_to(record.second);
+            m_elevator_of_passenger.erase(elevator_or_end);
+        }
+        m_target.on_passenger_leave_elevator(record.at, record.first, record.second);
+        break;
+    }
+    case Record::Type::DoorsOpened:
+        m_target.on_elevator_opened_doors(record.at, follow_elevator(record));
+        break;
+    case Record::Type::DoorsClosed:
+        m_target.on_elevator_closed_doors(record.at, follow_elevator(record));
+        break;
+    case Record::Type::TargetSet:
+        m_target.on_elevator_set_target(record.at, record.first, follow_elevator(record));
+        break;
+    case Record::Type::Stopped:
+        m_target.on_elevator_stopped(record.at, record.first, follow_elevator(record));
+        break;
+    case Record::Type::Moved:
+        m_target.on_elevator_moved(record.at, record.first, record.second, follow_elevator(record));
+        break;
+    }
+}
+
+}
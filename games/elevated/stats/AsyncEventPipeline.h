@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Listener.h"
+#include "../../../util/SpscRing.h"
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+
+namespace Elevated {
+
+// Hands events to another listener on a separate thread, so the listeners do not
+// slow down the simulation itself.
+// The target gets copies of the elevators which follow the events, these only
+// have the same id, height, target, state and passengers as the real elevator had.
+class AsyncEventPipeline final : public EventListener {
+public:
+    AsyncEventPipeline(EventListener& target, size_t queued_events = 4096);
+    ~AsyncEventPipeline() override;
+
+    // Must be called with the elevators of the building before any event.
+    void start(std::vector<ElevatorState> elevators);
+
+    // Blocks until the target has handled every event given so far.
+    void flush();
+
+    virtual void on_request_created(Time at, Passenger const& passenger) override;
+    virtual void on_passenger_enter_elevator(Time at, Passenger const& passenger, ElevatorID id) override;
+    virtual void on_passenger_leave_elevator(Time at, PassengerID id, Height height) override;
+    virtual void on_elevator_opened_doors(Time at, ElevatorState const& elevator) override;
+    virtual void on_elevator_closed_doors(Time at, ElevatorState const& elevator) override;
+    virtual void on_elevator_set_target(Time at, Height new_target, ElevatorState const& elevator) override;
+    virtual void on_elevator_stopped(Time at, Time duration, ElevatorState const& elevator) override;
+    virtual void on_elevator_moved(Time at, Height distance, Height before_height, ElevatorState const& elevator) override;
+
+private:
+    struct Record {
+        enum class Type : uint8_t {
+            RequestCreated,
+            PassengerEntered,
+            PassengerLeft,
+            DoorsOpened,
+            DoorsClosed,
+            TargetSet,
+            Stopped,
+            Moved,
+        };
+
+        Type type;
+        ElevatorState::State state;
+        Time at;
+        uint32_t first;
+        uint32_t second;
+
+        // Either the passenger or the elevator, depending on the type.
+        uint32_t id;
+        Height height;
+        Height target_height;
+        GroupID group;
+        Capacity capacity;
+    };
+    static_assert(std::is_trivially_copyable_v<Record>);
+
+    static Record passenger_record(Record::Type type, Time at, Passenger const& passenger, uint32_t first);
+    static Record elevator_record(Record::Type type, Time at, ElevatorState const& elevator, uint32_t first, uint32_t second);
+
+    void push(Record const& record);
+    void consume();
+    void dispatch(Record const& record);
+    ElevatorState& follow_elevator(Record const& record);
+
+    EventListener& m_target;
+    util::SpscRing<Record> m_records;
+    std::thread m_consumer;
+
+    // Only touched by the consumer thread.
+    std::vector<ElevatorState> m_elevators;
+    std::unordered_map<PassengerID, ElevatorID> m_elevator_of_passenger;
+};
+
+}
@@ -0,0 +1,80 @@
+#include "EventBuffer.h"
+#include "../../../util/Assertions.h"
+
+namespace Elevated {
+
+void EventBuffer::on_request_created(Time at, Passenger const& passenger)
+{
+    m_events.push_back({Event::Type::RequestCreated, at, 0, 0, nullptr, passenger});
+}
+
+void EventBuffer::on_passenger_enter_elevator(Time at, Passenger const& passenger, ElevatorID id)
+{
+    m_events.push_back({Event::Type::PassengerEntered, at, id, 0, nullptr, passenger});
+}
+
+void EventBuffer::on_passenger_leave_elevator(Time at, PassengerID id, Height height)
+{
+    m_events.push_back({Event::Type::PassengerLeft, at, id, height, nullptr, std::nullopt});
+}
+
+void EventBuffer::on_elevator_opened_doors(Time at, ElevatorState const& elevator)
+{
+    m_events.push_back({Event::Type::DoorsOpened, at, 0, 0, &elevator, std::nullopt});
+}
+
+void EventBuffer::on_elevator_closed_doors(Time at, ElevatorState const& elevator)
+{
+    m_events.push_back({Event::Type::DoorsClosed, at, 0, 0, &elevator, std::nullopt});
+}
+
+void EventBuffer::on_elevator_set_target(Time at, Height new_target, ElevatorState const& elevator)
+{
+    m_events.push_back({Event::Type::TargetSet, at, new_target, 0, &elevator, std::nullopt});
+}
+
+void EventBuffer::on_elevator_stopped(Time at, Time duration, ElevatorState const& elevator)
+{
+    m_events.push_back({Event::Type::Stopped, at, duration, 0, &elevator, std::nullopt});
+}
+
+void EventBuffer::on_elevator_moved(Time at, Height distance, Height before_height, ElevatorState const& elevator)
+{
+    m_events.push_back({Event::Type::Moved, at, distance, before_height, &elevator, std::nullopt});
+}
+
+void EventBuffer::replay_into(EventListener& listener)
+{
+    for (auto& event : m_events) {
+        switch (event.type) {
+        case Event::Type::RequestCreated:
+            listener.on_request_created(event.at, event.passenger.value());
+            break;
+        case Event::Type::PassengerEntered:
+            listener.on_passenger_enter_elevator(event.at, event.passenger.value(), event.first);
+            break;
+        case Event::Type::PassengerLeft:
+            listener.on_passenger_leave_elevator(event.at, event.first, event.second);
+            break;
+        case Event::Type::DoorsOpened:
+            listener.on_elevator_opened_doors(event.at, *event.elevator);
+            break;
+        case Event::Type::DoorsClosed:
+            listener.on_elevator_closed_doors(event.at, *event.elevator);
+            break;
+        case Event::Type::TargetSet:
+            listener.on_elevator_set_target(event.at, event.first, *event.elevator);
+            break;
+        case Event::Type::Stopped:
+            listener.on_elevator_stopped(event.at, event.first, *event.elevator);
+            break;
+        case Event::Type::Moved:
+            listener.on_elevator_moved(event.at, event.first, event.second, *event.elevator);
+            break;
+        }
+    }
+
+    m_events.clear();
+}
+
+}
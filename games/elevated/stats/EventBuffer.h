@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Listener.h"
+#include <optional>
+
+namespace Elevated {
+
+// Stores events so they can be handed to another listener later, this is used
+// to collect the events of work done on another thread.
+// Elevators are stored by reference so they must not change before replaying.
+class EventBuffer final : public EventListener {
+public:
+    virtual void on_request_created(Time at, Passenger const& passenger) override;
+    virtual void on_passenger_enter_elevator(Time at, Passenger const& passenger, ElevatorID id) override;
+    virtual void on_passenger_leave_elevator(Time at, PassengerID id, Height height) override;
+    virtual void on_elevator_opened_doors(Time at, ElevatorState const& elevator) override;
+    virtual void on_elevator_closed_doors(Time at, ElevatorState const& elevator) override;
+    virtual void on_elevator_set_target(Time at, Height new_target, ElevatorState const& elevator) override;
+    virtual void on_elevator_stopped(Time at, Time duration, ElevatorState const& elevator) override;
+    virtual void on_elevator_moved(Time at, Height distance, Height before_height, ElevatorState const& elevator) override;
+
+    [[nodiscard]] bool empty() const { return m_events.empty(); }
+
+    // Sends all stored events to the listener in the order they were received
+    // and clears the buffer.
+    void replay_into(EventListener& listener);
+
+private:
+    struct Event {
+        enum class Type : uint8_t {
+            RequestCreated,
+            PassengerEntered,
+            PassengerLeft,
+            DoorsOpened,
+            DoorsClosed,
+            TargetSet,
+            Stopped,
+            Moved,
+        };
+
+        Type type;
+        Time at;
+        uint32_t first { 0 };
+        uint32_t second { 0 };
+        ElevatorState const* elevator { nullptr };
+        std::optional<Passenger> passenger;
+    };
+
+    std::vector<Event> m_events;
+};
+
+}
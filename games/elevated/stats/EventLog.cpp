@@ -0,0 +1,162 @@
+#include "EventLog.h"
+#include "../../../util/Assertions.h"
+#include <cstring>
+
+namespace Elevated {
+
+void EventLog::add(Time at, Kind kind, ElevatorState::State state, ElevatorID elevator, PassengerID passenger, Height height, uint32_t value, uint32_t detail)
+{
+    m_times.push_back(at);
+    m_kinds.push_back(kind);
+    m_states.push_back(static_cast<uint8_t>(state));
+    m_elevators.push_back(elevator);
+    m_passengers.push_back(passenger);
+    m_heights.push_back(height);
+    m_values.push_back(value);
+    m_details.push_back(detail);
+}
+
+void EventLog::add_elevator_event(Time at, Kind kind, ElevatorState const& elevator, uint32_t value, uint32_t detail)
+{
+    add(at, kind, elevator.current_state(), elevator.id, no_passenger, elevator.height(), value, detail);
+}
+
+void EventLog::on_initial_building(BuildingBlueprint const& blueprint)
+{
+    m_elevator_count = static_cast<uint32_t>(blueprint.elevators.size());
+}
+
+void EventLog::on_request_created(Time at, Passenger const& passenger)
+{
+    add(at, Kind::RequestCreated, ElevatorState::State::Stopped, no_elevator, passenger.id, passenger.from, passenger.to, passenger.capacity);
+}
+
+void EventLog::on_passenger_enter_elevator(Time at, Passenger const& passenger, ElevatorID id)
+{
+    m_elevator_of_passenger[passenger.id] = id;
+    add(at, Kind::PassengerEntered, ElevatorState::State::DoorsOpen, id, passenger.id, passenger.from, passenger.to, passenger.capacity);
+}
+
+void EventLog::on_passenger_leave_elevator(Time at, PassengerID id, Height height)
+{
+    ElevatorID elevator = no_elevator;
+    if (auto elevator_or_end = m_elevator_of_passenger.find(id); elevator_or_end != m_elevator_of_passenger.end()) {
+        elevator = elevator_or_end->second;
+        m_elevator_of_passenger.erase(elevator_or_end);
+    }
+    add(at, Kind::PassengerLeft, ElevatorState::State::DoorsOpen, elevator, id, height, 0, 0);
+}
+
+void EventLog::on_elevator_opened_doors(Time at, ElevatorState const& elevator)
+{
+    add_elevator_event(at, Kind::DoorsOpened, elevator, 0, elevator.target_height());
+}
+
+void EventLog::on_elevator_closed_doors(Time at, ElevatorState const& elevator)
+{
+    add_elevator_event(at, Kind::DoorsClosed, elevator, 0, elevator.target_height());
+}
+
+void EventLog::on_elevator_set_target(Time at, Height new_target, ElevatorState const& elevator)
+{
+    add_elevator_event(at, Kind::TargetSet, elevator, new_target, elevator.target_height());
+}
+
+void EventLog::on_elevator_stopped(Time at, Time duration, ElevatorState const& elevator)
+{
+    add_elevator_event(at, Kind::Stopped, elevator, duration, elevator.target_height());
+}
+
+void EventLog::on_elevator_moved(Time at, Height distance, Height before_height, ElevatorState const& elevator)
+{
+    add_elevator_event(at, Kind::Moved, elevator, distance, before_height);
+}
+
+static constexpr char log_magic[8] = { 'E', 'L', 'E', 'V', 'L', 'O', 'G', '\0' };
+static constexpr uint32_t log_version = 1;
+
+struct LogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t elevators;
+    uint64_t events;
+};
+
+static_assert(sizeof(LogHeader) == 24);
+
+template<typename T>
+static void write_column(std::string& bytes, std::vector<T> const& column)
+{
+    bytes.append(reinterpret_cast<char const*>(column.data()), column.size() * sizeof(T));
+}
+
+template<typename T>
+static bool read_column(std::string_view& bytes, std::vector<T>& column, size_t count)
+{
+    if (bytes.size() / sizeof(T) < count)
+        return false;
+    column.resize(count);
+    std::memcpy(column.data(), bytes.data(), count * sizeof(T));
+    bytes.remove_prefix(count * sizeof(T));
+    return true;
+}
+
+std::string EventLog::serialize() const
+{
+    LogHeader header {};
+    std::memcpy(header.magic, log_magic, sizeof(header.magic));
+    header.version = log_version;
+    header.elevators = m_elevator_count;
+    header.events = size();
+
+    std::string bytes;
+    bytes.reserve(sizeof(header) + size() * (sizeof(Time) + sizeof(Kind) + sizeof(uint8_t) + sizeof(ElevatorID) + sizeof(PassengerID) + sizeof(Height) + 2 * sizeof(uint32_t)));
+    bytes.append(reinterpret_cast<char const*>(&header), sizeof(header));
+    write_column(bytes, m_times);
+    write_column(bytes, m_kinds);
+    write_column(bytes, m_states);
+    write_column(bytes, m_elevators);
+    write_column(bytes, m_passengers);
+    write_column(bytes, m_heights);
+    write_column(bytes, m_values);
+    write_column(bytes, m_details);
+    return bytes;
+}
+
+std::optional<EventLog> EventLog::deserialize(std::string_view bytes)
+{
+    LogHeader header {};
+    if (bytes.size() < sizeof(header))
+        return std::nullopt;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    bytes.remove_prefix(sizeof(header));
+
+    if (std::memcmp(header.magic, log_magic, sizeof(log_magic)) != 0 || header.version != log_version)
+        return std::nullopt;
+
+    EventLog log;
+    log.m_elevator_count = header.elevators;
+    size_t events = header.events;
+    bool complete = read_column(bytes, log.m_times, events)
+        && read_column(bytes, log.m_kinds, events)
+        && read_column(bytes, log.m_states, events)
+        && read_column(bytes, log.m_elevators, events)
+        && read_column(bytes, log.m_passengers, events)
+        && read_column(bytes, log.m_heights, events)
+        && read_column(bytes, log.m_values, events)
+        && read_column(bytes, log.m_details, events);
+
+    if (!complete || !bytes.empty())
+        return std::nullopt;
+
+    for (size_t i = 0; i < events; ++i) {
+        if (log.m_kinds[i] > Kind::Moved || log.m_states[i] > static_cast<uint8_t>(ElevatorState::State::DoorsClosing))
+            return std::nullopt;
+        if (log.m_elevators[i] != no_elevator && log.m_elevators[i] >= log.m_elevator_count)
+            return std::nullopt;
+    }
+
+    return log;
+}
+
+}
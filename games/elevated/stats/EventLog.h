@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Listener.h"
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Elevated {
+
+// Records every event of a run in columns, so stats can be computed later
+// (and again) without running the simulation again.
+// What the value and detail columns hold depends on the kind:
+//  - RequestCreated:   height = from, value = to, detail = capacity
+//  - PassengerEntered: height = from, value = to, detail = capacity
+//  - PassengerLeft:    height = floor left at
+//  - DoorsOpened/DoorsClosed: value = 0, detail = target
+//  - TargetSet:        value = new target, detail = old target
+//  - Stopped:          value = duration, detail = target
+//  - Moved:            value = distance, detail = height before moving
+// For elevator events height and state are those of the elevator at the event.
+// The number of elevators is kept separately, as idle elevators have no events.
+class EventLog final : public EventListener {
+public:
+    enum class Kind : uint8_t {
+        RequestCreated,
+        PassengerEntered,
+        PassengerLeft,
+        DoorsOpened,
+        DoorsClosed,
+        TargetSet,
+        Stopped,
+        Moved,
+    };
+
+    static constexpr ElevatorID no_elevator = std::numeric_limits<ElevatorID>::max();
+    static constexpr PassengerID no_passenger = 0;
+
+    virtual void on_initial_building(BuildingBlueprint const& blueprint) override;
+    virtual void on_request_created(Time at, Passenger const& passenger) override;
+    virtual void on_passenger_enter_elevator(Time at, Passenger const& passenger, ElevatorID id) override;
+    virtual void on_passenger_leave_elevator(Time at, PassengerID id, Height height) override;
+    virtual void on_elevator_opened_doors(Time at, ElevatorState const& elevator) override;
+    virtual void on_elevator_closed_doors(Time at, ElevatorState const& elevator) override;
+    virtual void on_elevator_set_target(Time at, Height new_target, ElevatorState const& elevator) override;
+    virtual void on_elevator_stopped(Time at, Time duration, ElevatorState const& elevator) override;
+    virtual void on_elevator_moved(Time at, Height distance, Height before_height, ElevatorState const& elevator) override;
+
+    [[nodiscard]] size_t size() const { return m_times.size(); }
+    [[nodiscard]] uint32_t elevator_count() const { return m_elevator_count; }
+
+    [[nodiscard]] std::span<Time const> times() const { return m_times; }
+    [[nodiscard]] std::span<Kind const> kinds() const { return m_kinds; }
+    // Stored as a byte, see state_at for the actual state.
+    [[nodiscard]] std::span<uint8_t const> states() const { return m_states; }
+    [[nodiscard]] ElevatorState::State state_at(size_t index) const { return static_cast<ElevatorState::State>(m_states[index]); }
+    [[nodiscard]] std::span<ElevatorID const> elevators() const { return m_elevators; }
+    [[nodiscard]] std::span<PassengerID const> passengers() const { return m_passengers; }
+    [[nodiscard]] std::span<Height const> heights() const { return m_heights; }
+    [[nodiscard]] std::span<uint32_t const> values() const { return m_values; }
+    [[nodiscard]] std::span<uint32_t const> details() const { return m_details; }
+
+    // Native byte order, a header followed by every column in the order above.
+    [[nodiscard]] std::string serialize() const;
+    static std::optional<EventLog> deserialize(std::string_view bytes);
+
+private:
+    void add(Time at, Kind kind, ElevatorState::State state, ElevatorID elevator, PassengerID passenger, Height height, uint32_t value, uint32_t detail);
+    void add_elevator_event(Time at, Kind kind, ElevatorState const& elevator, uint32_t value, uint32_t detail);
+
+    std::vector<Time> m_times;
+    std::vector<Kind> m_kinds;
+    std::vector<uint8_t> m_states;
+    std::vector<ElevatorID> m_elevators;
+    std::vector<PassengerID> m_passengers;
+    std::vector<Height> m_heights;
+    std::vector<uint32_t> m_values;
+    std::vector<uint32_t> m_details;
+    uint32_t m_elevator_count { 0 };
+
+    // Leave events do not name the elevator, so it is remembered from entering.
+    std::unordered_map<PassengerID, ElevatorID> m_elevator_of_passenger;
+};
+
+}
@@ -0,0 +1,185 @@
+#include "EventLogStats.h"
+#include "../../../util/Assertions.h"
+#include "../../../util/Histogram.h"
+#include <algorithm>
+
+namespace Elevated {
+
+namespace {
+
+struct PassengerTimes {
+    Time arrival { 0 };
+    Time entered { 0 };
+    uint32_t doors_opened { 0 };
+};
+
+struct ElevatorContents {
+    struct Inside {
+        PassengerID id;
+        Height to;
+        Capacity capacity;
+    };
+    std::vector<Inside> passengers;
+    Capacity filled { 0 };
+};
+
+}
+
+EventLogStats evaluate_event_log(EventLog const& log)
+{
+    auto times = log.times();
+    auto kinds = log.kinds();
+    auto elevators = log.elevators();
+    auto passengers = log.passengers();
+    auto heights = log.heights();
+    auto values = log.values();
+    auto details = log.details();
+
+    // Passenger ids are handed out in order from 1, so plain vectors suffice.
+    std::vector<PassengerTimes> passenger_times;
+    std::vector<ElevatorContents> contents;
+    auto passenger = [&](PassengerID id) -> PassengerTimes& {
+        if (id >= passenger_times.size())
+            passenger_times.resize(std::max<size_t>(id + 1, passenger_times.size() * 2));
+        return passenger_times[id];
+    };
+    auto elevator = [&](ElevatorID id) -> ElevatorContents& {
+        ASSERT(id != EventLog::no_elevator);
+        if (id >= contents.size())
+            contents.resize(id + 1);
+        return contents[id];
+    };
+
+    util::Histogram<Time> wait_times;
+    util::Histogram<Time> travel_times;
+    util::Histogram<uint32_t> times_door_opened;
+    std::vector<Time> all_wait_times;
+
+    util::StoringHistogram<ElevatorID, Height> distance_travelled;
+    util::StoringHistogram<ElevatorID, size_t> elevator_doors_opened;
+    util::StoringHistogram<ElevatorID, Time> time_stopped;
+
+    // Like ElevatorStatsListener, every elevator counts even if it never did anything.
+    for (ElevatorID id = 0; id < log.elevator_count(); ++id) {
+        distance_travelled.add_to_observation(id, 0);
+        elevator_doors_opened.add_to_observation(id, 0);
+        time_stopped.add_to_observation(id, 0);
+    }
+
+    EventLogStats stats {};
+
+    for (size_t i = 0; i < log.size(); ++i) {
+        switch (kinds[i]) {
+        case EventLog::Kind::RequestCreated:
+            passenger(passengers[i]).arrival = times[i];
+            ++stats.requests;
+            break;
+        case EventLog::Kind::PassengerEntered: {
+            auto& times_of = passenger(passengers[i]);
+            ASSERT(times[i] >= times_of.arrival);
+            Time wait_time = times[i] - times_of.arrival;
+            wait_times.add_observation(wait_time);
+            all_wait_times.push_back(wait_time);
+            times_of.entered = times[i];
+
+            auto& inside = elevator(elevators[i]);
+            inside.passengers.push_back({ passengers[i], values[i], details[i] });
+            inside.filled += details[i];
+            stats.max_elevator_load = std::max(stats.max_elevator_load, inside.filled);
+            break;
+        }
+        case EventLog::Kind::PassengerLeft: {
+            auto& times_of = passenger(passengers[i]);
+            travel_times.add_observation(times[i] - times_of.entered);
+            times_door_opened.add_observation(times_of.doors_opened);
+            times_of.doors_opened = 0;
+            ++stats.delivered;
+
+            if (elevators[i] == EventLog::no_elevator)
+                break;
+            auto& inside = elevator(elevators[i]);
+            auto passenger_or_end = std::find_if(inside.passengers.begin(), inside.passengers.end(), [&](auto const& in) {
+                return in.id == passengers[i];
+            });
+            ASSERT(passenger_or_end != inside.passengers.end());
+            if (passenger_or_end != inside.passengers.end()) {
+                inside.filled -= passenger_or_end->capacity;
+                *passenger_or_end = inside.passengers.back();
+                inside.passengers.pop_back();
+            }
+            break;
+        }
+        case EventLog::Kind::DoorsOpened: {
+            ++stats.times_door_opened;
+            elevator_doors_opened.add_to_observation(elevators[i], 1);
+            for (auto& in : elevator(elevators[i]).passengers) {
+                if (in.to != heights[i])
+                    ++passenger(in.id).doors_opened;
+            }
+            break;
+        }
+        case EventLog::Kind::DoorsClosed:
+            break;
+        case EventLog::Kind::TargetSet: {
+            if (log.state_at(i) != ElevatorState::State::Travelling)
+                break;
+            Height new_target = values[i];
+            Height old_target = details[i];
+            Height current = heights[i];
+            if (new_target == old_target)
+                break;
+            if (new_target == current)
+                ++stats.travelling_stops;
+            else if ((new_target > current) != (old_target > current))
+                ++stats.roller_coaster_events;
+            break;
+        }
+        case EventLog::Kind::Stopped:
+            time_stopped.add_to_observation(elevators[i], values[i]);
+            if (!elevator(elevators[i]).passengers.empty())
+                stats.time_stopped_with_passengers += values[i];
+            break;
+        case EventLog::Kind::Moved:
+            distance_travelled.add_to_observation(elevators[i], values[i]);
+            stats.total_distance_travelled += values[i];
+            break;
+        }
+    }
+
+    if (wait_times.total_entries() > 0) {
+        stats.average_wait_time = wait_times.sum_of_values<double>() / (double)wait_times.total_entries();
+        stats.max_wait_time = wait_times.max_value();
+
+        auto p95 = all_wait_times.begin() + (all_wait_times.size() - 1) * 95 / 100;
+        std::nth_element(all_wait_times.begin(), p95, all_wait_times.end());
+        stats.p95_wait_time = *p95;
+    }
+
+    if (travel_times.total_entries() > 0) {
+        stats.average_travel_time = travel_times.sum_of_values<double>() / (double)travel_times.total_entries();
+        stats.max_travel_time = travel_times.max_value();
+    }
+
+    if (times_door_opened.total_entries() > 0) {
+        stats.max_times_door_opened = times_door_opened.max_value();
+        stats.average_stops_passengers = times_door_opened.avg_value();
+    }
+    stats.first_stop_passengers = wait_times.total_entries() - times_door_opened.total_entries();
+
+    stats.max_elevator_travel_distance = distance_travelled.max_value();
+    stats.min_elevator_travel_distance = distance_travelled.min_value();
+    stats.avg_elevator_travel_distance = distance_travelled.avg_value();
+    stats.sum_elevator_travel_distance = distance_travelled.sum_value();
+
+    stats.max_elevator_doors_opened = elevator_doors_opened.max_value();
+    stats.min_elevator_doors_opened = elevator_doors_opened.min_value();
+    stats.avg_elevator_doors_opened = elevator_doors_opened.avg_value();
+
+    stats.max_elevator_time_stopped = time_stopped.max_value();
+    stats.min_elevator_time_stopped = time_stopped.min_value();
+    stats.avg_elevator_time_stopped = time_stopped.avg_value();
+
+    return stats;
+}
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "EventLog.h"
+
+namespace Elevated {
+
+// Everything the stat listeners compute, but from a recorded log.
+// Stats without any observation (e.g. no passengers) are 0 instead of asserting.
+struct EventLogStats {
+    // PassengerStatsListener
+    double average_wait_time { 0 };
+    Time max_wait_time { 0 };
+    Time max_travel_time { 0 };
+    double average_travel_time { 0 };
+    uint32_t max_times_door_opened { 0 };
+    uint32_t first_stop_passengers { 0 };
+    double average_stops_passengers { 0 };
+
+    // PowerStatsListener
+    uint64_t times_door_opened { 0 };
+    uint64_t total_distance_travelled { 0 };
+    Time time_stopped_with_passengers { 0 };
+
+    // SpecialEventsListener
+    uint64_t roller_coaster_events { 0 };
+    uint64_t travelling_stops { 0 };
+
+    // ElevatorStatsListener
+    Height max_elevator_travel_distance { 0 };
+    Height min_elevator_travel_distance { 0 };
+    double avg_elevator_travel_distance { 0 };
+    Height sum_elevator_travel_distance { 0 };
+    size_t max_elevator_doors_opened { 0 };
+    size_t min_elevator_doors_opened { 0 };
+    double avg_elevator_doors_opened { 0 };
+    size_t max_elevator_time_stopped { 0 };
+    size_t min_elevator_time_stopped { 0 };
+    double avg_elevator_time_stopped { 0 };
+
+    // Only available from the log.
+    Time p95_wait_time { 0 };
+    Capacity max_elevator_load { 0 };
+    uint64_t requests { 0 };
+    uint64_t delivered { 0 };
+};
+
+// Goes over the log once, giving exactly the values the listeners would have had.
+EventLogStats evaluate_event_log(EventLog const& log);
+
+}
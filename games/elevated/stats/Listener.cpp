@@ -24,6 +24,11 @@ bool EventDistributor::remove_listener(EventListener* listener_ptr) {
     return true;
 }
 
+void EventDistributor::on_initial_building(BuildingBlueprint const& blueprint) {
+    for (auto& listener : m_listeners)
+        listener->on_initial_building(blueprint);
+}
+
 void EventDistributor::on_request_created(Time at, Passenger const& passenger) {
     for (auto& listener : m_listeners)
         listener->on_request_created(at, passenger);
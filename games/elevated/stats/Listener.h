@@ -30,6 +30,8 @@ public:
     void add_listener(std::shared_ptr<EventListener> listener);
     bool remove_listener(EventListener* listener);
 
+    virtual void on_initial_building(BuildingBlueprint const& blueprint) override;
+
     virtual void on_request_created(Time at, const Passenger& passenger) override;
 
     virtual void on_passenger_enter_elevator(Time at, const Passenger& passenger, ElevatorID id) override;
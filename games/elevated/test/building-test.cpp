@@ -55,7 +55,7 @@ TEST_CASE("Building state", "[building][state]") {
                             (first_request_height == floor ? 1 : 0));
                 }
 
-                auto& queue = building.passengers_at(first_request_height);
+                auto queue = building.passengers_at(first_request_height).in_arrival_order();
                 REQUIRE(queue.size() == 1);
                 auto& passenger = queue.back();
                 REQUIRE(passenger.id != 0);
@@ -74,12 +74,12 @@ TEST_CASE("Building state", "[building][state]") {
                 }
 
                 REQUIRE(building.passengers_at(5).size() == 1);
-                auto& passenger = building.passengers_at(5).back();
+                auto passenger = building.passengers_at(5).in_arrival_order().back();
                 REQUIRE(passenger.id != 0);
                 REQUIRE(passenger.from == 5);
                 REQUIRE(passenger.to == 15);
                 REQUIRE(passenger.group == 1);
-                REQUIRE(building.passengers_at(first_request_height).back().id != passenger.id);
+                REQUIRE(building.passengers_at(first_request_height).in_arrival_order().back().id != passenger.id);
             }
         }
 
@@ -111,3 +111,92 @@ TEST_CASE("Building state", "[building][state]") {
         }
     }
 }
+
+namespace {
+
+class OrderListener : public EventListener {
+public:
+    std::vector<std::string> events;
+
+    void on_request_created(Time at, Passenger const& passenger) override { log(at, "request", passenger.id); }
+    void on_passenger_enter_elevator(Time at, Passenger const& passenger, ElevatorID id) override { log(at, "enter", passenger.id, id); }
+    void on_passenger_leave_elevator(Time at, PassengerID id, Height height) override { log(at, "leave", id, height); }
+    void on_elevator_opened_doors(Time at, ElevatorState const& elevator) override { log(at, "opened", elevator.id, elevator.passengers().size()); }
+    void on_elevator_closed_doors(Time at, ElevatorState const& elevator) override { log(at, "closed", elevator.id, elevator.passengers().size()); }
+    void on_elevator_set_target(Time at, Height target, ElevatorState const& elevator) override { log(at, "target", elevator.id, target); }
+    void on_elevator_stopped(Time at, Time duration, ElevatorState const& elevator) override { log(at, "stopped", elevator.id, duration); }
+    void on_elevator_moved(Time at, Height distance, Height, ElevatorState const& elevator) override { log(at, "moved", elevator.id, distance); }
+
+private:
+    void log(Time at, char const* name, uint32_t first, uint32_t second = 0)
+    {
+        events.push_back(std::to_string(at) + ' ' + name + ' ' + std::to_string(first) + ' ' + std::to_string(second));
+    }
+};
+
+}
+
+TEST_CASE("Building state with groups in parallel", "[building][state][parallel]") {
+    GIVEN("A building with interleaved groups run sequentially and in parallel") {
+        auto blueprint = BuildingBlueprint {
+            {{0u, 5u, 10u, 15u}, {5u, 15u}, {0u, 15u}},
+            {{0, 2}, {1, 2}, {0, 2}, {2, 1}, {1, 1}},
+        };
+
+        OrderListener sequential_listener;
+        BuildingState sequential { blueprint, &sequential_listener };
+
+        OrderListener parallel_listener;
+        BuildingState parallel { blueprint, &parallel_listener };
+        parallel.run_groups_in_parallel(std::make_shared<util::WorkerPool>(3));
+        REQUIRE(parallel.runs_groups_in_parallel());
+
+        auto run_both = [&](auto&& action) {
+            action(sequential);
+            action(parallel);
+        };
+
+        run_both([](BuildingState& building) {
+            for (auto i = 0u; i < 4u; ++i) {
+                building.add_request({5, 15, 1, 1});
+                building.add_request({5, 0, 0, 1});
+                building.add_request({5, 15, 0, 1});
+                building.add_request({0, 15, 2, 1});
+            }
+            building.send_elevator(0, 5);
+            building.send_elevator(1, 5);
+            building.send_elevator(2, 5);
+            building.send_elevator(3, 0);
+            building.send_elevator(4, 15);
+        });
+
+        WHEN("Both are run until nothing happens anymore") {
+            while (sequential.next_event_at().has_value()) {
+                REQUIRE(sequential.next_event_at() == parallel.next_event_at());
+                auto time = sequential.next_event_at().value();
+                auto sequential_updates = sequential.update_until(time);
+                auto parallel_updates = parallel.update_until(time);
+                REQUIRE(sequential_updates.size() == parallel_updates.size());
+
+                std::vector<BuildingState::Transfer> transfers;
+                for (auto& update : sequential_updates) {
+                    if (update.type != BuildingState::UpdateResult::Type::DoorsOpened)
+                        continue;
+                    sequential.transfer_passengers(update.id);
+                    transfers.push_back({update.id});
+                }
+                parallel.transfer_passengers(transfers);
+            }
+
+            THEN("The events and their order are identical") {
+                REQUIRE_FALSE(parallel.next_event_at().has_value());
+                REQUIRE(sequential_listener.events.size() > 30);
+                REQUIRE(sequential_listener.events == parallel_listener.events);
+                for (Height floor : {0u, 5u, 10u, 15u})
+                    REQUIRE(sequential.passengers_at(floor).size() == parallel.passengers_at(floor).size());
+                for (ElevatorID id = 0; id < sequential.num_elevators(); ++id)
+                    REQUIRE(sequential.elevator(id).passengers().size() == parallel.elevator(id).passengers().size());
+            }
+        }
+    }
+}
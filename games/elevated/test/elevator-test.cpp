@@ -1,9 +1,21 @@
 #include <catch2/catch.hpp>
 #include <elevated/Types.h>
 #include "elevated/Elevator.h"
+#include "elevated/ElevatorKinematics.h"
 
 using namespace Elevated;
 
+static bool queues_in_arrival_order(FloorQueue const& line) {
+    for (GroupID group = 0; group < 8; ++group) {
+        for (auto direction : {Direction::Up, Direction::Down}) {
+            auto& queue = line.waiting(group, direction);
+            if (!std::is_sorted(queue.begin(), queue.end(), [](Passenger const& lhs, Passenger const& rhs) { return lhs.id < rhs.id; }))
+                return false;
+        }
+    }
+    return true;
+}
+
 TEST_CASE("Elevators state", "[elevators][state]") {
     GIVEN("An initialized elevator") {
         Elevated::ElevatorID id = GENERATE(0, 2);
@@ -183,7 +195,7 @@ TEST_CASE("Elevators state", "[elevators][state]") {
         REQUIRE_FALSE(elevator.time_until_next_event().has_value());
 
         WHEN("Picking up from empty floor") {
-            std::vector<Elevated::Passenger> line;
+            Elevated::FloorQueue line;
             auto transferred = elevator.transfer_passengers(line);
 
             THEN("No passengers were picked up and doors are closing") {
@@ -197,11 +209,11 @@ TEST_CASE("Elevators state", "[elevators][state]") {
         }
 
         WHEN("Picking up from line with no passengers of matching group id") {
-            std::vector<Elevated::Passenger> line;
+            Elevated::FloorQueue line;
             auto count = GENERATE(1u, 2u, 10u);
             CAPTURE(count);
             for (auto i = 0u; i < count; ++i)
-                line.push_back(Elevated::Passenger{i, {0, 1, other_group_id}});
+                line.add(Elevated::Passenger{i, {0, 1, other_group_id}});
 
             REQUIRE(line.size() == count);
 
@@ -217,18 +229,16 @@ TEST_CASE("Elevators state", "[elevators][state]") {
                 REQUIRE(transferred.picked_up_passengers.empty());
                 REQUIRE(transferred.dropped_off_passengers.empty());
 
-                REQUIRE(std::is_sorted(line.begin(), line.end(), [&](Elevated::Passenger const& lhs, Elevated::Passenger const& rhs) {
-                    return lhs.id < rhs.id;
-                }));
+                REQUIRE(queues_in_arrival_order(line));
             }
         }
 
         WHEN("Picking up from line with only passengers of matching group id") {
-            std::vector<Elevated::Passenger> line;
+            Elevated::FloorQueue line;
             auto count = GENERATE(1u, 2u, 10u);
             CAPTURE(count);
             for (auto i = 0u; i < count; ++i)
-                line.push_back(Elevated::Passenger{i, {0, 1, group_id}});
+                line.add(Elevated::Passenger{i, {0, 1, group_id}});
 
             auto transferred = elevator.transfer_passengers(line);
 
@@ -258,7 +268,7 @@ TEST_CASE("Elevators state", "[elevators][state]") {
         }
 
         WHEN("Picking up from a mixed line of waiting passengers") {
-            std::vector<Elevated::Passenger> line {
+            Elevated::FloorQueue line {
                 {0, {0, 1, group_id}},
                 {1, {0, 1, other_group_id}},
                 {2, {0, 1, other_group_id}},
@@ -291,9 +301,7 @@ TEST_CASE("Elevators state", "[elevators][state]") {
                 REQUIRE(elevator.current_state() == Elevated::ElevatorState::State::DoorsClosing);
                 REQUIRE(elevator.time_until_next_event() == elevator.door_closing_time);
 
-                REQUIRE(std::is_sorted(line.begin(), line.end(), [&](Elevated::Passenger const& lhs, Elevated::Passenger const& rhs) {
-                    return lhs.id < rhs.id;
-                }));
+                REQUIRE(queues_in_arrival_order(line));
             }
 
         }
@@ -311,7 +319,7 @@ TEST_CASE("Elevators state", "[elevators][state]") {
             REQUIRE(result == Elevated::ElevatorState::ElevatorUpdateResult::DoorsOpened);
             REQUIRE(elevator.current_state() == Elevated::ElevatorState::State::DoorsOpen);
             REQUIRE_FALSE(elevator.time_until_next_event().has_value());
-            std::vector<Elevated::Passenger> line;
+            Elevated::FloorQueue line;
             auto transferred = elevator.transfer_passengers(line);
             REQUIRE(transferred.dropped_off_passengers.empty());
             REQUIRE(transferred.picked_up_passengers.empty());
@@ -376,10 +384,10 @@ TEST_CASE("Elevators state", "[elevators][state]") {
             REQUIRE(result == Elevated::ElevatorState::ElevatorUpdateResult::DoorsOpened);
             REQUIRE(elevator.current_state() == Elevated::ElevatorState::State::DoorsOpen);
 
-            std::vector<Elevated::Passenger> line;
+            Elevated::FloorQueue line;
             for (auto [id, to, _] : passenger_list) {
                 REQUIRE(get_in_floor != to);
-                line.push_back(Elevated::Passenger { id, {get_in_floor, to, 0 }});
+                line.add(Elevated::Passenger { id, {get_in_floor, to, 0 }});
             }
 
             auto transferred = elevator.transfer_passengers(line);
@@ -403,7 +411,7 @@ TEST_CASE("Elevators state", "[elevators][state]") {
             REQUIRE(steps.has_value());
             auto result = elevator.update(steps.value());
             REQUIRE(result == Elevated::ElevatorState::ElevatorUpdateResult::DoorsOpened);
-            std::vector<Elevated::Passenger> empty_line;
+            Elevated::FloorQueue empty_line;
             auto transferred = elevator.transfer_passengers(empty_line);
             REQUIRE(empty_line.empty());
             REQUIRE(transferred.picked_up_passengers.empty());
@@ -486,7 +494,7 @@ TEST_CASE("Elevators state", "[elevators][state]") {
         REQUIRE_FALSE(elevator.time_until_next_event().has_value());
 
         WHEN("Picking up passengers with capacity") {
-            std::vector<Passenger> line {
+            FloorQueue line {
                 {1, {0, 1, group_id, 1}},
                 {2, {0, 1, group_id, 1}},
                 {3, {0, 1, group_id, 1}},
@@ -518,11 +526,11 @@ TEST_CASE("Elevators state", "[elevators][state]") {
 #define REQUIRE_LEFT_IN_LINE(...) \
                 for (auto i : { __VA_ARGS__ }) { \
                     CAPTURE(i); \
-                    REQUIRE(std::find_if(line.begin(), line.end(), \
-                                [&](Passenger const &p) { return p.id == i; }) != line.end()); \
+                    auto left_in_line = line.in_arrival_order(); \
+                    REQUIRE(std::find_if(left_in_line.begin(), left_in_line.end(), \
+                                [&](Passenger const &p) { return p.id == i; }) != left_in_line.end()); \
                 } \
-                REQUIRE(std::is_sorted(line.begin(), line.end(),  \
-                    [&](Passenger const& lhs, Passenger const& rhs) { return lhs.id < rhs.id; }))
+                REQUIRE(queues_in_arrival_order(line))
 
                 REQUIRE_PICKED_UP(1u, 2u, 3u, 4u, 5u)
                 REQUIRE_LEFT_IN_LINE(6u, 7u);
@@ -531,7 +539,7 @@ TEST_CASE("Elevators state", "[elevators][state]") {
 
         WHEN("Picking up passengers with other groups") {
 
-            std::vector<Passenger> line {
+            FloorQueue line {
                 {1, {0, 1, group_id, max_capacity - 1}},
                 {2, {0, 1, other_group_id, 2}},
                 {3, {0, 1, other_group_id, 1}},
@@ -551,7 +559,7 @@ TEST_CASE("Elevators state", "[elevators][state]") {
 
         WHEN("Picking up passengers capacity 0") {
 
-            std::vector<Passenger> line {
+            FloorQueue line {
                 {1, {0, 1, group_id, max_capacity - 1}},
                 {2, {0, 1, group_id, 2}},
                 {3, {0, 1, group_id, 0}},
@@ -568,6 +576,26 @@ TEST_CASE("Elevators state", "[elevators][state]") {
                 REQUIRE_LEFT_IN_LINE(2u, 6u);
             }
         }
+
+        WHEN("Filling up before the end of the line") {
+
+            FloorQueue line {
+                {1, {0, 1, group_id, 2}},
+                {2, {0, 1, group_id, max_capacity}},
+                {3, {0, 1, group_id, max_capacity - 2}},
+                {4, {1, 0, group_id, 1}},
+                {5, {0, 1, group_id, 1}},
+                {6, {1, 0, group_id, 1}},
+            };
+
+            auto transferred = elevator.transfer_passengers(line);
+
+            THEN("Everyone after the last one to fit keeps their place") {
+                REQUIRE_PICKED_UP(1u, 3u);
+                REQUIRE_LEFT_IN_LINE(2u, 4u, 5u, 6u);
+                REQUIRE(elevator.filled_capacity() == max_capacity);
+            }
+        }
     }
 
     GIVEN("An elevator waiting at a floor") {
@@ -586,7 +614,7 @@ TEST_CASE("Elevators state", "[elevators][state]") {
         REQUIRE(elevator.current_state() == Elevated::ElevatorState::State::DoorsOpen);
         REQUIRE_FALSE(elevator.time_until_next_event().has_value());
 
-        std::vector<Elevated::Passenger> line {
+        Elevated::FloorQueue line {
             {1, {0, 1, group_id}},
             {2, {0, 1, other_group_id}},
             {3, {0, 1, other_group_id}},
@@ -612,9 +640,7 @@ TEST_CASE("Elevators state", "[elevators][state]") {
                 REQUIRE(elevator.current_state() == Elevated::ElevatorState::State::DoorsClosing);
                 REQUIRE(elevator.time_until_next_event() == elevator.door_closing_time);
 
-                REQUIRE(std::is_sorted(line.begin(), line.end(), [&](Elevated::Passenger const& lhs, Elevated::Passenger const& rhs) {
-                    return lhs.id < rhs.id;
-                }));
+                REQUIRE(queues_in_arrival_order(line));
 
                 REQUIRE(passenger_ids == std::vector<PassengerID>{1, 4, 5});
             }
@@ -649,9 +675,7 @@ TEST_CASE("Elevators state", "[elevators][state]") {
                                 }) != transferred.picked_up_passengers.end());
                 }
 
-                REQUIRE(std::is_sorted(line.begin(), line.end(), [&](Elevated::Passenger const& lhs, Elevated::Passenger const& rhs) {
-                    return lhs.id < rhs.id;
-                }));
+                REQUIRE(queues_in_arrival_order(line));
 
                 REQUIRE(passenger_ids == std::vector<PassengerID>{1, 4, 5});
             }
@@ -686,12 +710,145 @@ TEST_CASE("Elevators state", "[elevators][state]") {
                                 }) != transferred.picked_up_passengers.end());
                 }
 
-                REQUIRE(std::is_sorted(line.begin(), line.end(), [&](Elevated::Passenger const& lhs, Elevated::Passenger const& rhs) {
-                    return lhs.id < rhs.id;
-                }));
+                REQUIRE(queues_in_arrival_order(line));
 
                 REQUIRE(passenger_ids == std::vector<PassengerID>{1, 4, 5});
             }
         }
     }
 }
+
+TEST_CASE("Floor queue", "[elevators][queue]") {
+    GIVEN("A queue with passengers of multiple groups and directions") {
+        FloorQueue line {
+            {1, {5, 10, 0, 1}},
+            {2, {5, 0, 0, 1}},
+            {3, {5, 10, 1, 1}},
+            {4, {5, 15, 0, 1}},
+            {5, {5, 0, 1, 1}},
+        };
+
+        THEN("Every passenger is in the queue of its group and direction") {
+            REQUIRE(line.size() == 5);
+            REQUIRE(line.waiting(0, Direction::Up).size() == 2);
+            REQUIRE(line.waiting(0, Direction::Down).size() == 1);
+            REQUIRE(line.waiting(1, Direction::Up).size() == 1);
+            REQUIRE(line.waiting(1, Direction::Down).size() == 1);
+            REQUIRE_FALSE(line.has_waiting(2, Direction::Up));
+            REQUIRE(line.waiting(0, Direction::Up).back().id == 4);
+        }
+
+        THEN("Arrival order is the order the passengers were added") {
+            auto passengers = line.in_arrival_order();
+            REQUIRE(passengers.size() == 5);
+            for (auto i = 0u; i < passengers.size(); ++i)
+                REQUIRE(passengers[i].id == i + 1);
+        }
+
+        WHEN("Adding another passenger") {
+            auto index = line.add({6, {5, 0, 0, 1}});
+
+            THEN("The index points to that passenger") {
+                REQUIRE(index.group == 0);
+                REQUIRE(index.direction == Direction::Down);
+                REQUIRE(index.index == 1);
+                REQUIRE(line.at(index).id == 6);
+                REQUIRE(line.size() == 6);
+            }
+        }
+
+        WHEN("An elevator with limited capacity picks up from both directions") {
+            ElevatorState elevator {0, {0, 2}, 5};
+            elevator.set_target(5);
+            elevator.update(elevator.time_until_next_event().value());
+            REQUIRE(elevator.current_state() == ElevatorState::State::DoorsOpen);
+
+            auto transferred = elevator.transfer_passengers(line);
+
+            THEN("Passengers got in the order they arrived regardless of direction") {
+                REQUIRE(transferred.picked_up_passengers.size() == 2);
+                REQUIRE(transferred.picked_up_passengers[0].id == 1);
+                REQUIRE(transferred.picked_up_passengers[1].id == 2);
+                REQUIRE(line.size() == 3);
+                REQUIRE(line.waiting(0, Direction::Up).size() == 1);
+                REQUIRE(line.waiting(0, Direction::Up).front().id == 4);
+                REQUIRE(line.waiting(0, Direction::Down).empty());
+                REQUIRE(queues_in_arrival_order(line));
+            }
+
+            THEN("The elevator knows its destinations and filled capacity") {
+                REQUIRE(elevator.passengers().size() == 2);
+                REQUIRE(elevator.passengers().destinations() == std::vector<Height>{0, 10});
+                REQUIRE(elevator.filled_capacity() == 2);
+            }
+        }
+    }
+}
+
+TEST_CASE("Elevator kinematics", "[elevators][kinematics]") {
+    GIVEN("A fleet of elevators in all kinds of states") {
+        auto kernel = GENERATE(ElevatorKinematics::Kernel::Scalar, ElevatorKinematics::Kernel::Best);
+        CAPTURE(kernel == ElevatorKinematics::Kernel::Best, ElevatorKinematics::has_vector_kernel());
+
+        std::vector<ElevatorState> elevators;
+        for (ElevatorID id = 0; id < 37; ++id) {
+            Height speed = 1 + id % 3;
+            elevators.emplace_back(id, BuildingBlueprint::Elevator {0, 1, speed}, (id % 5) * 30);
+            auto& elevator = elevators.back();
+            if (id % 4 != 3)
+                elevator.set_target(((id * 7) % 5) * 30);
+        }
+
+        std::vector<ElevatorState> expected = elevators;
+
+        ElevatorKinematics kinematics;
+        kinematics.assign(elevators);
+
+        auto expected_next_event = [&]() {
+            std::optional<Time> minimum;
+            for (auto& elevator : expected) {
+                auto time = elevator.time_until_next_event();
+                if (time.has_value() && (!minimum.has_value() || *time < *minimum))
+                    minimum = time;
+            }
+            return minimum;
+        };
+
+        THEN("The first event is the same as for the elevators") {
+            REQUIRE(kinematics.min_time_until_next_event(kernel) == expected_next_event());
+        }
+
+        WHEN("Advancing until the first event") {
+            auto steps = expected_next_event();
+            REQUIRE(steps.has_value());
+
+            std::vector<uint8_t> moved;
+            kinematics.advance_travelling(steps.value(), moved, kernel);
+            REQUIRE(moved.size() == elevators.size());
+
+            for (auto& elevator : elevators) {
+                if (moved[elevator.id])
+                    kinematics.apply_travel(elevator);
+                else
+                    elevator.update(steps.value());
+                kinematics.sync(elevator);
+            }
+
+            for (auto& elevator : expected)
+                elevator.update(steps.value());
+
+            THEN("The elevators are in the same state as when updated one by one") {
+                size_t travelled = 0;
+                for (ElevatorID id = 0; id < elevators.size(); ++id) {
+                    CAPTURE(id);
+                    REQUIRE(elevators[id].height() == expected[id].height());
+                    REQUIRE(elevators[id].current_state() == expected[id].current_state());
+                    REQUIRE(elevators[id].time_until_next_event() == expected[id].time_until_next_event());
+                    travelled += moved[id];
+                }
+                REQUIRE(travelled > 8);
+                REQUIRE(kinematics.min_time_until_next_event(kernel) == expected_next_event());
+            }
+        }
+    }
+}
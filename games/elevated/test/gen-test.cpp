@@ -1,9 +1,48 @@
 #include <catch2/catch.hpp>
 #include <elevated/Types.h>
+#include <elevated/generation/BasicGenerator.h>
 #include <elevated/generation/Generation.h>
+#include <elevated/generation/MetaGenerators.h>
+#include <elevated/generation/PipelinedGenerator.h>
+#include <elevated/generation/RequestTrace.h>
+#include <elevated/generation/ScenarioFile.h>
+#include <elevated/generation/factory/CompiledScenario.h>
+#include <elevated/generation/factory/StringSettings.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
 
 using namespace Elevated;
 
+static size_t require_same_scenario(ScenarioGenerator& expected, ScenarioGenerator& actual)
+{
+    auto expected_building = expected.generate_building();
+    auto actual_building = actual.generate_building();
+    REQUIRE(expected_building.has_error() == actual_building.has_error());
+    REQUIRE(expected_building.blueprint() == actual_building.blueprint());
+
+    size_t total_requests = 0;
+    while (true) {
+        auto next = expected.next_requests_at();
+        REQUIRE(actual.next_requests_at() == next);
+        if (next.type != NextRequests::Type::At)
+            break;
+
+        auto expected_requests = expected.requests_at(next.next_request_time);
+        auto actual_requests = actual.requests_at(next.next_request_time);
+        REQUIRE(expected_requests.size() == actual_requests.size());
+        for (size_t i = 0; i < expected_requests.size(); ++i) {
+            REQUIRE(expected_requests[i].from == actual_requests[i].from);
+            REQUIRE(expected_requests[i].to == actual_requests[i].to);
+            REQUIRE(expected_requests[i].group == actual_requests[i].group);
+            REQUIRE(expected_requests[i].capacity == actual_requests[i].capacity);
+        }
+        total_requests += expected_requests.size();
+    }
+    return total_requests;
+}
+
 TEST_CASE("Next requests at semantics", "[types]") {
     SECTION("Same requests are equal") {
         SECTION("At") {
@@ -46,3 +85,629 @@ TEST_CASE("Next requests at semantics", "[types]") {
         REQUIRE(NextRequests::unknown() < NextRequests::done());
     }
 }
+
+TEST_CASE("Request traces", "[generation][trace]") {
+    std::string const scenario = "named-scenario(basic-1)";
+    long const seed = 783675;
+
+    auto make_generator = [&] {
+        auto result = parse_scenario(scenario, seed);
+        REQUIRE(result.generator);
+        return std::move(result.generator);
+    };
+
+    GIVEN("A trace recorded from a scenario") {
+        auto recorded_from = make_generator();
+        auto trace = RequestTrace::record(*recorded_from);
+        REQUIRE(trace);
+        REQUIRE(trace->request_times() > 0);
+
+        THEN("Replaying it gives the same building and requests as a live generator") {
+            TraceScenarioGenerator replay { trace };
+            auto live = make_generator();
+            auto total_requests = require_same_scenario(*live, replay);
+            REQUIRE(total_requests == trace->total_requests());
+        }
+    }
+
+    GIVEN("A trace cache") {
+        RequestTraceCache cache;
+        size_t generators_made = 0;
+        auto counting_factory = [&]() -> std::unique_ptr<ScenarioGenerator> {
+            ++generators_made;
+            return make_generator();
+        };
+
+        auto first = cache.trace_for(scenario, seed, counting_factory);
+        auto second = cache.trace_for(scenario, seed, counting_factory);
+
+        THEN("The same scenario and seed is only recorded once") {
+            REQUIRE(first);
+            REQUIRE(first == second);
+            REQUIRE(generators_made == 1);
+            REQUIRE(cache.size() == 1);
+        }
+
+        THEN("A different seed is recorded separately") {
+            auto other = cache.trace_for(scenario, seed + 1, counting_factory);
+            REQUIRE(other != first);
+            REQUIRE(generators_made == 2);
+        }
+
+        THEN("A generator which cannot be made is remembered as such") {
+            REQUIRE_FALSE(cache.trace_for("invalid", seed, [] { return nullptr; }));
+            REQUIRE_FALSE(cache.trace_for("invalid", seed, counting_factory));
+            REQUIRE(generators_made == 1);
+        }
+    }
+
+    GIVEN("A trace cache with room for two traces") {
+        RequestTraceCache cache { 2 };
+        size_t generators_made = 0;
+        auto counting_factory = [&]() -> std::unique_ptr<ScenarioGenerator> {
+            ++generators_made;
+            return make_generator();
+        };
+
+        auto first = cache.trace_for(scenario, seed, counting_factory);
+        cache.trace_for(scenario, seed + 1, counting_factory);
+        cache.trace_for(scenario, seed, counting_factory);
+        cache.trace_for(scenario, seed + 2, counting_factory);
+
+        THEN("The least recently used trace is dropped") {
+            REQUIRE(cache.size() == 2);
+            REQUIRE(generators_made == 3);
+            REQUIRE(cache.trace_for(scenario, seed, counting_factory) == first);
+            REQUIRE(generators_made == 3);
+            cache.trace_for(scenario, seed + 1, counting_factory);
+            REQUIRE(generators_made == 4);
+        }
+
+        THEN("A dropped trace stays valid for whoever still has it") {
+            cache.clear();
+            REQUIRE(first->request_times() > 0);
+        }
+    }
+}
+
+TEST_CASE("Scenario files", "[generation][scenario-file]") {
+    std::string const path = "elevated-scenario-file-test.bin";
+
+    GIVEN("A scenario written to a file") {
+        auto make_generator = [] {
+            return std::move(parse_scenario("named-scenario(basic-2)", 1234).generator);
+        };
+
+        auto written = make_generator();
+        REQUIRE_FALSE(write_scenario_file(*written, path).has_value());
+
+        THEN("Mapping the file gives the same building and requests") {
+            MappedScenarioGenerator mapped { path };
+            REQUIRE_FALSE(mapped.generate_building().has_error());
+            auto live = make_generator();
+            auto total_requests = require_same_scenario(*live, mapped);
+            REQUIRE(total_requests == mapped.total_requests());
+        }
+    }
+
+    GIVEN("A file which is not a scenario") {
+        {
+            std::ofstream stream(path, std::ios::trunc);
+            stream << "capacity on\nbuilding\n";
+        }
+
+        THEN("The building generation fails") {
+            MappedScenarioGenerator mapped { path };
+            REQUIRE(mapped.generate_building().has_error());
+            REQUIRE(mapped.next_requests_at() == NextRequests::done());
+        }
+    }
+
+    GIVEN("A generator which cannot be written") {
+        class UnknownTimesGenerator final : public ScenarioGenerator {
+        public:
+            BuildingGenerationResult generate_building() override
+            {
+                return BuildingGenerationResult { BuildingBlueprint { { { 0, 1 } }, { { 0 } } } };
+            }
+
+            NextRequests next_requests_at() override { return NextRequests::unknown(); }
+
+            std::vector<PassengerBlueprint> requests_at(Time) override { return {}; }
+        };
+
+        std::remove(path.c_str());
+        UnknownTimesGenerator generator;
+        REQUIRE(write_scenario_file(generator, path).has_value());
+
+        THEN("No file is left behind") {
+            REQUIRE_FALSE(std::ifstream(path).good());
+            REQUIRE_FALSE(std::ifstream(path + ".partial").good());
+        }
+    }
+
+    GIVEN("A file which does not exist") {
+        MappedScenarioGenerator mapped { "this-file-does-not-exist.bin" };
+
+        THEN("The building generation fails") {
+            REQUIRE(mapped.generate_building().has_error());
+        }
+    }
+
+    std::remove(path.c_str());
+}
+
+// How numbers were read before from_chars, the errors must stay exactly the same.
+template<typename T>
+static std::vector<StringSettings::ErrorMessage> stream_read_errors(std::string const& word, T& value)
+{
+    std::istringstream stream(word);
+    stream.imbue(std::locale::classic());
+    stream >> value;
+
+    std::vector<StringSettings::ErrorMessage> errors;
+    if (!stream.eof()) {
+        std::string left_over;
+        auto index = static_cast<size_t>(stream.tellg());
+        std::getline(stream, left_over);
+        errors.push_back({ "Unused input, skipping over: '" + left_over + "'", true, index, word.size() });
+    }
+    if (stream.fail())
+        errors.push_back({ "Failed read value", true, 0, word.size() });
+    return errors;
+}
+
+template<typename T>
+static void require_same_as_stream(std::string const& word)
+{
+    INFO("Reading '" << word << "'");
+    T expected {};
+    auto expected_errors = stream_read_errors(word, expected);
+
+    T actual {};
+    StringSettings settings { word };
+    if constexpr (std::is_same_v<T, int>)
+        settings.integerValue("value", actual);
+    else if constexpr (std::is_same_v<T, uint32_t>)
+        settings.unsignedValue("value", actual);
+    else
+        settings.doubleValue("value", actual);
+
+    auto& actual_errors = settings.errors();
+    REQUIRE(actual_errors.size() == expected_errors.size());
+    for (size_t i = 0; i < actual_errors.size(); ++i) {
+        if (expected_errors[i].message != "Failed read value")
+            REQUIRE(actual_errors[i].message == expected_errors[i].message);
+        REQUIRE(actual_errors[i].from == expected_errors[i].from);
+        REQUIRE(actual_errors[i].to == expected_errors[i].to);
+    }
+
+    if constexpr (std::is_floating_point_v<T>) {
+        if (std::isnan(expected))
+            REQUIRE(std::isnan(actual));
+        else
+            REQUIRE(actual == expected);
+    } else {
+        REQUIRE(actual == expected);
+    }
+}
+
+TEST_CASE("Scenario numbers", "[generation][settings]") {
+    GIVEN("Values followed by other input") {
+        StringSettings settings { "12ab, 7" };
+        int first = 0;
+        int second = 0;
+        settings.integerValue("first", first);
+        settings.integerValue("second", second);
+
+        THEN("The unused input is reported where it starts and the next value is still read") {
+            REQUIRE(first == 12);
+            REQUIRE(second == 7);
+            REQUIRE(settings.errors().size() == 1);
+            REQUIRE(settings.errors()[0].message == "Unused input, skipping over: 'ab'");
+            REQUIRE(settings.errors()[0].from == 2);
+            REQUIRE(settings.errors()[0].to == 4);
+        }
+    }
+
+    GIVEN("A value which is not a number") {
+        StringSettings settings { "5 abc" };
+        double first = 0;
+        double second = 1;
+        settings.doubleValue("first", first);
+        settings.doubleValue("second", second);
+
+        THEN("It fails at its own location and reads as 0") {
+            REQUIRE(first == 5);
+            REQUIRE(second == 0);
+            REQUIRE(settings.errors().size() == 2);
+            REQUIRE(settings.errors()[0].message == "Unused input, skipping over: ''");
+            REQUIRE(settings.errors()[0].from == 1);
+            REQUIRE(settings.errors()[0].to == 5);
+            REQUIRE(settings.errors()[1].message == "Failed read double value for 'second'");
+            REQUIRE(settings.errors()[1].from == 2);
+            REQUIRE(settings.errors()[1].to == 5);
+        }
+    }
+
+    GIVEN("Numbers of every kind") {
+        std::vector<std::string> words {
+            "0", "12", "-12", "+7", "007", "12abc", "abc", "-", "+", "--1", "1-", "1.5", ".5", "5.", "1.2.3",
+            "1e5", "1e", "1e+", "1e-3", "2e400", "-2e400", "1e-400", "0x10", "nan", "inf",
+            "2147483647", "2147483648", "-2147483648", "-2147483649", "99999999999999999999",
+            "4294967295", "4294967296", "-1", "-4294967295", "3.", "12345678901234567890.5",
+        };
+
+        THEN("They are read exactly like istream extraction did") {
+            for (auto& word : words) {
+                require_same_as_stream<int>(word);
+                require_same_as_stream<uint32_t>(word);
+                require_same_as_stream<double>(word);
+            }
+        }
+    }
+}
+
+TEST_CASE("Compiled scenarios", "[generation][compiled]") {
+    auto scenario = GENERATE(as<std::string> {},
+        "named-scenario(basic-3)",
+        "split(named-building(basic-1), combiner(2, uniform-random(50, 0.1, 1), force-direction(randomize, 0.5, ground-floor-random(30, 0.2, 0, 1))))");
+
+    GIVEN("A compiled scenario") {
+        auto compiled = CompiledScenario::compile(scenario);
+        REQUIRE(compiled.scenario);
+        REQUIRE(compiled.errors == parse_scenario(scenario, 0).errors);
+
+        THEN("Instantiating it gives the same scenario as parsing it with that seed") {
+            for (long seed : { 0l, 1l, 783675l, -44l }) {
+                auto parsed = parse_scenario(scenario, seed);
+                REQUIRE(parsed.generator);
+                auto instantiated = compiled.scenario->instantiate(seed);
+                REQUIRE(instantiated);
+                REQUIRE(require_same_scenario(*parsed.generator, *instantiated) > 0);
+            }
+        }
+
+        THEN("Its canonical form compiles to itself") {
+            auto recompiled = CompiledScenario::compile(compiled.scenario->canonical());
+            REQUIRE(recompiled.scenario);
+            REQUIRE(recompiled.scenario->canonical() == compiled.scenario->canonical());
+        }
+    }
+}
+
+TEST_CASE("Canonical scenarios", "[generation][compiled]") {
+    auto canonical = [](std::string const& value) {
+        auto compiled = CompiledScenario::compile(value);
+        REQUIRE(compiled.scenario);
+        return compiled.scenario->canonical();
+    };
+
+    REQUIRE(canonical("named-scenario( basic-3 )") == "named-scenario(basic-3)");
+    REQUIRE(canonical("split(named-building(basic-1),uniform-random(50,0.10,1))") == canonical("split(named-building(basic-1), uniform-random(50, 0.1, 1))"));
+    REQUIRE(canonical("named-scenario(basic-3)") != canonical("named-scenario(basic-4)"));
+
+    auto near_equal_lhs = canonical("split(named-building(basic-1), uniform-random(50, 0.1234567, 1))");
+    auto near_equal_rhs = canonical("split(named-building(basic-1), uniform-random(50, 0.1234568, 1))");
+    REQUIRE(near_equal_lhs != near_equal_rhs);
+    REQUIRE(canonical(near_equal_lhs) == near_equal_lhs);
+    REQUIRE(canonical(near_equal_rhs) == near_equal_rhs);
+}
+
+TEST_CASE("Scenario cache", "[generation][compiled]") {
+    ScenarioCache cache { 2 };
+
+    auto first = cache.compile("named-scenario(basic-1)");
+    REQUIRE(first.scenario);
+    REQUIRE(cache.compile("named-scenario(basic-1)").scenario == first.scenario);
+
+    GIVEN("An invalid scenario") {
+        auto invalid = cache.parse("not-a-scenario(", 1);
+
+        THEN("It gives the same errors as parsing it") {
+            REQUIRE_FALSE(invalid.generator);
+            REQUIRE(invalid.errors == parse_scenario("not-a-scenario(", 1).errors);
+            REQUIRE(cache.size() == 2);
+        }
+    }
+
+    GIVEN("More scenarios than fit in the cache") {
+        cache.compile("named-scenario(basic-2)");
+        // Makes basic-2 the least recently used.
+        cache.compile("named-scenario(basic-1)");
+        cache.compile("named-scenario(basic-3)");
+
+        THEN("The least recently used one is evicted") {
+            REQUIRE(cache.size() == 2);
+            REQUIRE(cache.compile("named-scenario(basic-1)").scenario == first.scenario);
+        }
+    }
+}
+
+TEST_CASE("Request combiner", "[generation][combiner]") {
+    HardcodedBuildingGenerator building_generator { { { 2, { 0, 5, 10, 15 } }, { 1, { 0, 20 } } } };
+    auto building = building_generator.generate_building();
+    REQUIRE_FALSE(building.has_error());
+
+    size_t const children = GENERATE(1, 2, 13);
+
+    auto make_child = [](size_t i) -> std::unique_ptr<RequestGenerator> {
+        if (i % 3 == 2)
+            return std::make_unique<ForceDirectionGenerator>(std::make_unique<UniformFloorGenerator>(static_cast<long>(i), 40 + i, 0.05 * static_cast<double>(i + 1)), ForceDirectionGenerator::Operation::Reverse);
+        if (i % 3 == 1)
+            return std::make_unique<GroundFloorGenerator>(static_cast<long>(i), 30 + i, 0.1, 0);
+        return std::make_unique<UniformFloorGenerator>(static_cast<long>(i), 50 + 3 * i, 0.02);
+    };
+
+    std::vector<std::unique_ptr<RequestGenerator>> combined_children;
+    std::vector<std::unique_ptr<RequestGenerator>> separate;
+    for (size_t i = 0; i < children; ++i) {
+        combined_children.push_back(make_child(i));
+        separate.push_back(make_child(i));
+        separate.back()->accept_building(building);
+    }
+
+    RequestCombiner combiner { std::move(combined_children) };
+    combiner.accept_building(building);
+    REQUIRE_FALSE(building.has_error());
+
+    THEN("It gives the requests of all generators in generator order") {
+        size_t total_requests = 0;
+        while (true) {
+            NextRequests expected_next = NextRequests::done();
+            for (auto& generator : separate) {
+                if (auto next = generator->next_requests_at(); next < expected_next)
+                    expected_next = next;
+            }
+
+            auto next = combiner.next_requests_at();
+            REQUIRE(next == expected_next);
+            if (next.type != NextRequests::Type::At)
+                break;
+
+            std::vector<PassengerBlueprint> expected;
+            for (auto& generator : separate) {
+                auto requests = generator->requests_at(next.next_request_time);
+                expected.insert(expected.end(), requests.begin(), requests.end());
+            }
+
+            auto requests = combiner.requests_at(next.next_request_time);
+            REQUIRE(requests.size() == expected.size());
+            for (size_t i = 0; i < requests.size(); ++i) {
+                REQUIRE(requests[i].from == expected[i].from);
+                REQUIRE(requests[i].to == expected[i].to);
+                REQUIRE(requests[i].group == expected[i].group);
+            }
+            total_requests += requests.size();
+        }
+        REQUIRE(total_requests > 0);
+    }
+}
+
+// Hides when its requests are, so a combiner has to ask it at every time.
+class UnknownTimesRequests final : public RequestGenerator {
+public:
+    explicit UnknownTimesRequests(std::unique_ptr<RequestGenerator> inner)
+        : m_inner(std::move(inner))
+    {
+    }
+
+    void accept_building(BuildingGenerationResult const& building) override { m_inner->accept_building(building); }
+
+    NextRequests next_requests_at() override
+    {
+        if (m_inner->next_requests_at() == NextRequests::done())
+            return NextRequests::done();
+        return NextRequests::unknown();
+    }
+
+    std::vector<PassengerBlueprint> requests_at(Time time) override
+    {
+        if (m_inner->next_requests_at() != NextRequests::at(time))
+            return {};
+        return m_inner->requests_at(time);
+    }
+
+private:
+    std::unique_ptr<RequestGenerator> m_inner;
+};
+
+TEST_CASE("Request combiner with unknown times", "[generation][combiner]") {
+    HardcodedBuildingGenerator building_generator { { { 2, { 0, 5, 10, 15 } } } };
+    auto building = building_generator.generate_building();
+    REQUIRE_FALSE(building.has_error());
+
+    auto make_child = [](size_t i) -> std::unique_ptr<RequestGenerator> {
+        auto generator = std::make_unique<UniformFloorGenerator>(static_cast<long>(i), 20 + i, 0.1);
+        if (i % 2 == 1)
+            return std::make_unique<UnknownTimesRequests>(std::move(generator));
+        return generator;
+    };
+
+    std::vector<std::unique_ptr<RequestGenerator>> combined_children;
+    std::vector<std::unique_ptr<RequestGenerator>> separate;
+    for (size_t i = 0; i < 5; ++i) {
+        combined_children.push_back(make_child(i));
+        separate.push_back(make_child(i));
+        separate.back()->accept_building(building);
+    }
+
+    RequestCombiner combiner { std::move(combined_children) };
+    combiner.accept_building(building);
+
+    THEN("It asks the unknown generators every time and keeps generator order") {
+        size_t total_requests = 0;
+        for (Time time = 0; combiner.next_requests_at() != NextRequests::done(); ++time) {
+            REQUIRE(time < 100000);
+
+            std::vector<PassengerBlueprint> expected;
+            for (auto& generator : separate) {
+                auto next = generator->next_requests_at();
+                if (next.type == NextRequests::Type::Unknown || next == NextRequests::at(time)) {
+                    auto requests = generator->requests_at(time);
+                    expected.insert(expected.end(), requests.begin(), requests.end());
+                }
+            }
+
+            auto requests = combiner.requests_at(time);
+            REQUIRE(requests.size() == expected.size());
+            for (size_t i = 0; i < requests.size(); ++i) {
+                REQUIRE(requests[i].from == expected[i].from);
+                REQUIRE(requests[i].to == expected[i].to);
+            }
+            total_requests += requests.size();
+        }
+        REQUIRE(total_requests == 20 + 21 + 22 + 23 + 24);
+    }
+}
+
+TEST_CASE("Counter based request generation", "[generation][counter]") {
+    using RandomSource = IndependentRequestGenerator::RandomSource;
+
+    SECTION("Counter random numbers can be generated in any split") {
+        util::CounterRandom random { 783675 };
+        std::vector<uint32_t> whole(1000);
+        random.fill(500, whole);
+
+        std::vector<uint32_t> parts(1000);
+        random.fill(900, std::span(parts).subspan(400));
+        random.fill(500, std::span(parts).subspan(0, 400));
+        REQUIRE(whole == parts);
+
+        for (size_t i = 0; i < whole.size(); ++i)
+            REQUIRE(whole[i] == random.at(500 + i));
+
+        util::CounterRandom other_seed { 783676 };
+        REQUIRE(other_seed.at(500) != whole[0]);
+    }
+
+    HardcodedBuildingGenerator building_generator { { { 2, { 0, 5, 10, 15 } }, { 1, { 0, 20 } } } };
+    auto building = building_generator.generate_building();
+    REQUIRE_FALSE(building.has_error());
+
+    auto make_generator = [](long seed) -> std::unique_ptr<RequestGenerator> {
+        // More requests than fit in one block.
+        return RequestCombiner::create(
+            std::make_unique<UniformFloorGenerator>(seed, 10000, 0.5, 1, RandomSource::Counter),
+            std::make_unique<GroundFloorGenerator>(seed * 3, 5000, 0.2, 0, 2, RandomSource::Counter));
+    };
+
+    auto collect = [&](RequestGenerator& generator) {
+        generator.accept_building(building);
+        REQUIRE_FALSE(building.has_error());
+        std::vector<std::pair<Time, PassengerBlueprint>> requests;
+        Time last_time = 0;
+        while (true) {
+            auto next = generator.next_requests_at();
+            if (next.type != NextRequests::Type::At)
+                break;
+            REQUIRE(next.next_request_time >= last_time);
+            last_time = next.next_request_time;
+            for (auto& request : generator.requests_at(next.next_request_time))
+                requests.emplace_back(next.next_request_time, request);
+        }
+        return requests;
+    };
+
+    auto requests = collect(*make_generator(12));
+
+    THEN("All requests are generated and valid") {
+        REQUIRE(requests.size() == 15000);
+        for (auto& [at, request] : requests) {
+            REQUIRE(request.from != request.to);
+            REQUIRE(request.group < 2);
+            auto& reachable = building.blueprint().reachable_per_group[request.group];
+            REQUIRE(reachable.contains(request.from));
+            REQUIRE(reachable.contains(request.to));
+        }
+    }
+
+    THEN("The same seed gives the same requests") {
+        auto again = collect(*make_generator(12));
+        REQUIRE(again.size() == requests.size());
+        for (size_t i = 0; i < requests.size(); ++i) {
+            REQUIRE(again[i].first == requests[i].first);
+            REQUIRE(again[i].second.from == requests[i].second.from);
+            REQUIRE(again[i].second.to == requests[i].second.to);
+            REQUIRE(again[i].second.group == requests[i].second.group);
+            REQUIRE(again[i].second.capacity == requests[i].second.capacity);
+        }
+    }
+
+    THEN("A different seed gives different requests") {
+        auto other = collect(*make_generator(13));
+        REQUIRE(other.size() == requests.size());
+        bool any_different = false;
+        for (size_t i = 0; i < requests.size() && !any_different; ++i)
+            any_different = other[i].first != requests[i].first || other[i].second.to != requests[i].second.to;
+        REQUIRE(any_different);
+    }
+}
+
+TEST_CASE("Pipelined generation", "[generation][pipelined]") {
+    std::string const scenario = "named-scenario(basic-1)";
+    long const seed = 783675;
+
+    auto make_generator = [&] {
+        auto result = parse_scenario(scenario, seed);
+        REQUIRE(result.generator);
+        return std::move(result.generator);
+    };
+
+    SECTION("Gives the same building and requests as the generator itself") {
+        size_t queued_times = GENERATE(1, 2, 64);
+        PipelinedScenarioGenerator pipelined { make_generator(), queued_times };
+        auto live = make_generator();
+        REQUIRE(require_same_scenario(*live, pipelined) > 0);
+    }
+
+    SECTION("Can be destroyed while still producing") {
+        PipelinedScenarioGenerator pipelined { make_generator(), 1 };
+        REQUIRE_FALSE(pipelined.generate_building().has_error());
+        REQUIRE(pipelined.next_requests_at().type == NextRequests::Type::At);
+    }
+
+    SECTION("Falls back to the generator once it does not know the next requests") {
+        struct UnknownAfterFirst : public ScenarioGenerator {
+            BuildingGenerationResult generate_building() override
+            {
+                HardcodedBuildingGenerator building { { { 1, { 0, 5 } } } };
+                return building.generate_building();
+            }
+
+            NextRequests next_requests_at() override
+            {
+                if (!produced_first)
+                    return NextRequests::at(2);
+                return unknown_left > 0 ? NextRequests::unknown() : NextRequests::done();
+            }
+
+            std::vector<PassengerBlueprint> requests_at(Time) override
+            {
+                if (!produced_first) {
+                    produced_first = true;
+                    return { PassengerBlueprint { 0, 1, 0, 1 } };
+                }
+                --unknown_left;
+                return {};
+            }
+
+            bool produced_first = false;
+            size_t unknown_left = 2;
+        };
+
+        auto generator = std::make_unique<UnknownAfterFirst>();
+        auto& inner = *generator;
+        PipelinedScenarioGenerator pipelined { std::move(generator), 4 };
+        REQUIRE_FALSE(pipelined.generate_building().has_error());
+
+        REQUIRE(pipelined.next_requests_at() == NextRequests::at(2));
+        REQUIRE(pipelined.requests_at(2).size() == 1);
+        REQUIRE(pipelined.next_requests_at() == NextRequests::unknown());
+        REQUIRE(pipelined.requests_at(3).empty());
+        REQUIRE(pipelined.next_requests_at() == NextRequests::unknown());
+        REQUIRE(pipelined.requests_at(4).empty());
+        REQUIRE(inner.unknown_left == 0);
+        REQUIRE(pipelined.next_requests_at() == NextRequests::done());
+    }
+}
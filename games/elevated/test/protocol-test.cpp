@@ -48,7 +48,7 @@ TEST_CASE("Text based protocol for process algorithm", "[protocol]") {
             REQUIRE(elevator.current_state() == Elevated::ElevatorState::State::DoorsOpen);
 
             WHEN("Picking up no passengers") {
-                std::vector<Passenger> line {};
+                FloorQueue line {};
                 elevator.transfer_passengers(line);
                 REQUIRE(elevator.time_until_next_event().has_value());
                 auto result = elevator.update(elevator.time_until_next_event().value());
@@ -64,7 +64,7 @@ TEST_CASE("Text based protocol for process algorithm", "[protocol]") {
             
             WHEN("Picking up a passenger") {
                 Height target_height = height + 1;
-                std::vector<Passenger> line {
+                FloorQueue line {
                     {1, {height, target_height, group_id, 0}}
                 };
                 elevator.transfer_passengers(line);
@@ -83,7 +83,7 @@ TEST_CASE("Text based protocol for process algorithm", "[protocol]") {
 
             WHEN("Picking up multiple passengers with same target") {
                 Height target_height = height + 1;
-                std::vector<Passenger> line {
+                FloorQueue line {
                     {1, {height, target_height, group_id, 0}},
                     {2, {height, target_height, group_id, 0}},
                     {3, {height, target_height, group_id, 0}},
@@ -105,7 +105,7 @@ TEST_CASE("Text based protocol for process algorithm", "[protocol]") {
             WHEN("Picking up multiple passengers with different targets") {
                 Height target_height1 = height + 1;
                 Height target_height2 = height + 2;
-                std::vector<Passenger> line {
+                FloorQueue line {
                     {1, {height, target_height1, group_id, 0}},
                     {2, {height, target_height2, group_id, 0}},
                 };
@@ -127,7 +127,7 @@ TEST_CASE("Text based protocol for process algorithm", "[protocol]") {
             WHEN("Picking up multiple passengers with different targets with higher first") {
                 Height target_height1 = height + 1;
                 Height target_height2 = height + 2;
-                std::vector<Passenger> line {
+                FloorQueue line {
                     {1, {height, target_height2, group_id, 0}},
                     {2, {height, target_height1, group_id, 0}},
                 };
@@ -150,7 +150,7 @@ TEST_CASE("Text based protocol for process algorithm", "[protocol]") {
                 Height target_height1 = height + 1;
                 Height target_height2 = height + 2;
                 Height target_height3 = height + 3;
-                std::vector<Passenger> line {
+                FloorQueue line {
                     {1, {height, target_height3, group_id, 0}},
                     {2, {height, target_height1, group_id, 0}},
                     {3, {height, target_height1, group_id, 0}},
@@ -0,0 +1,82 @@
+// Started inside the sandbox by sandbox-test.cpp, reports which calls the sandbox let through.
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+static char const* result_of(long result)
+{
+    if (result >= 0)
+        return "allowed";
+    return strerrorname_np(errno);
+}
+
+static long fork_with(unsigned long flags)
+{
+    long pid = syscall(SYS_clone, flags | SIGCHLD, 0, 0, 0, 0);
+    if (pid == 0)
+        _exit(0);
+    if (pid > 0)
+        waitpid(static_cast<pid_t>(pid), nullptr, 0);
+    return pid;
+}
+
+static int open_descriptors()
+{
+    int open = 0;
+    for (int fd = STDERR_FILENO + 1; fd < 1024; ++fd) {
+        if (fcntl(fd, F_GETFD) >= 0)
+            ++open;
+    }
+    return open;
+}
+
+static size_t forks_until_refused(size_t most)
+{
+    std::vector<pid_t> children;
+    while (children.size() < most) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            pause();
+            _exit(0);
+        }
+        if (pid < 0)
+            break;
+        children.push_back(pid);
+    }
+    for (auto pid : children) {
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+    }
+    return children.size();
+}
+
+static unsigned long long limit_of(int resource)
+{
+    struct rlimit limit {};
+    getrlimit(resource, &limit);
+    return limit.rlim_cur;
+}
+
+int main()
+{
+    std::printf("unshare %s", result_of(unshare(CLONE_NEWUSER)));
+    std::printf(" clone-newuser %s", result_of(fork_with(CLONE_NEWUSER)));
+    std::printf(" clone-newnet %s", result_of(fork_with(CLONE_NEWNET)));
+    std::printf(" clone %s", result_of(fork_with(0)));
+#ifdef SYS_clone3
+    std::printf(" clone3 %s", result_of(syscall(SYS_clone3, nullptr, 0)));
+#endif
+    std::printf(" fds %d", open_descriptors());
+    std::printf(" nproc %llu cpu %llu", limit_of(RLIMIT_NPROC), limit_of(RLIMIT_CPU));
+    std::printf(" forks %zu", forks_until_refused(100));
+    std::printf("\n");
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include <catch2/catch.hpp>
+#include "../../../util/Process.h"
+#include <fcntl.h>
+#include <filesystem>
+#include <unistd.h>
+
+#ifdef __linux__
+
+TEST_CASE("Sandboxed processes", "[process][sandbox]") {
+    // The probe is linked statically, so a root with only the probe in it is enough.
+    auto root = std::filesystem::temp_directory_path() / ("sandbox-test-" + std::to_string(getpid()));
+    std::filesystem::create_directories(root);
+    std::filesystem::copy_file(SANDBOX_PROBE_PATH, root / "probe", std::filesystem::copy_options::overwrite_existing);
+    // The sandbox may run as another user, which must be able to get to the probe.
+    std::filesystem::permissions(root, std::filesystem::perms::owner_all | std::filesystem::perms::group_read | std::filesystem::perms::group_exec
+        | std::filesystem::perms::others_read | std::filesystem::perms::others_exec);
+
+    util::SubProcess::Sandbox sandbox;
+    sandbox.root_directory = root.string();
+    sandbox.max_processes = 8;
+    sandbox.max_cpu_seconds = 5;
+    // Not close on exec, the sandbox has to close it itself.
+    int leaked = open("/dev/null", O_RDONLY);
+    auto process = util::SubProcess::create_sandboxed({ "/probe" }, sandbox);
+    close(leaked);
+
+    if (!process) {
+        WARN("Could not start a sandbox, user namespaces are probably not available");
+    } else {
+        std::string line;
+        REQUIRE(process->readLineWithTimeout(line, 5000));
+        // Its children would not be counted without a cgroup.
+        bool measures_cpu_time = process->cpu_time_microseconds().has_value();
+        process->stop();
+        CAPTURE(line);
+
+        THEN("Creating namespaces is denied") {
+            REQUIRE(line.find("unshare EPERM") != std::string::npos);
+            REQUIRE(line.find("clone-newuser EPERM") != std::string::npos);
+            REQUIRE(line.find("clone-newnet EPERM") != std::string::npos);
+        }
+
+        THEN("Plain processes can still be created") {
+            REQUIRE(line.find("clone allowed") != std::string::npos);
+        }
+
+        THEN("No descriptors leak in") {
+            REQUIRE(line.find("fds 0") != std::string::npos);
+        }
+
+        THEN("Without a cgroup processes and cpu time are limited through rlimits") {
+            REQUIRE(line.find("nproc 8 cpu 5") != std::string::npos);
+            REQUIRE(line.find("forks 100") == std::string::npos);
+            REQUIRE_FALSE(measures_cpu_time);
+        }
+
+        THEN("clone3 looks like it does not exist") {
+            if (line.find("clone3") != std::string::npos)
+                REQUIRE(line.find("clone3 ENOSYS") != std::string::npos);
+        }
+    }
+
+    std::filesystem::remove_all(root);
+}
+
+#endif
@@ -2,9 +2,17 @@
 #include "StoringEventListener.h"
 #include <catch2/catch.hpp>
 #include <elevated/Simulation.h>
+#include <elevated/SimulationBatch.h>
 #include <elevated/Types.h>
 #include <elevated/algorithm/CyclingAlgorithm.h>
 #include <elevated/generation/FullGenerators.h>
+#include <elevated/stats/ElevatorStatsListener.h>
+#include <elevated/stats/EventLogStats.h>
+#include <elevated/stats/PassengerStats.h>
+#include <elevated/stats/PowerStatsListener.h>
+#include <elevated/stats/SpecialEventsListener.h>
+#include <algorithm>
+#include <limits>
 
 using namespace Elevated;
 
@@ -396,3 +404,345 @@ TEST_CASE("Simulator", "[simulator]") {
         }
     }
 }
+
+// Cycles every elevator between the lowest and highest floor, and records what it sees when doors open.
+class ObservingAlgorithm : public ElevatedAlgorithm {
+public:
+    struct Observation {
+        Time at;
+        ElevatorID id;
+        size_t waiting;
+        size_t loaded;
+
+        bool operator==(Observation const&) const = default;
+    };
+    std::vector<Observation> observations;
+
+    ScenarioAccepted accept_scenario_description(BuildingGenerationResult const& building) override
+    {
+        for (auto& floors : building.blueprint().reachable_per_group) {
+            m_lowest = std::min(m_lowest, *std::min_element(floors.begin(), floors.end()));
+            m_highest = std::max(m_highest, *std::max_element(floors.begin(), floors.end()));
+        }
+        return ScenarioAccepted::accepted();
+    }
+
+    std::optional<ElevatorState::PassengerCallback> on_doors_open(Time at, ElevatorID id, BuildingState const& building) override
+    {
+        size_t loaded = 0;
+        for (ElevatorID other = 0; other < building.num_elevators(); ++other)
+            loaded += building.elevator(other).passengers().size();
+        observations.push_back({ at, id, building.passengers_at(building.elevator(id).height()).size(), loaded });
+        return std::nullopt;
+    }
+
+    std::vector<AlgorithmResponse> on_inputs(Time, BuildingState const& building, std::vector<AlgorithmInput> inputs) override
+    {
+        std::vector<AlgorithmResponse> responses;
+        if (!m_running) {
+            m_running = true;
+            for (ElevatorID id = 0; id < building.num_elevators(); ++id)
+                responses.push_back(AlgorithmResponse::move_elevator_to(id, building.elevator(id).height()));
+            return responses;
+        }
+
+        for (auto const& input : inputs) {
+            if (input.type() == AlgorithmInput::Type::ElevatorClosedDoors) {
+                auto height = building.elevator(input.elevator_id()).height();
+                responses.push_back(AlgorithmResponse::move_elevator_to(input.elevator_id(), height == m_lowest ? m_highest : m_lowest));
+            }
+        }
+        return responses;
+    }
+
+private:
+    Height m_lowest { std::numeric_limits<Height>::max() };
+    Height m_highest { 0 };
+    bool m_running = false;
+};
+
+TEST_CASE("Groups in parallel", "[simulator][parallel]") {
+    // Both groups stop at the same floors at the same time, so the algorithm sees the passengers
+    // the first elevator took when asked about the second one.
+    auto observe = [](size_t threads) {
+        std::vector<std::pair<size_t, std::vector<PassengerBlueprint>>> requests;
+        for (size_t t = 0; t < 200; t += 7)
+            requests.push_back({ t, { { 0, 10, 0 }, { 0, 10, 1 }, { 10, 0, GroupID(t % 2) }, { 10, 0, GroupID(1 - t % 2) } } });
+        auto algorithm = std::make_unique<ObservingAlgorithm>();
+        auto& observing = *algorithm;
+        Simulation simulation { hardcoded({ { 2, { 0, 10 } }, { 2, { 0, 10 } } }, std::move(requests)), std::move(algorithm) };
+        simulation.run_groups_in_parallel(threads);
+        REQUIRE(simulation.run_full_simulation().type == SimulatorResult::Type::SuccessFull);
+        return observing.observations;
+    };
+
+    auto sequential = observe(1);
+    auto parallel = observe(2);
+    REQUIRE_FALSE(sequential.empty());
+    REQUIRE(sequential == parallel);
+}
+
+TEST_CASE("Simulation batch", "[simulator][batch]") {
+    auto generator_for = [](size_t index) {
+        std::vector<std::pair<size_t, std::vector<PassengerBlueprint>>> requests;
+        for (size_t t = index; t < 400; t += 7 + index) {
+            if (t % 2 == 0)
+                requests.push_back({ t, { { 0, 10, 0 }, { 10, 5, 0 } } });
+            else
+                requests.push_back({ t, { { 5, 0, 0 } } });
+        }
+        return hardcoded({ { 2, { 0, 5, 10 } } }, std::move(requests));
+    };
+
+    auto algorithm_for = [](size_t) { return std::make_unique<CyclingAlgorithm>(); };
+
+    size_t const simulations = 9;
+
+    auto check_against_single_runs = [&](SimulationBatch const& batch) {
+        auto summary = batch.summary();
+        REQUIRE(summary.simulations == simulations);
+        REQUIRE(summary.successful == simulations);
+        REQUIRE(summary.results.at(SimulatorResult::Type::SuccessFull) == simulations);
+
+        for (size_t i = 0; i < simulations; ++i) {
+            Simulation simulation { generator_for(i), algorithm_for(i) };
+            auto passenger_stats = simulation.construct_and_add_listener<PassengerStatsListener>();
+            auto listener = std::make_shared<StoringEventListener>();
+            simulation.add_listener(listener);
+            auto result = simulation.run_full_simulation();
+
+            REQUIRE(batch.result(i).type == result.type);
+            auto& stats = batch.stats(i);
+            REQUIRE(stats.total_time == simulation.building().current_time());
+            REQUIRE(stats.requests == listener->request_created_events.size());
+            REQUIRE(stats.delivered == listener->passenger_leave_events.size());
+            REQUIRE(stats.doors_opened == listener->elevator_opened_events.size());
+            REQUIRE(stats.max_wait_time == passenger_stats->max_wait_times());
+            REQUIRE(stats.max_travel_time == passenger_stats->max_travel_times());
+            REQUIRE((double)stats.total_wait_time / (double)stats.delivered == Approx(passenger_stats->average_wait_time()));
+        }
+    };
+
+    GIVEN("A batch of simulations of the same building") {
+        SimulationBatch batch { simulations, generator_for, algorithm_for };
+        REQUIRE(batch.size() == simulations);
+        REQUIRE(batch.blueprint() != nullptr);
+
+        WHEN("It is run on the calling thread") {
+            batch.run();
+
+            THEN("Every simulation matches running it on its own") {
+                check_against_single_runs(batch);
+            }
+        }
+
+        WHEN("It is run on multiple threads") {
+            util::WorkerPool workers { 3 };
+            batch.run(&workers);
+
+            THEN("Every simulation matches running it on its own") {
+                check_against_single_runs(batch);
+            }
+        }
+    }
+
+    GIVEN("A batch where one simulation generates a different building") {
+        SimulationBatch batch { 3, [&](size_t index) {
+                                   if (index == 1)
+                                       return hardcoded({ { 1, { 0, 5 } } }, { { 0, { { 0, 5, 0 } } } });
+                                   return generator_for(index);
+                               },
+            algorithm_for };
+        batch.run();
+
+        THEN("Only that simulation fails to generate") {
+            REQUIRE(batch.result(0).type == SimulatorResult::Type::SuccessFull);
+            REQUIRE(batch.result(1).type == SimulatorResult::Type::GenerationFailed);
+            REQUIRE(batch.result(2).type == SimulatorResult::Type::SuccessFull);
+            REQUIRE(batch.summary().successful == 2);
+        }
+    }
+}
+
+TEST_CASE("Async listeners", "[simulator][async]") {
+    auto make_generator = [] {
+        std::vector<std::pair<size_t, std::vector<PassengerBlueprint>>> requests;
+        for (size_t t = 0; t < 600; t += 3) {
+            if (t % 2 == 0)
+                requests.push_back({ t, { { 0, 10, 0 }, { 10, 5, 0 }, { 5, 15, 0 } } });
+            else
+                requests.push_back({ t, { { 5, 0, 0 }, { 15, 0, 0 } } });
+        }
+        return hardcoded({ { 3, { 0, 5, 10, 15 } } }, std::move(requests));
+    };
+
+    auto run = [&](bool async, size_t queued_events) {
+        Simulation simulation { make_generator(), std::make_unique<CyclingAlgorithm>() };
+        if (async)
+            simulation.run_listeners_async(queued_events);
+        auto passenger_stats = simulation.construct_and_add_listener<PassengerStatsListener>();
+        auto listener = simulation.construct_and_add_listener<StoringEventListener>();
+        REQUIRE(simulation.run_full_simulation().type == SimulatorResult::Type::SuccessFull);
+        return std::pair { listener, passenger_stats };
+    };
+
+    auto require_same_elevator = [](ElevatorState const& expected, ElevatorState const& actual) {
+        REQUIRE(expected.id == actual.id);
+        REQUIRE(expected.height() == actual.height());
+        REQUIRE(expected.target_height() == actual.target_height());
+        REQUIRE(expected.current_state() == actual.current_state());
+        REQUIRE(expected.filled_capacity() == actual.filled_capacity());
+        REQUIRE(expected.passengers().size() == actual.passengers().size());
+        REQUIRE(expected.passengers().destinations() == actual.passengers().destinations());
+    };
+
+    auto [expected, expected_stats] = run(false, 0);
+    REQUIRE_FALSE(expected->no_events());
+
+    size_t queued_events = GENERATE(1, 16, 4096);
+    auto [actual, actual_stats] = run(true, queued_events);
+
+    THEN("The listeners get the same events with the same elevator states") {
+        REQUIRE(expected->request_created_events.size() == actual->request_created_events.size());
+        for (size_t i = 0; i < expected->request_created_events.size(); ++i) {
+            auto& [expected_at, expected_passenger] = expected->request_created_events[i];
+            auto& [actual_at, actual_passenger] = actual->request_created_events[i];
+            REQUIRE(expected_at == actual_at);
+            REQUIRE(expected_passenger.id == actual_passenger.id);
+            REQUIRE(expected_passenger.from == actual_passenger.from);
+            REQUIRE(expected_passenger.to == actual_passenger.to);
+            REQUIRE(expected_passenger.group == actual_passenger.group);
+        }
+
+        REQUIRE(expected->passenger_enter_events.size() == actual->passenger_enter_events.size());
+        for (size_t i = 0; i < expected->passenger_enter_events.size(); ++i) {
+            REQUIRE(std::get<0>(expected->passenger_enter_events[i]) == std::get<0>(actual->passenger_enter_events[i]));
+            REQUIRE(std::get<1>(expected->passenger_enter_events[i]).id == std::get<1>(actual->passenger_enter_events[i]).id);
+            REQUIRE(std::get<2>(expected->passenger_enter_events[i]) == std::get<2>(actual->passenger_enter_events[i]));
+        }
+        REQUIRE(expected->passenger_leave_events == actual->passenger_leave_events);
+
+        auto require_same_elevator_events = [&](auto const& expected_events, auto const& actual_events) {
+            REQUIRE(expected_events.size() == actual_events.size());
+            for (size_t i = 0; i < expected_events.size(); ++i) {
+                REQUIRE(std::get<0>(expected_events[i]) == std::get<0>(actual_events[i]));
+                require_same_elevator(std::get<std::tuple_size_v<std::decay_t<decltype(expected_events[i])>> - 1>(expected_events[i]),
+                    std::get<std::tuple_size_v<std::decay_t<decltype(actual_events[i])>> - 1>(actual_events[i]));
+            }
+        };
+        require_same_elevator_events(expected->elevator_opened_events, actual->elevator_opened_events);
+        require_same_elevator_events(expected->elevator_closed_events, actual->elevator_closed_events);
+        require_same_elevator_events(expected->elevator_set_target_events, actual->elevator_set_target_events);
+        require_same_elevator_events(expected->elevator_stopped_events, actual->elevator_stopped_events);
+        require_same_elevator_events(expected->elevator_moved_events, actual->elevator_moved_events);
+    }
+
+    THEN("Stats computed from the events are the same") {
+        REQUIRE(expected_stats->max_wait_times() == actual_stats->max_wait_times());
+        REQUIRE(expected_stats->max_travel_times() == actual_stats->max_travel_times());
+        REQUIRE(expected_stats->max_times_door_opened() == actual_stats->max_times_door_opened());
+        REQUIRE(expected_stats->average_wait_time() == Approx(actual_stats->average_wait_time()));
+    }
+}
+
+TEST_CASE("Event log stats", "[simulator][event-log]") {
+    std::vector<std::pair<size_t, std::vector<PassengerBlueprint>>> requests;
+    for (size_t t = 0; t < 500; t += 4) {
+        if (t % 3 == 0)
+            requests.push_back({ t, { { 0, 10, 0, 1 }, { 15, 5, 0, 1 }, { 5, 15, 0, 1 } } });
+        else
+            requests.push_back({ t, { { 10, 0, 0, 1 }, { 5, 0, 0, 1 } } });
+    }
+
+    Simulation simulation { hardcoded({ { 3, { 0, 5, 10, 15 } } }, std::move(requests)), std::make_unique<CyclingAlgorithm>() };
+    auto passenger_stats = simulation.construct_and_add_listener<PassengerStatsListener>();
+    auto power_stats = simulation.construct_and_add_listener<PowerStatsListener>();
+    auto elevator_stats = simulation.construct_and_add_listener<ElevatorStatsListener>();
+    auto special_stats = simulation.construct_and_add_listener<SpecialEventsListener>();
+    auto log = simulation.construct_and_add_listener<EventLog>();
+    REQUIRE(simulation.run_full_simulation().type == SimulatorResult::Type::SuccessFull);
+    REQUIRE(log->size() > 0);
+
+    auto require_same_as_listeners = [&](EventLogStats const& stats) {
+        REQUIRE(stats.average_wait_time == passenger_stats->average_wait_time());
+        REQUIRE(stats.max_wait_time == passenger_stats->max_wait_times());
+        REQUIRE(stats.max_travel_time == passenger_stats->max_travel_times());
+        REQUIRE(stats.average_travel_time == passenger_stats->average_travel_time());
+        REQUIRE(stats.max_times_door_opened == passenger_stats->max_times_door_opened());
+        REQUIRE(stats.first_stop_passengers == passenger_stats->first_stop_passengers());
+        REQUIRE(stats.average_stops_passengers == passenger_stats->average_stops_passengers());
+
+        REQUIRE(stats.times_door_opened == power_stats->times_door_opened());
+        REQUIRE(stats.total_distance_travelled == power_stats->total_distance_travelled());
+        REQUIRE(stats.time_stopped_with_passengers == power_stats->time_stopped_with_passengers());
+
+        REQUIRE(stats.roller_coaster_events == special_stats->total_roller_coaster_events());
+        REQUIRE(stats.travelling_stops == special_stats->total_travelling_stops());
+
+        REQUIRE(stats.max_elevator_travel_distance == elevator_stats->max_travel_distance());
+        REQUIRE(stats.min_elevator_travel_distance == elevator_stats->min_travel_distance());
+        REQUIRE(stats.avg_elevator_travel_distance == elevator_stats->avg_travel_distance());
+        REQUIRE(stats.sum_elevator_travel_distance == elevator_stats->total_travel_distance());
+        REQUIRE(stats.max_elevator_doors_opened == elevator_stats->max_doors_opened());
+        REQUIRE(stats.min_elevator_doors_opened == elevator_stats->min_doors_opened());
+        REQUIRE(stats.avg_elevator_doors_opened == elevator_stats->avg_doors_opened());
+        REQUIRE(stats.max_elevator_time_stopped == elevator_stats->max_time_stopped());
+        REQUIRE(stats.min_elevator_time_stopped == elevator_stats->min_time_stopped());
+        REQUIRE(stats.avg_elevator_time_stopped == elevator_stats->avg_time_stopped());
+
+        REQUIRE(stats.requests == stats.delivered);
+        REQUIRE(stats.p95_wait_time <= stats.max_wait_time);
+        REQUIRE(stats.max_elevator_load > 0);
+    };
+
+    THEN("The stats from the log are the same as from the listeners") {
+        require_same_as_listeners(evaluate_event_log(*log));
+    }
+
+    THEN("A serialized log gives the same stats") {
+        auto bytes = log->serialize();
+        auto loaded = EventLog::deserialize(bytes);
+        REQUIRE(loaded.has_value());
+        REQUIRE(loaded->size() == log->size());
+        require_same_as_listeners(evaluate_event_log(*loaded));
+
+        REQUIRE_FALSE(EventLog::deserialize(std::string_view(bytes).substr(0, bytes.size() - 1)).has_value());
+        REQUIRE_FALSE(EventLog::deserialize("not a log").has_value());
+    }
+}
+
+TEST_CASE("Event log stats with an idle elevator", "[simulator][event-log]") {
+    // The cycling algorithm only ever moves the first elevator.
+    Simulation simulation { hardcoded({ { 2, { 0, 5, 10 } } }, { { 0, { { 0, 10, 0, 1 } } }, { 20, { { 10, 5, 0, 1 } } } }), std::make_unique<CyclingAlgorithm>() };
+    auto elevator_stats = simulation.construct_and_add_listener<ElevatorStatsListener>();
+    auto log = simulation.construct_and_add_listener<EventLog>();
+    REQUIRE(simulation.run_full_simulation().type == SimulatorResult::Type::SuccessFull);
+    REQUIRE(log->elevator_count() == 2);
+
+    auto require_idle_elevator_counted = [&](EventLog const& from) {
+        auto stats = evaluate_event_log(from);
+        REQUIRE(stats.min_elevator_travel_distance == 0);
+        REQUIRE(stats.min_elevator_doors_opened == 0);
+        REQUIRE(stats.sum_elevator_travel_distance > 0);
+        REQUIRE(stats.avg_elevator_travel_distance == stats.sum_elevator_travel_distance / 2.0);
+
+        REQUIRE(stats.min_elevator_travel_distance == elevator_stats->min_travel_distance());
+        REQUIRE(stats.avg_elevator_travel_distance == elevator_stats->avg_travel_distance());
+        REQUIRE(stats.max_elevator_doors_opened == elevator_stats->max_doors_opened());
+        REQUIRE(stats.min_elevator_doors_opened == elevator_stats->min_doors_opened());
+        REQUIRE(stats.avg_elevator_doors_opened == elevator_stats->avg_doors_opened());
+        REQUIRE(stats.min_elevator_time_stopped == elevator_stats->min_time_stopped());
+        REQUIRE(stats.avg_elevator_time_stopped == elevator_stats->avg_time_stopped());
+    };
+
+    THEN("The idle elevator is part of the elevator stats") {
+        require_idle_elevator_counted(*log);
+    }
+
+    THEN("The elevator count survives serialization") {
+        auto loaded = EventLog::deserialize(log->serialize());
+        REQUIRE(loaded.has_value());
+        REQUIRE(loaded->elevator_count() == 2);
+        require_idle_elevator_counted(*loaded);
+    }
+}
@@ -2,6 +2,7 @@
 
 #include "../ImGui/ImGuiExtensions.h"
 
+#include <algorithm>
 #include <array>
 #include <cstring>
 #include <imgui.h>
@@ -9,6 +10,8 @@
 
 namespace Elevated {
 
+static constexpr int max_slider_range = 10000;
+
 void VisualGeneratorSettings::varargsValue(
   std::string_view name, const std::function<void(GeneratorSettings&, size_t, bool)>& func,
   size_t& count) {
@@ -191,7 +194,13 @@ void VisualGeneratorSettings::getUnsignedValue(std::string_view name, uint32_t&
         return;
     }
     val = value;
-    ImGui::SliderInt(label(name), &val, min, max);
+    // A slider cannot pick single values out of large ranges (like the bulk amounts), so those are typed in.
+    if (max - min > max_slider_range) {
+        ImGui::InputInt(label(name), &val);
+        val = std::clamp(val, min, max);
+    } else {
+        ImGui::SliderInt(label(name), &val, min, max);
+    }
     value = val;
 }
 void VisualGeneratorSettings::getDoubleValue(std::string_view name, double& value, double min,
@@ -20,6 +20,7 @@
 #include <elevated/Building.h>
 #include <elevated/Simulation.h>
 #include <elevated/algorithm/ProcessAlgorithm.h>
+#include <elevated/generation/factory/CompiledScenario.h>
 #include <elevated/generation/factory/FactoryFactory.h>
 #include <elevated/generation/factory/OutputSettings.h>
 #include <elevated/generation/factory/StringSettings.h>
@@ -124,6 +125,7 @@ int main() {
     };
 
     std::vector<StoredCase> stored_cases;
+    Elevated::ScenarioCache stored_case_scenarios;
     for (auto& config_case : config.get_value("stored-cases"))
         stored_cases.push_back(StoredCase{config_case});
 
@@ -597,7 +599,7 @@ int main() {
                     floorShape.setPosition(5.0, floorHeight);
                     simulation_texture.draw(floorShape);
 
-                    auto& queue = simulation->building().passengers_at(floor);
+                    auto queue = simulation->building().passengers_at(floor).in_arrival_order();
                     double spot = floorWidth - 5.0;
                     double offsets[] = {3.0, 20.};
                     size_t i = 0;
@@ -691,9 +693,8 @@ int main() {
         if (running_all) {
             if (!all_simulator.has_value()) {
                 if (running_case < stored_cases.size()) {
-                    auto all_factory = Elevated::scenarioFactories().createGenerator("all-root");
-                    Elevated::StringSettings strSettings(stored_cases[running_case].text);
-                    auto generator = all_factory->visit(strSettings);
+                    // Stored cases have always run with the default seed of the settings engine.
+                    auto generator = stored_case_scenarios.parse(stored_cases[running_case].text, std::minstd_rand::default_seed).generator;
 
                     std::vector<std::string> command;
                     for (auto& value : command_text) {
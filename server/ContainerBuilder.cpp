@@ -1,29 +1,140 @@
 #include "ContainerBuilder.h"
 #include "../util/Process.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <filesystem>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
 #include <vector>
 
 namespace BBServer {
 
-std::optional<std::string> build_single_file_container(std::string const& file_path, std::string container_name)
+using BuildResult = std::optional<std::string>;
+
+// At most this many builds run at once, and at most per_toolchain_builds of one
+// language so slow java/c# builds cannot take every slot.
+static constexpr size_t max_concurrent_builds = 4;
+static constexpr size_t per_toolchain_builds = 2;
+// Beyond this many waiting builds uploads are refused instead of queued.
+static constexpr size_t max_queued_builds = 32;
+
+static constexpr char const* build_cache_directory = "bots-data/build-cache/";
+static constexpr char const* build_cache_image = "localhost/bottlebats-build-cache:";
+
+static std::optional<std::string> read_file(std::filesystem::path const& path)
 {
-    auto absolute_path = std::filesystem::canonical(file_path);
-    auto last_slash = file_path.find_last_of('/');
-    auto filename = file_path.substr(last_slash + 1);
+    std::ifstream file { path, std::ios::binary };
+    if (!file)
+        return std::nullopt;
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
 
-    if (!std::filesystem::exists(absolute_path))
-        return "File upload failed :(";
+// FNV-1a, only has to be stable between runs. A hit is always checked
+// against the stored source so collisions cannot give you another bot.
+static uint64_t content_hash(std::string_view data, uint64_t hash = 0xcbf29ce484222325ull)
+{
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
 
-    auto last_dot = filename.find_last_of('.');
-    if (last_dot == std::string::npos)
-        return "No extension: " + filename;
+// Everything in bots-scripts/<ext>/ defines the toolchain, so changing the
+// Dockerfile (or its base image version) invalidates the cache.
+static std::string toolchain_version(std::string const& extension)
+{
+    std::vector<std::filesystem::path> files;
+    for (auto& entry : std::filesystem::directory_iterator("bots-scripts/" + extension))
+        files.push_back(entry.path());
+    std::sort(files.begin(), files.end());
 
-    auto extension = filename.substr(last_dot + 1);
+    uint64_t hash = content_hash(extension);
+    for (auto& file : files) {
+        hash = content_hash(file.filename().string(), hash);
+        hash = content_hash(read_file(file).value_or(""), hash);
+    }
+    std::ostringstream version;
+    version << std::hex << hash;
+    return version.str();
+}
 
-    if (!std::filesystem::exists("bots-scripts/" + extension + "/"))
-        return "Unknown filetype: " + extension;
+static bool run_podman(std::vector<std::string> arguments)
+{
+    arguments.insert(arguments.begin(), "podman");
+    auto process = util::SubProcess::create(std::move(arguments), util::SubProcess::StderrState::Ignored);
+    if (!process)
+        return false;
+    std::string line;
+    while (process->readLine(line)) {
+    }
+    auto result = process->stop();
+    return result.exitCode.has_value() && result.exitCode.value() == 0;
+}
 
+class BuildQueue {
+public:
+    // False if the queue is full.
+    bool acquire(std::string const& extension)
+    {
+        std::unique_lock lock(m_lock);
+        if (m_waiting >= max_queued_builds)
+            return false;
+        ++m_waiting;
+        m_released.wait(lock, [&] {
+            return m_running < max_concurrent_builds && m_running_per_toolchain[extension] < per_toolchain_builds;
+        });
+        --m_waiting;
+        ++m_running;
+        ++m_running_per_toolchain[extension];
+        return true;
+    }
+
+    void release(std::string const& extension)
+    {
+        {
+            std::lock_guard lock(m_lock);
+            --m_running;
+            --m_running_per_toolchain[extension];
+        }
+        // Waiters may be waiting on different toolchains, so one might not be enough.
+        m_released.notify_all();
+    }
+
+private:
+    std::mutex m_lock;
+    std::condition_variable m_released;
+    size_t m_running { 0 };
+    size_t m_waiting { 0 };
+    std::unordered_map<std::string, size_t> m_running_per_toolchain;
+};
+
+static BuildQueue build_queue;
+
+static std::mutex cache_lock;
+// Identical uploads arriving together wait for the first one instead of building again.
+static std::unordered_map<std::string, std::pair<std::string, std::shared_future<BuildResult>>> builds_in_flight;
+// Failing builds only live in memory, a retry after a restart is cheap enough.
+// A failure can also come from the machine (e.g. the registry being unreachable),
+// so they are forgotten after a while.
+struct FailedBuild {
+    std::string source;
+    std::string message;
+    std::chrono::steady_clock::time_point failed_at;
+};
+static std::unordered_map<std::string, FailedBuild> failed_builds;
+static constexpr size_t max_failed_builds = 256;
+static constexpr std::chrono::minutes failed_build_lifetime { 10 };
+
+static BuildResult run_build_script(std::string const& extension, std::filesystem::path const& absolute_path, std::string const& container_name)
+{
     std::unique_ptr<util::SubProcess> process = util::SubProcess::create( {"bots-scripts/" + extension + "/" + "build.sh", absolute_path, container_name }, util::SubProcess::StderrState::Readable);
 
     if (!process)
@@ -50,5 +161,122 @@ std::optional<std::string> build_single_file_container(std::string const& file_p
     return {};
 }
 
+static bool cached_source_matches(std::string const& key, std::string const& source)
+{
+    auto stored = read_file(build_cache_directory + key);
+    return stored.has_value() && *stored == source;
+}
+
+std::optional<std::string> build_single_file_container(std::string const& file_path, std::string container_name)
+{
+    auto absolute_path = std::filesystem::canonical(file_path);
+    auto last_slash = file_path.find_last_of('/');
+    auto filename = file_path.substr(last_slash + 1);
+
+    if (!std::filesystem::exists(absolute_path))
+        return "File upload failed :(";
+
+    auto last_dot = filename.find_last_of('.');
+    if (last_dot == std::string::npos)
+        return "No extension: " + filename;
+
+    auto extension = filename.substr(last_dot + 1);
+
+    if (!std::filesystem::exists("bots-scripts/" + extension + "/"))
+        return "Unknown filetype: " + extension;
+
+    auto contents = read_file(absolute_path);
+    if (!contents.has_value())
+        return "File upload failed :(";
+
+    // The file name is part of the build (java class names, python entrypoint).
+    std::string source = filename + '\0' + *contents;
+    std::ostringstream key_stream;
+    key_stream << extension << '-' << toolchain_version(extension) << '-' << std::hex << content_hash(source);
+    auto key = key_stream.str();
+    auto cached_image = build_cache_image + key;
+
+    std::promise<BuildResult> promise;
+    std::shared_future<BuildResult> other_build;
+    bool building = false;
+    {
+        std::lock_guard lock(cache_lock);
+        if (auto failed = failed_builds.find(key); failed != failed_builds.end()) {
+            if (std::chrono::steady_clock::now() - failed->second.failed_at >= failed_build_lifetime)
+                failed_builds.erase(failed);
+            else if (failed->second.source == source)
+                return failed->second.message;
+        }
+
+        auto in_flight = builds_in_flight.find(key);
+        if (in_flight == builds_in_flight.end()) {
+            builds_in_flight.emplace(key, std::make_pair(source, promise.get_future().share()));
+            building = true;
+        } else if (in_flight->second.first == source) {
+            other_build = in_flight->second.second;
+        }
+    }
+
+    auto use_cached_image = [&] {
+        return cached_source_matches(key, source) && run_podman({ "image", "exists", cached_image })
+            && run_podman({ "tag", cached_image, container_name });
+    };
+
+    if (other_build.valid()) {
+        auto result = other_build.get();
+        if (result.has_value())
+            return result;
+        // Only if it could not be cached, then it is built again.
+        if (use_cached_image())
+            return {};
+    }
+
+    auto finish = [&](BuildResult result, bool remember_failure) {
+        if (!building)
+            return result;
+        std::lock_guard lock(cache_lock);
+        if (result.has_value() && remember_failure) {
+            auto now = std::chrono::steady_clock::now();
+            if (failed_builds.size() >= max_failed_builds) {
+                std::erase_if(failed_builds, [&](auto const& entry) { return now - entry.second.failed_at >= failed_build_lifetime; });
+                if (failed_builds.size() >= max_failed_builds)
+                    failed_builds.clear();
+            }
+            failed_builds[key] = { source, *result, now };
+        }
+        builds_in_flight.erase(key);
+        promise.set_value(result);
+        return result;
+    };
+
+    if (use_cached_image())
+        return finish({}, false);
+
+    if (!build_queue.acquire(extension))
+        return finish("Too many bots are being built right now, please try again later", false);
+
+    BuildResult result;
+    try {
+        result = run_build_script(extension, absolute_path, container_name);
+    } catch (...) {
+        build_queue.release(extension);
+        finish("Failed to run build script", false);
+        throw;
+    }
+    build_queue.release(extension);
+
+    if (!result.has_value()) {
+        // The source is written after the image is tagged, so a stored source always has an image.
+        std::error_code error;
+        std::filesystem::create_directories(build_cache_directory, error);
+        if (run_podman({ "tag", container_name, cached_image })) {
+            std::ofstream stored { build_cache_directory + key, std::ios::binary | std::ios::trunc };
+            stored << source;
+        }
+    }
+
+    return finish(result, true);
+}
+
 
 }
@@ -10,6 +10,6 @@ void AdminGuard::after_handle(crow::request&, crow::response&, AdminGuard::conte
 }
 void BaseMiddleware::after_handle(crow::request&, crow::response&, BaseMiddleware::context& ctx)
 {
-    ConnectionPool::return_connection(std::move(ctx.database_connection));
+    ctx.database_connection.release();
 }
 }
@@ -14,7 +14,8 @@ constexpr char const* const COOKIE_AUTH_CLEAR_DATA = "; Expires=Thu, 01 Jan 1970
 
 struct BaseMiddleware {
     struct context {
-        std::unique_ptr<pqxx::connection> database_connection;
+        // Taken from the pool on first use, most requests for static data never need one.
+        ConnectionPool::LazyConnection database_connection;
         LoggedInUser user{};
     };
 
@@ -24,7 +25,6 @@ struct BaseMiddleware {
         // Set default so we get slightly less errors....
         resp.set_header("Content-Type", "text/plain");
 
-        ctx.database_connection = ConnectionPool::get_connection();
         crow::CookieParser::context& cookies = all_context.template get<crow::CookieParser>();
 
         auto log_in = cookies.get_cookie(COOKIE_AUTH_NAME);
@@ -34,8 +34,16 @@ struct BaseMiddleware {
         std::string decrypted_log_in = crow::utility::base64decode(log_in);
 
         if (std::count(decrypted_log_in.begin(), decrypted_log_in.end(), ':') == 1) {
-
-            auto user_or_none = LoggedInUser::get_user_from_auth_header(*ctx.database_connection, decrypted_log_in);
+            auto user_or_none = LoggedInUser::cached_user_from_auth_header(decrypted_log_in);
+            try {
+                if (!user_or_none.has_value())
+                    user_or_none = LoggedInUser::get_user_from_auth_header(*ctx.database_connection, decrypted_log_in);
+            } catch (ConnectionPool::PoolExhausted const&) {
+                // Better to fail now than to leave the page hanging, it is still logged in.
+                resp.code = 503;
+                resp.end("Server is busy, try again later");
+                return;
+            }
 
             if (user_or_none.has_value()) {
                 ctx.user = std::move(*user_or_none);
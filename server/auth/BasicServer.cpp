@@ -3,6 +3,13 @@
 
 namespace BBServer {
 
+static ConnectionPool::PreparedStatement const insert_user {
+    "insert_user", "INSERT INTO users (name, token, display_name) VALUES ($1, $2, $1)"
+};
+static ConnectionPool::PreparedStatement const rename_user {
+    "rename_user", "UPDATE users SET display_name = $1 WHERE user_id = $2"
+};
+
 void add_authentication(ServerType& app)
 {
     // FIXME: Do not hardcode the max-age
@@ -59,8 +66,7 @@ void add_authentication(ServerType& app)
 
             pqxx::work transaction{*base_context.database_connection};
 
-            base_context.database_connection->prepare("INSERT INTO users (name, token, display_name) VALUES ($1, $2, $1)");
-            auto result = transaction.exec_prepared("", username, token);
+            auto result = transaction.exec_prepared(insert_user.name, username, token);
             if (result.affected_rows() == 0)
                 return fail_response_with_message(resp, 500, "Failed to register, try again maybe?");
 
@@ -87,6 +93,8 @@ void add_authentication(ServerType& app)
     .methods(crow::HTTPMethod::POST)
     .middlewares<ServerType, BBServer::AuthGuard>()
     ([&](crow::request const& req) {
+        auto& base_context = app.get_context<BBServer::BaseMiddleware>(req);
+        LoggedInUser::forget_cached_sessions(base_context.user.id);
         auto& cookies = app.get_context<crow::CookieParser>(req);
         cookies.set_cookie(COOKIE_AUTH_NAME, COOKIE_AUTH_CLEAR_DATA);
         return "Logged out";
@@ -97,13 +105,36 @@ void add_authentication(ServerType& app)
     .middlewares<ServerType, BBServer::AuthGuard>()
     ([&](crow::request const& req) {
         auto& base_context = app.get_context<BBServer::BaseMiddleware>(req);
-        base_context.database_connection->prepare("UPDATE users SET display_name = $1 WHERE user_id = $2");
         pqxx::work trans{*base_context.database_connection};
-        trans.exec_prepared("", req.body, base_context.user.id);
+        trans.exec_prepared(rename_user.name, req.body, base_context.user.id);
         trans.commit();
+        // The cached sessions still have the old name.
+        LoggedInUser::forget_cached_sessions(base_context.user.id);
         return "renamed to " + req.body;
     });
 
+    CROW_ROUTE(app, "/api/admin/database-pool")
+    .middlewares<ServerType, BBServer::AuthGuard>()
+    ([&](crow::request const& req, crow::response& resp) {
+        auto& base_context = app.get_context<BBServer::BaseMiddleware>(req);
+        if (!base_context.user.is_admin())
+            return fail_response_with_message(resp, 403, "Admins only");
+
+        auto metrics = ConnectionPool::metrics();
+        crow::json::wvalue result {
+            { "size", metrics.size },
+            { "inUse", metrics.in_use },
+            { "waiting", metrics.waiting },
+            { "acquired", metrics.acquired },
+            { "hadToWait", metrics.had_to_wait },
+            { "timedOut", metrics.timed_out },
+            { "totalWaitMicroseconds", metrics.total_wait_microseconds },
+            { "maxWaitMicroseconds", metrics.max_wait_microseconds },
+        };
+        resp.set_header("Content-Type", "application/json");
+        resp.end(result.dump());
+    });
+
 }
 
 void fail_response_with_message(crow::response& resp, int code, std::string const& message)
@@ -1,7 +1,10 @@
 #include "ConnectionPool.h"
+#include <algorithm>
 #include <condition_variable>
 #include <iostream>
 #include <mutex>
+#include <optional>
+#include <string_view>
 #include "../../util/Assertions.h"
 
 namespace BBServer::ConnectionPool {
@@ -10,6 +13,8 @@ static std::mutex pool_lock;
 static std::condition_variable non_empty_condition;
 static std::vector<std::unique_ptr<pqxx::connection>> pool;
 static uint32_t pool_size = -1;
+static std::string pool_connection_string;
+static Metrics pool_metrics;
 
 #ifdef CPOOL_VERBOSE
 #define CPOOL_LOG(str) std::cerr << str
@@ -17,18 +22,55 @@ static uint32_t pool_size = -1;
 #define CPOOL_LOG(str)
 #endif
 
+struct Statement {
+    char const* name;
+    char const* sql;
+};
+
+// A function static, the statements are registered during static initialization in any order.
+static std::vector<Statement>& registered_statements()
+{
+    static std::vector<Statement> statements;
+    return statements;
+}
+
+PreparedStatement::PreparedStatement(char const* name_, char const* sql)
+    : name(name_)
+{
+    ASSERT(pool_size == -1u);
+    auto& statements = registered_statements();
+    ASSERT(std::none_of(statements.begin(), statements.end(), [&](Statement const& statement) {
+        return std::string_view { statement.name } == name_;
+    }));
+    statements.push_back({ name_, sql });
+}
+
 void initialize_pool(uint32_t size, std::string const& connection_string)
 {
     std::lock_guard l(pool_lock);
     ASSERT(pool.empty() && (pool_size == -1u));
     CPOOL_LOG("Initialized with " << size << " size ");
     pool_size = size;
+    pool_connection_string = connection_string;
     pool.reserve(size);
-    for (uint32_t i = 0; i < size; ++i)
-        pool.push_back(std::make_unique<pqxx::connection>(connection_string));
+    for (uint32_t i = 0; i < size; ++i) {
+        auto connection = std::make_unique<pqxx::connection>(connection_string);
+        // Parsed and planned once here instead of on every request.
+        // A statement which does not prepare (e.g. its table is missing) only breaks
+        // the requests using it, so the server still starts.
+        for (auto& statement : registered_statements()) {
+            try {
+                connection->prepare(statement.name, statement.sql);
+            } catch (std::exception const& error) {
+                if (i == 0)
+                    std::cerr << "Could not prepare statement " << statement.name << ": " << error.what() << '\n';
+            }
+        }
+        pool.push_back(std::move(connection));
+    }
 }
 
-std::unique_ptr<pqxx::connection> get_connection()
+static std::unique_ptr<pqxx::connection> take_connection(std::optional<std::chrono::milliseconds> max_wait)
 {
     std::unique_lock l(pool_lock);
     ASSERT(pool_size > 0);
@@ -36,18 +78,54 @@ std::unique_ptr<pqxx::connection> get_connection()
 
     CPOOL_LOG("Getting connection " << pool.size() << " left ");
 
-    while (pool.empty()) {
+    if (pool.empty()) {
         std::cerr << "Actually have to wait for a db connection!\n";
-        non_empty_condition.wait(l);
+        auto wait_start = std::chrono::steady_clock::now();
+        ++pool_metrics.waiting;
+        bool available = true;
+        if (max_wait.has_value())
+            available = non_empty_condition.wait_for(l, *max_wait, [] { return !pool.empty(); });
+        else
+            non_empty_condition.wait(l, [] { return !pool.empty(); });
+        --pool_metrics.waiting;
+
+        auto waited = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - wait_start).count());
+        pool_metrics.total_wait_microseconds += waited;
+        pool_metrics.max_wait_microseconds = std::max(pool_metrics.max_wait_microseconds, waited);
+        if (!available) {
+            ++pool_metrics.timed_out;
+            return nullptr;
+        }
+        ++pool_metrics.had_to_wait;
     }
 
     auto connection = std::move(pool.back());
     pool.pop_back();
+    ++pool_metrics.acquired;
 
     CPOOL_LOG("Got connection " << connection.get() << " left ");
     return connection;
 }
 
+std::unique_ptr<pqxx::connection> get_connection()
+{
+    return take_connection(std::nullopt);
+}
+
+std::unique_ptr<pqxx::connection> get_connection(std::chrono::milliseconds max_wait)
+{
+    return take_connection(max_wait);
+}
+
+Metrics metrics()
+{
+    std::lock_guard l(pool_lock);
+    Metrics current = pool_metrics;
+    current.size = pool_size;
+    current.in_use = pool_size - static_cast<uint32_t>(pool.size());
+    return current;
+}
+
 void return_connection(std::unique_ptr<pqxx::connection>&& connection)
 {
     {
@@ -63,4 +141,15 @@ void return_connection(std::unique_ptr<pqxx::connection>&& connection)
     non_empty_condition.notify_one();
 }
 
+std::unique_ptr<pqxx::connection> open_unpooled_connection()
+{
+    std::string connection_string;
+    {
+        std::lock_guard l(pool_lock);
+        ASSERT(pool_size > 0);
+        connection_string = pool_connection_string;
+    }
+    return std::make_unique<pqxx::connection>(connection_string);
+}
+
 }
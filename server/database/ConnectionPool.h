@@ -1,17 +1,110 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <pqxx/connection>
+#include <stdexcept>
 #include "../../util/Deferred.h"
 
 namespace BBServer::ConnectionPool {
 
+// A statement prepared once on every connection of the pool, run it with
+// transaction.exec_prepared(statement.name, ...). These must be static objects
+// so they are all registered before initialize_pool opens the connections.
+// Statements which fail to prepare are logged and then fail when they are run.
+struct PreparedStatement {
+    PreparedStatement(char const* name, char const* sql);
+
+    char const* name;
+};
+
 void initialize_pool(uint32_t size, std::string const& connection_string);
 
 std::unique_ptr<pqxx::connection> get_connection();
+// Null if no connection came free within max_wait.
+std::unique_ptr<pqxx::connection> get_connection(std::chrono::milliseconds max_wait);
 
 void return_connection(std::unique_ptr<pqxx::connection>&&);
 
+// A new connection to the same database outside of the pool, for connections which
+// are held forever like one listening for notifications. Nothing is prepared on it.
+std::unique_ptr<pqxx::connection> open_unpooled_connection();
+
+struct Metrics {
+    uint32_t size { 0 };
+    uint32_t in_use { 0 };
+    uint32_t waiting { 0 };
+
+    uint64_t acquired { 0 };
+    // Of the acquired connections, how many were not available right away.
+    uint64_t had_to_wait { 0 };
+    uint64_t timed_out { 0 };
+    uint64_t total_wait_microseconds { 0 };
+    uint64_t max_wait_microseconds { 0 };
+};
+
+Metrics metrics();
+
+struct PoolExhausted : std::runtime_error {
+    PoolExhausted()
+        : std::runtime_error("No database connection available")
+    {
+    }
+};
+
+// Only takes a connection from the pool when first used and returns it when
+// released or destroyed, so requests which never query do not hold one.
+// Throws PoolExhausted if no connection came free within max_wait.
+class LazyConnection {
+public:
+    explicit LazyConnection(std::chrono::milliseconds max_wait = std::chrono::milliseconds(1000))
+        : m_max_wait(max_wait)
+    {
+    }
+
+    ~LazyConnection() { release(); }
+
+    LazyConnection(LazyConnection const&) = delete;
+    LazyConnection& operator=(LazyConnection const&) = delete;
+
+    // Crow resets the request contexts by assigning a new one.
+    LazyConnection(LazyConnection&& other) noexcept = default;
+    LazyConnection& operator=(LazyConnection&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            m_max_wait = other.m_max_wait;
+            m_connection = std::move(other.m_connection);
+        }
+        return *this;
+    }
+
+    pqxx::connection& operator*() { return acquire(); }
+    pqxx::connection* operator->() { return &acquire(); }
+
+    [[nodiscard]] bool acquired() const { return m_connection != nullptr; }
+
+    void release()
+    {
+        if (m_connection)
+            return_connection(std::move(m_connection));
+    }
+
+private:
+    pqxx::connection& acquire()
+    {
+        if (!m_connection) {
+            m_connection = get_connection(m_max_wait);
+            if (!m_connection)
+                throw PoolExhausted {};
+        }
+        return *m_connection;
+    }
+
+    std::chrono::milliseconds m_max_wait;
+    std::unique_ptr<pqxx::connection> m_connection;
+};
+
 template<typename Function>
 auto run_on_temporary_connection(Function function)
 {
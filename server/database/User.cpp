@@ -1,10 +1,86 @@
 #include <pqxx/transaction>
 #include <crow/utility.h>
+#include <array>
+#include <chrono>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <unordered_map>
 #include "User.h"
+#include "ConnectionPool.h"
 
 namespace BBServer {
 
+static ConnectionPool::PreparedStatement const user_by_token {
+    "user_by_token", "SELECT user_id, access_level, display_name  FROM users WHERE name = $1 AND token = $2"
+};
+static ConnectionPool::PreparedStatement const count_users_with_name {
+    "count_users_with_name", "SELECT COUNT(*) FROM users WHERE name = $1"
+};
+
+// Sharded so concurrent requests rarely wait on the same lock.
+class SessionCache {
+public:
+    std::optional<LoggedInUser> find(std::string const& key)
+    {
+        auto& shard = shard_for(key);
+        std::lock_guard lock(shard.lock);
+        auto it = shard.sessions.find(key);
+        if (it == shard.sessions.end())
+            return std::nullopt;
+        if (it->second.expires < std::chrono::steady_clock::now()) {
+            shard.sessions.erase(it);
+            return std::nullopt;
+        }
+        return it->second.user;
+    }
+
+    void store(std::string const& key, LoggedInUser const& user)
+    {
+        auto& shard = shard_for(key);
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard lock(shard.lock);
+        if (shard.sessions.size() >= max_sessions_per_shard) {
+            std::erase_if(shard.sessions, [&](auto const& session) { return session.second.expires < now; });
+            if (shard.sessions.size() >= max_sessions_per_shard)
+                shard.sessions.clear();
+        }
+        shard.sessions[key] = { user, now + time_to_live };
+    }
+
+    void forget_user(uint32_t user_id)
+    {
+        for (auto& shard : m_shards) {
+            std::lock_guard lock(shard.lock);
+            std::erase_if(shard.sessions, [&](auto const& session) { return session.second.user.id == user_id; });
+        }
+    }
+
+private:
+    // Also bounds how long a token changed directly in the database keeps working.
+    static constexpr std::chrono::seconds time_to_live { 60 };
+    static constexpr size_t max_sessions_per_shard = 1024;
+
+    struct Session {
+        LoggedInUser user;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    struct Shard {
+        std::mutex lock;
+        std::unordered_map<std::string, Session> sessions;
+    };
+
+    Shard& shard_for(std::string const& key)
+    {
+        return m_shards[std::hash<std::string> {}(key) % m_shards.size()];
+    }
+
+    std::array<Shard, 16> m_shards;
+};
+
+static SessionCache session_cache;
+
 std::optional<LoggedInUser> LoggedInUser::get_user(pqxx::connection& connection, std::string const& username, std::string const& token)
 {
     if (!connection.is_open() || username.empty() || token.empty())
@@ -12,8 +88,7 @@ std::optional<LoggedInUser> LoggedInUser::get_user(pqxx::connection& connection,
 
     pqxx::read_transaction transaction{connection};
 
-    connection.prepare("SELECT user_id, access_level, display_name  FROM users WHERE name = $1 AND token = $2");
-    pqxx::result user_result = transaction.exec_prepared("", username, token);
+    pqxx::result user_result = transaction.exec_prepared(user_by_token.name, username, token);
 
     if (user_result.empty()) {
         std::cerr << "No user (with token)";
@@ -41,15 +116,27 @@ std::optional<LoggedInUser> LoggedInUser::get_user_from_auth_header(pqxx::connec
     std::string username = mycreds.substr(0, found);
     std::string password = mycreds.substr(found+1);
 
-    return LoggedInUser::get_user(connection, username, password);
+    auto user = LoggedInUser::get_user(connection, username, password);
+    if (user.has_value())
+        session_cache.store(mycreds, *user);
+    return user;
+}
+
+std::optional<LoggedInUser> LoggedInUser::cached_user_from_auth_header(std::string const& mycreds)
+{
+    return session_cache.find(mycreds);
+}
+
+void LoggedInUser::forget_cached_sessions(uint32_t user_id)
+{
+    session_cache.forget_user(user_id);
 }
 
 bool user_exists(pqxx::connection& connection, std::string const& name)
 {
     pqxx::read_transaction transaction{connection};
 
-    connection.prepare("SELECT COUNT(*) FROM users WHERE name = $1");
-    pqxx::row user_result = transaction.exec_prepared1("", name);
+    pqxx::row user_result = transaction.exec_prepared1(count_users_with_name.name, name);
     return user_result[0].as<int>() > 0;
 }
 
@@ -13,7 +13,11 @@ struct LoggedInUser {
 
     bool is_admin() const { return access_level > 0; }
 
+    // Successful lookups are remembered for a while, check this before taking a connection.
+    static std::optional<LoggedInUser> cached_user_from_auth_header(std::string const& header_value);
     static std::optional<LoggedInUser> get_user_from_auth_header(pqxx::connection&, std::string const& header_value);
+    // Must be called when a user logs out or their token or details change.
+    static void forget_cached_sessions(uint32_t user_id);
 
     static std::optional<LoggedInUser> get_user(pqxx::connection& connection, std::string const& username, std::string const& token);
 };
@@ -2,11 +2,22 @@
 #include "../../util/Assertions.h"
 #include "../ContainerBuilder.h"
 #include "../database/ConnectionPool.h"
+#include "Progress.h"
 #include <iostream>
+#include <optional>
 #include <pqxx/transaction>
 
 namespace BBServer {
 
+static ConnectionPool::PreparedStatement const elevated_bot_status {
+    "elevated_bot_status", "SELECT status, command FROM elevated_bots WHERE bot_id = $1"
+};
+static ConnectionPool::PreparedStatement const elevated_update_bot_status {
+    "elevated_update_bot_status", "UPDATE elevated_bots SET status = $1, running_cases = $2 WHERE bot_id = $3"
+};
+static ConnectionPool::PreparedStatement const elevated_start_bot_cases {
+    "elevated_start_bot_cases", "UPDATE elevated_bots SET status = $1, running_cases = TRUE, command = $2 WHERE bot_id = $3"
+};
 
 bool create_elevated_bot_in_container(uint32_t id)
 {
@@ -14,7 +25,7 @@ bool create_elevated_bot_in_container(uint32_t id)
     auto start_status = ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) -> std::string {
         pqxx::read_transaction transaction{connection};
 
-        auto result = transaction.exec("SELECT status, command FROM elevated_bots WHERE bot_id = " + std::to_string(id));
+        auto result = transaction.exec_prepared(elevated_bot_status.name, id);
         if (result.size() > 1) {
             ASSERT_NOT_REACHED();
         }
@@ -42,11 +53,13 @@ bool create_elevated_bot_in_container(uint32_t id)
         ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
             pqxx::work transaction{connection};
 
-            auto result = transaction.exec0(
-                "UPDATE elevated_bots"
-                " SET status = '" + transaction.esc(new_status) + "', running_cases = " + (failed ? "FALSE" : "NULL") +
-                " WHERE bot_id = " + std::to_string(id));
+            // Still building is NULL, so the bot is not picked up until it is done.
+            std::optional<bool> running_cases;
+            if (failed)
+                running_cases = false;
+            auto result = transaction.exec_prepared0(elevated_update_bot_status.name, new_status, running_cases, id);
             ASSERT(result.affected_rows() == 1);
+            notify_bot_changed(transaction, id);
             transaction.commit();
         });
     };
@@ -72,10 +85,9 @@ bool create_elevated_bot_in_container(uint32_t id)
     ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
         pqxx::work transaction{connection};
 
-        connection.prepare("UPDATE elevated_bots SET status = $1, running_cases = TRUE, command = $2 WHERE bot_id = $3");
-
-        auto result = transaction.exec_prepared0("", "Running cases", run_command, id);
+        auto result = transaction.exec_prepared0(elevated_start_bot_cases.name, "Running cases", run_command, id);
         ASSERT(result.affected_rows() == 1);
+        notify_bot_changed(transaction, id);
         transaction.commit();
     });
 
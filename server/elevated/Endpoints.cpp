@@ -1,15 +1,178 @@
 #include "Endpoints.h"
 #include "BotCreator.h"
+#include "LatestRuns.h"
+#include "Progress.h"
 #include <crow/multipart.h>
+#include <crow/websocket.h>
 #include <filesystem>
+#include <mutex>
 #include <pqxx/transaction>
 #include <pqxx/result>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace BBServer {
 
 static std::unordered_set<long> bots_with_image;
 
+// The websockets of /api/elevated/progress and the bots each of them watches.
+class ProgressWatchers {
+public:
+    static constexpr size_t max_bots_per_connection = 64;
+
+    bool watch(crow::websocket::connection* connection, uint32_t bot_id)
+    {
+        std::lock_guard lock(m_lock);
+        auto& bots = m_bots_of_connection[connection];
+        if (bots.size() >= max_bots_per_connection && !bots.contains(bot_id))
+            return false;
+        bots.insert(bot_id);
+        m_connections_of_bot[bot_id].insert(connection);
+        return true;
+    }
+
+    void unwatch(crow::websocket::connection* connection, uint32_t bot_id)
+    {
+        std::lock_guard lock(m_lock);
+        if (auto bots = m_bots_of_connection.find(connection); bots != m_bots_of_connection.end())
+            bots->second.erase(bot_id);
+        remove_from_bot(connection, bot_id);
+    }
+
+    void remove(crow::websocket::connection* connection)
+    {
+        std::lock_guard lock(m_lock);
+        auto bots = m_bots_of_connection.find(connection);
+        if (bots == m_bots_of_connection.end())
+            return;
+        for (auto bot_id : bots->second)
+            remove_from_bot(connection, bot_id);
+        m_bots_of_connection.erase(bots);
+    }
+
+    bool is_watched(uint32_t bot_id)
+    {
+        std::lock_guard lock(m_lock);
+        return m_connections_of_bot.contains(bot_id);
+    }
+
+    void send(uint32_t bot_id, std::string const& message)
+    {
+        // Under the lock, a connection is destroyed right after it was removed.
+        std::lock_guard lock(m_lock);
+        auto connections = m_connections_of_bot.find(bot_id);
+        if (connections == m_connections_of_bot.end())
+            return;
+        for (auto* connection : connections->second)
+            connection->send_text(message);
+    }
+
+private:
+    void remove_from_bot(crow::websocket::connection* connection, uint32_t bot_id)
+    {
+        auto connections = m_connections_of_bot.find(bot_id);
+        if (connections == m_connections_of_bot.end())
+            return;
+        connections->second.erase(connection);
+        if (connections->second.empty())
+            m_connections_of_bot.erase(connections);
+    }
+
+    std::mutex m_lock;
+    std::unordered_map<crow::websocket::connection*, std::unordered_set<uint32_t>> m_bots_of_connection;
+    std::unordered_map<uint32_t, std::unordered_set<crow::websocket::connection*>> m_connections_of_bot;
+};
+
+static ProgressWatchers progress_watchers;
+
+static ConnectionPool::PreparedStatement const elevated_bots_of_user {
+    "elevated_bots_of_user",
+    "SELECT bot_id, bot_name, running_cases, COALESCE(status, '?') "
+    "FROM elevated_bots "
+    "WHERE user_id = $1 "
+    "ORDER BY created DESC LIMIT 100"
+};
+static ConnectionPool::PreparedStatement const elevated_latest_runs_of_bot {
+    "elevated_latest_runs_of_bot",
+    "SELECT lr.case_id, ec.case_name, ec.hidden, lr.result\n"
+    "FROM elevated_latest_run lr\n"
+    "    JOIN elevated_cases ec on lr.case_id = ec.case_id\n"
+    "WHERE lr.bot_id = $1"
+};
+static ConnectionPool::PreparedStatement const elevated_latest_run_of_bot_case {
+    "elevated_latest_run_of_bot_case",
+    "SELECT lr.case_id, ec.case_name, ec.hidden, lr.result\n"
+    "FROM elevated_latest_run lr\n"
+    "    JOIN elevated_cases ec on lr.case_id = ec.case_id\n"
+    "WHERE lr.bot_id = $1 AND lr.case_id = $2"
+};
+static ConnectionPool::PreparedStatement const elevated_disable_bot_of_user {
+    "elevated_disable_bot_of_user", "UPDATE elevated_bots SET running_cases = FALSE, status = 'Disabled by user' WHERE bot_id = $1 AND user_id = $2"
+};
+static ConnectionPool::PreparedStatement const elevated_bot_name_taken {
+    "elevated_bot_name_taken", "SELECT 1 FROM elevated_bots WHERE user_id = $1 and bot_name = $2"
+};
+static ConnectionPool::PreparedStatement const elevated_insert_bot {
+    "elevated_insert_bot", "INSERT INTO elevated_bots(bot_name, user_id, command)  VALUES ($1, $2, $3) RETURNING bot_id"
+};
+static ConnectionPool::PreparedStatement const elevated_enabled_cases {
+    "elevated_enabled_cases", "SELECT case_id, case_name, hidden, description FROM elevated_cases WHERE enabled"
+};
+static ConnectionPool::PreparedStatement const elevated_leaderboard_runs {
+    "elevated_leaderboard_runs",
+    "SELECT er.bot_id, eb.bot_name, er.case_id, er.success AND er.done as successful, er.status, er.output, u.display_name as author, er.cached_from IS NOT NULL as cached\n"
+    "FROM elevated_latest_run lr\n"
+    "    JOIN elevated_run er on lr.run_id = er.run_id\n"
+    "    JOIN elevated_bots eb on er.bot_id = eb.bot_id\n"
+    "    JOIN users u on eb.user_id = u.user_id\n"
+    "    JOIN elevated_cases ec on er.case_id = ec.case_id\n"
+    "WHERE eb.running_cases AND ec.enabled\n"
+    "ORDER BY er.bot_id"
+};
+
+// A row of elevated_latest_runs_of_bot as shown by /api/elevated/bot-cases.
+static std::string case_json(pqxx::row const& row)
+{
+    static std::string const running_json = latest_run_json(false, false, "", "", false);
+
+    auto case_id = row[0].as<long>();
+    auto hidden = row[2].as<bool>();
+    std::string_view run_json = row[3].is_null() ? std::string_view { running_json } : std::string_view { row[3].c_str() };
+
+    // The stored results are already json, only the id and name are added in front.
+    std::string json = "{\"id\":" + std::to_string(case_id);
+    json += ",\"name\":" + crow::json::wvalue(hidden ? ("Case #" + std::to_string(case_id)) : row[1].c_str()).dump();
+    json += ',';
+    json += run_json.substr(1);
+    return json;
+}
+
+static void push_progress(ProgressEvent const& event)
+{
+    if (!progress_watchers.is_watched(event.bot_id))
+        return;
+
+    std::string message = "{\"bot\":" + std::to_string(event.bot_id);
+    if (event.type == ProgressEvent::Type::Bot) {
+        message += ",\"type\":\"bot\"}";
+    } else {
+        auto run = ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) -> std::optional<std::string> {
+            pqxx::read_transaction transaction { connection };
+            auto result = transaction.exec_prepared(elevated_latest_run_of_bot_case.name, event.bot_id, event.case_id);
+            if (result.empty())
+                return std::nullopt;
+            return case_json(result[0]);
+        });
+        if (!run)
+            return;
+        message += ",\"type\":\"case\",\"case\":" + *run + '}';
+    }
+
+    progress_watchers.send(event.bot_id, message);
+}
+
 void add_elevated_endpoints(ServerType& app, boost::asio::io_service& io_service)
 {
 
@@ -19,10 +182,7 @@ void add_elevated_endpoints(ServerType& app, boost::asio::io_service& io_service
         auto& base_context = app.get_context<BBServer::BaseMiddleware>(req);
         pqxx::read_transaction transaction {*base_context.database_connection};
 
-        auto results = transaction.exec("SELECT bot_id, bot_name, running_cases, COALESCE(status, '?') "
-                                                  "FROM elevated_bots "
-                                                  "WHERE user_id = " + std::to_string(base_context.user.id) + " "
-                                                  "ORDER BY created DESC LIMIT 100");
+        auto results = transaction.exec_prepared(elevated_bots_of_user.name, base_context.user.id);
 
         std::vector<crow::json::wvalue> bots;
         bots.reserve(results.size());
@@ -46,36 +206,50 @@ void add_elevated_endpoints(ServerType& app, boost::asio::io_service& io_service
         auto& base_context = app.get_context<BBServer::BaseMiddleware>(req);
         pqxx::read_transaction transaction {*base_context.database_connection};
 
-        auto result = transaction.exec(
-            "SELECT er.case_id, ec.case_name, ec.hidden, er.success AND er.done as successful, NOT er.done as running, er.status, er.output\n"
-            "FROM elevated_run er\n"
-            "    JOIN elevated_cases ec on er.case_id = ec.case_id\n"
-            "WHERE er.bot_id = " + std::to_string(bot_id) + " AND started = (SELECT MAX(started) FROM elevated_run er2 WHERE er.bot_id = er2.bot_id AND er.case_id = er2.case_id)"
-            );
+        auto result = transaction.exec_prepared(elevated_latest_runs_of_bot.name, bot_id);
 
-        std::vector<crow::json::wvalue> cases;
+        std::string body = "[";
         for (auto row : result) {
-            auto hidden = row[2].as<bool>();
-            auto success = row[3].as<bool>();
-
-            auto& res = cases.emplace_back(crow::json::wvalue{
-                {"id", row[0].as<long>()},
-                {"name", hidden ? ("Case #" + std::to_string(row[0].as<long>())) : row[1].c_str()},
-                {"success", success},
-                {"running", row[4].is_null() ? false : row[4].as<bool>()},
-                {"status", row[5].c_str()}
-            });
+            if (body.size() > 1)
+                body += ',';
+            body += case_json(row);
+        }
+        body += ']';
 
-            if (success) {
-                res["result"] = crow::json::load(row[6].c_str());
-            } else {
-                res["result"] = row[6].c_str();
-            }
+        crow::response response { std::move(body) };
+        response.set_header("Content-Type", "application/json");
+        return response;
+    });
+
+    // Instead of polling my-bots and bot-cases, send "watch <bot id>" (and
+    // "unwatch <bot id>") to get {"bot": id, "type": "case", "case": {...}} with
+    // a case as in bot-cases whenever its run changes, and {"bot": id, "type": "bot"}
+    // when the status of the bot changed.
+    CROW_WEBSOCKET_ROUTE(app, "/api/elevated/progress")
+    .onclose([](crow::websocket::connection& connection, std::string const&, auto...) {
+        // Newer versions of crow also pass the close code.
+        progress_watchers.remove(&connection);
+    })
+    .onmessage([](crow::websocket::connection& connection, std::string const& data, bool) {
+        std::istringstream message { data };
+        std::string command;
+        uint32_t bot_id;
+        if (!(message >> command >> bot_id) || (command != "watch" && command != "unwatch")) {
+            connection.send_text(R"({"type":"error","message":"Expected watch or unwatch and a bot id"})");
+            return;
         }
 
-        return crow::json::wvalue {cases};
+        if (command == "unwatch")
+            progress_watchers.unwatch(&connection, bot_id);
+        else if (!progress_watchers.watch(&connection, bot_id))
+            connection.send_text(R"({"type":"error","message":"Watching too many bots"})");
     });
 
+    // Waiting for notifications blocks a connection forever, so it is not run on the io service.
+    std::thread([] {
+        listen_for_progress(push_progress);
+    }).detach();
+
     CROW_ROUTE(app, "/api/elevated/bot-image/<int>")
     ([](crow::response& resp, int bot_id){
         auto image_file = std::string("bots-data/el-") + std::to_string(bot_id) + "/image.png";
@@ -94,9 +268,9 @@ void add_elevated_endpoints(ServerType& app, boost::asio::io_service& io_service
         auto& base_context = app.get_context<BBServer::BaseMiddleware>(req);
         pqxx::work transaction {*base_context.database_connection};
 
-        auto result = transaction.exec(
-            "UPDATE elevated_bots SET running_cases = FALSE, status = 'Disabled by user' WHERE bot_id = " + std::to_string(bot_id) + " AND user_id = " + std::to_string(base_context.user.id)
-        );
+        auto result = transaction.exec_prepared(elevated_disable_bot_of_user.name, bot_id, base_context.user.id);
+        if (result.affected_rows() == 1)
+            notify_bot_changed(transaction, bot_id);
 
         transaction.commit();
 
@@ -123,8 +297,7 @@ void add_elevated_endpoints(ServerType& app, boost::asio::io_service& io_service
         if (trimmed_name.empty())
             return BBServer::fail_response_with_message(resp, 400, "Invalid name for bot");
 
-        base_context.database_connection->prepare("SELECT 1 FROM elevated_bots WHERE user_id = $1 and bot_name = $2");
-        auto has_result = transaction.exec_prepared("", base_context.user.id, trimmed_name);
+        auto has_result = transaction.exec_prepared(elevated_bot_name_taken.name, base_context.user.id, trimmed_name);
         if (!has_result.empty())
             return BBServer::fail_response_with_message(resp, 400, "You already have a bot with that name");
 
@@ -185,8 +358,7 @@ void add_elevated_endpoints(ServerType& app, boost::asio::io_service& io_service
             return BBServer::fail_response_with_message(resp, 400, "Do not support multiple different file types (except .h + .cpp)");
 
 
-        base_context.database_connection->prepare("INSERT INTO elevated_bots(bot_name, user_id, command)  VALUES ($1, $2, $3) RETURNING bot_id");
-        auto result = transaction.exec_prepared1("", trimmed_name, base_context.user.id, main_file);
+        auto result = transaction.exec_prepared1(elevated_insert_bot.name, trimmed_name, base_context.user.id, main_file);
         auto bot_id = result[0].as<uint32_t>();
 
         transaction.commit();
@@ -245,7 +417,7 @@ void add_elevated_endpoints(ServerType& app, boost::asio::io_service& io_service
 
         {
             std::vector<crow::json::wvalue> cases;
-            auto active_cases = transaction.exec("SELECT case_id, case_name, hidden, description FROM elevated_cases WHERE enabled");
+            auto active_cases = transaction.exec_prepared(elevated_enabled_cases.name);
             for (auto row : active_cases) {
                 auto hidden = row[2].as<bool>();
 
@@ -263,15 +435,7 @@ void add_elevated_endpoints(ServerType& app, boost::asio::io_service& io_service
         {
             crow::json::wvalue bots{};
 
-            auto all_runs = transaction.exec(
-                "SELECT er.bot_id, eb.bot_name, er.case_id, er.success AND er.done as successful, er.status, er.output, u.display_name as author\n"
-                "FROM elevated_run er\n"
-                "    JOIN elevated_bots eb on er.bot_id = eb.bot_id\n"
-                "    JOIN users u on eb.user_id = u.user_id\n"
-                "    JOIN elevated_cases ec on er.case_id = ec.case_id\n"
-                "WHERE eb.running_cases AND ec.enabled\n"
-                "  AND started = (SELECT MAX(started) FROM elevated_run er2 WHERE er.bot_id = er2.bot_id AND er.case_id = er2.case_id)\n"
-                "ORDER BY er.bot_id");
+            auto all_runs = transaction.exec_prepared(elevated_leaderboard_runs.name);
 
             if (!all_runs.empty()) {
                 auto current_bot_id = all_runs[0][0].as<long>();
@@ -296,6 +460,7 @@ void add_elevated_endpoints(ServerType& app, boost::asio::io_service& io_service
                     crow::json::wvalue case_result{};
 
                     case_result["status"] = row[4].c_str();
+                    case_result["cached"] = row[7].as<bool>();
                     if (row[3].as<bool>()) {
                         // sucessful!
 //                        auto result_value = ;
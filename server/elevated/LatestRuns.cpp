@@ -0,0 +1,78 @@
+#include "LatestRuns.h"
+#include "../database/ConnectionPool.h"
+#include "Progress.h"
+#include <crow/json.h>
+#include <vector>
+
+namespace BBServer {
+
+static ConnectionPool::PreparedStatement const store_latest_run_result_statement {
+    "elevated_store_latest_run_result",
+    "WITH stored AS (UPDATE elevated_latest_run SET result = $2 WHERE run_id = $1 RETURNING bot_id, case_id)\n"
+    "SELECT pg_notify($3, 'run ' || bot_id || ' ' || case_id) FROM stored"
+};
+
+std::string latest_run_json(bool done, bool success, std::string const& status, std::string const& output, bool cached)
+{
+    crow::json::wvalue result {
+        { "success", done && success },
+        { "running", !done },
+        { "status", status },
+        { "cached", cached },
+    };
+
+    // Parsed here once instead of on every request.
+    if (done && success)
+        result["result"] = crow::json::load(output);
+    else
+        result["result"] = output;
+
+    return result.dump();
+}
+
+void store_latest_run_result(pqxx::work& transaction, uint64_t run_id, std::string const& result_json)
+{
+    transaction.exec_prepared(store_latest_run_result_statement.name, run_id, result_json, progress_channel);
+}
+
+void create_latest_runs_table(pqxx::connection& connection)
+{
+    pqxx::work transaction { connection };
+    // Removing a run also removes it as latest run, rebuild_latest_runs finds the one before it.
+    transaction.exec(
+        "CREATE TABLE IF NOT EXISTS elevated_latest_run (\n"
+        "    bot_id BIGINT NOT NULL,\n"
+        "    case_id BIGINT NOT NULL,\n"
+        "    run_id BIGINT NOT NULL REFERENCES elevated_run(run_id) ON DELETE CASCADE,\n"
+        "    result TEXT,\n"
+        "    PRIMARY KEY (bot_id, case_id)\n"
+        ")");
+    // store_latest_run_result looks runs up by their id.
+    transaction.exec("CREATE INDEX IF NOT EXISTS elevated_latest_run_run_id ON elevated_latest_run(run_id)");
+    transaction.commit();
+}
+
+size_t rebuild_latest_runs(pqxx::connection& connection)
+{
+    pqxx::work transaction { connection };
+    // Existing rows are left alone, standalone runners may be storing their results meanwhile.
+    // The result is built the same way as by latest_run_json, and not announced as nobody can be watching yet.
+    auto result = transaction.exec(
+        "INSERT INTO elevated_latest_run(bot_id, case_id, run_id, result)\n"
+        "SELECT DISTINCT ON (er.bot_id, er.case_id) er.bot_id, er.case_id, er.run_id,\n"
+        "    CASE WHEN er.done THEN json_build_object(\n"
+        "        'success', COALESCE(er.success, FALSE),\n"
+        "        'running', FALSE,\n"
+        "        'status', COALESCE(er.status, ''),\n"
+        "        'cached', er.cached_from IS NOT NULL,\n"
+        "        'result', CASE WHEN er.success THEN er.output::json ELSE to_json(COALESCE(er.output, '')) END)::text\n"
+        "    END\n"
+        "FROM elevated_run er\n"
+        "WHERE NOT EXISTS (SELECT 1 FROM elevated_latest_run lr WHERE lr.bot_id = er.bot_id AND lr.case_id = er.case_id)\n"
+        "ORDER BY er.bot_id, er.case_id, er.started DESC, er.run_id DESC\n"
+        "ON CONFLICT (bot_id, case_id) DO NOTHING");
+    transaction.commit();
+    return result.affected_rows();
+}
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <pqxx/connection>
+#include <pqxx/transaction>
+#include <string>
+
+namespace BBServer {
+
+// The latest run of every (bot, case) is kept in
+// elevated_latest_run(bot_id, case_id, run_id, result) with (bot_id, case_id)
+// as primary key, so the endpoints do not have to search elevated_run for it.
+// The result is the json object /api/elevated/bot-cases shows for the case,
+// without its id and name, and NULL while the run is not done yet.
+// Whatever adds a run to elevated_run must also make it the latest run and announce that.
+
+// Creates elevated_latest_run if it does not exist yet. The pool prepares statements
+// using it, so this has to run before ConnectionPool::initialize_pool.
+void create_latest_runs_table(pqxx::connection& connection);
+
+std::string latest_run_json(bool done, bool success, std::string const& status, std::string const& output, bool cached);
+
+// Sets the result of run_id if it is still the latest run of its bot and case, and announces it (see Progress.h).
+void store_latest_run_result(pqxx::work& transaction, uint64_t run_id, std::string const& result_json);
+
+// Adds the latest run of every (bot, case) which has none in the table: all of them
+// when it was just created, otherwise those whose latest run was removed.
+size_t rebuild_latest_runs(pqxx::connection& connection);
+
+}
@@ -0,0 +1,82 @@
+#include "Progress.h"
+#include "../database/ConnectionPool.h"
+#include <chrono>
+#include <iostream>
+#include <pqxx/notification>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace BBServer {
+
+static ConnectionPool::PreparedStatement const notify_bot_changed_statement {
+    "elevated_notify_bot_changed", "SELECT pg_notify($1, 'bot ' || $2::bigint)"
+};
+
+std::optional<ProgressEvent> parse_progress_event(std::string_view payload)
+{
+    std::istringstream stream { std::string(payload) };
+    std::string type;
+    ProgressEvent event {};
+    if (!(stream >> type >> event.bot_id))
+        return std::nullopt;
+
+    if (type == "bot") {
+        event.type = ProgressEvent::Type::Bot;
+    } else if (type == "run" && stream >> event.case_id) {
+        event.type = ProgressEvent::Type::Run;
+    } else {
+        return std::nullopt;
+    }
+    return event;
+}
+
+void notify_bot_changed(pqxx::work& transaction, uint32_t bot_id)
+{
+    transaction.exec_prepared(notify_bot_changed_statement.name, progress_channel, bot_id);
+}
+
+class ProgressReceiver final : public pqxx::notification_receiver {
+public:
+    ProgressReceiver(pqxx::connection& connection, std::function<void(ProgressEvent const&)> const& on_event)
+        : pqxx::notification_receiver(connection, progress_channel)
+        , m_on_event(on_event)
+    {
+    }
+
+    void operator()(std::string const& payload, int) override
+    {
+        auto event = parse_progress_event(payload);
+        if (!event) {
+            std::cerr << "Invalid progress event: " << payload << '\n';
+            return;
+        }
+        // Escaping would end the listener and lose events until it reconnects,
+        // while a failure here (e.g. no free connection) only concerns this event.
+        try {
+            m_on_event(*event);
+        } catch (std::exception const& e) {
+            std::cerr << "Failed to handle progress event " << payload << ": " << e.what() << '\n';
+        }
+    }
+
+private:
+    std::function<void(ProgressEvent const&)> const& m_on_event;
+};
+
+void listen_for_progress(std::function<void(ProgressEvent const&)> const& on_event)
+{
+    while (true) {
+        try {
+            auto connection = ConnectionPool::open_unpooled_connection();
+            ProgressReceiver receiver { *connection, on_event };
+            while (true)
+                connection->await_notification();
+        } catch (std::exception const& e) {
+            std::cerr << "Stopped listening for progress: " << e.what() << '\n';
+        }
+        std::this_thread::sleep_for(std::chrono::seconds(5));
+    }
+}
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <pqxx/transaction>
+#include <string_view>
+
+namespace BBServer {
+
+// Changes to bots and their runs are announced with a NOTIFY on this channel,
+// which is only delivered once their transaction commits. This way the server
+// also hears about runs done by standalone runners.
+constexpr char const* progress_channel = "elevated_progress";
+
+struct ProgressEvent {
+    enum class Type {
+        // The status of the bot changed, its cases might have changed as well.
+        Bot,
+        // The latest run of the bot on case_id changed.
+        Run,
+    };
+
+    Type type;
+    uint32_t bot_id;
+    uint32_t case_id { 0 };
+};
+
+// The payloads are "bot <bot_id>" and "run <bot_id> <case_id>".
+std::optional<ProgressEvent> parse_progress_event(std::string_view payload);
+
+void notify_bot_changed(pqxx::work& transaction, uint32_t bot_id);
+
+// Never returns, calls on_event for every event from any process. Uses a
+// connection of its own, reconnecting if it is lost. Events sent while not
+// connected are missed. Exceptions from on_event are logged and only skip that event.
+[[noreturn]] void listen_for_progress(std::function<void(ProgressEvent const&)> const& on_event);
+
+}
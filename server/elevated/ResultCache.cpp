@@ -0,0 +1,116 @@
+#include "ResultCache.h"
+#include "../../util/Assertions.h"
+#include "../../util/Process.h"
+#include "../database/ConnectionPool.h"
+#include "LatestRuns.h"
+#include <pqxx/transaction>
+
+namespace BBServer {
+
+static ConnectionPool::PreparedStatement const find_cached_run_statement {
+    "elevated_find_cached_run",
+    "SELECT erc.run_id FROM elevated_result_cache erc\n"
+    "    JOIN elevated_run er ON er.run_id = erc.run_id\n"
+    "WHERE erc.bot_key = $1 AND erc.scenario = $2 AND erc.seed = $3 AND erc.version = $4 AND er.done\n"
+    "LIMIT 1"
+};
+static ConnectionPool::PreparedStatement const copy_cached_run_statement {
+    "elevated_copy_cached_run",
+    "UPDATE elevated_run er\n"
+    "SET completed = now(), done = TRUE, success = source.success, status = source.status,\n"
+    "    output = source.output, event_log = source.event_log, cached_from = source.run_id\n"
+    "FROM elevated_run source\n"
+    "WHERE er.run_id = $1 AND source.run_id = $2 AND er.claimed_by = $3\n"
+    "RETURNING er.success, er.status, er.output"
+};
+static ConnectionPool::PreparedStatement const store_cached_run_statement {
+    "elevated_store_cached_run",
+    "INSERT INTO elevated_result_cache(bot_key, scenario, seed, version, run_id) VALUES ($1, $2, $3, $4, $5)\n"
+    "ON CONFLICT (bot_key, scenario, seed, version) DO NOTHING"
+};
+
+static std::optional<std::string> podman_image_id(std::string const& image)
+{
+    auto process = util::SubProcess::create({ "podman", "image", "inspect", "--format", "{{.Id}}", image });
+    if (!process)
+        return std::nullopt;
+
+    std::string id;
+    bool has_line = process->readLine(id);
+    auto result = process->stop();
+
+    if (!has_line || id.empty() || !result.exitCode.has_value() || result.exitCode.value() != 0)
+        return std::nullopt;
+    return id;
+}
+
+void create_result_cache_table(pqxx::connection& connection)
+{
+    pqxx::work transaction { connection };
+    transaction.exec(
+        "CREATE TABLE IF NOT EXISTS elevated_result_cache (\n"
+        "    bot_key TEXT NOT NULL,\n"
+        "    scenario TEXT NOT NULL,\n"
+        "    seed BIGINT NOT NULL,\n"
+        "    version INT NOT NULL,\n"
+        "    run_id BIGINT NOT NULL REFERENCES elevated_run(run_id) ON DELETE CASCADE,\n"
+        "    PRIMARY KEY (bot_key, scenario, seed, version)\n"
+        ")");
+    transaction.commit();
+}
+
+std::optional<ResultKey> result_key_for(std::string const& bot_command, std::string canonical_scenario, long seed)
+{
+    auto separator_index = bot_command.find(':');
+    if (separator_index == std::string::npos)
+        return std::nullopt;
+
+    auto type = bot_command.substr(0, separator_index);
+    auto details = bot_command.substr(separator_index + 1);
+
+    std::string bot;
+    if (type == "internal") {
+        bot = bot_command;
+    } else if (type == "podman") {
+        // Byte identical uploads build to the same image, even under a different bot.
+        auto image_id = podman_image_id(details);
+        if (!image_id)
+            return std::nullopt;
+        bot = "podman-image:" + *image_id;
+    } else {
+        return std::nullopt;
+    }
+
+    return ResultKey { std::move(bot), std::move(canonical_scenario), seed };
+}
+
+std::optional<uint64_t> find_cached_run(pqxx::connection& connection, ResultKey const& key)
+{
+    pqxx::read_transaction transaction { connection };
+    auto result = transaction.exec_prepared(find_cached_run_statement.name, key.bot, key.scenario, key.seed, key.version);
+    if (result.empty())
+        return std::nullopt;
+    return result[0][0].as<uint64_t>();
+}
+
+bool copy_cached_run(pqxx::connection& connection, uint64_t run_id, uint64_t source_run_id, std::string const& runner_name)
+{
+    pqxx::work transaction { connection };
+    auto result = transaction.exec_prepared(copy_cached_run_statement.name, run_id, source_run_id, runner_name);
+    if (result.empty())
+        return false;
+    ASSERT(result.affected_rows() == 1);
+    auto success = !result[0][0].is_null() && result[0][0].as<bool>();
+    store_latest_run_result(transaction, run_id, latest_run_json(true, success, result[0][1].c_str(), result[0][2].c_str(), true));
+    transaction.commit();
+    return true;
+}
+
+void store_cached_run(pqxx::connection& connection, ResultKey const& key, uint64_t run_id)
+{
+    pqxx::work transaction { connection };
+    transaction.exec_prepared(store_cached_run_statement.name, key.bot, key.scenario, key.seed, key.version, run_id);
+    transaction.commit();
+}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <pqxx/connection>
+#include <string>
+
+namespace BBServer {
+
+// Bump whenever the simulation or the stats computed from it change, results
+// cached by an older version are then no longer reused.
+//  2: Idle elevators count with 0 in the per elevator stats.
+constexpr int32_t result_cache_version = 2;
+
+// Identifies a run by what is actually run, instead of by bot and case id.
+// Results are stored in elevated_result_cache(bot_key, scenario, seed, version, run_id)
+// pointing at the run which has the result.
+struct ResultKey {
+    // The image id for container bots, the command itself for internal bots.
+    std::string bot;
+    // The canonical scenario string.
+    std::string scenario;
+    long seed;
+    int32_t version { result_cache_version };
+};
+
+// Creates elevated_result_cache if it does not exist yet, has to run before ConnectionPool::initialize_pool.
+void create_result_cache_table(pqxx::connection& connection);
+
+// Empty if the bot cannot be identified, such runs are never cached.
+std::optional<ResultKey> result_key_for(std::string const& bot_command, std::string canonical_scenario, long seed);
+
+// The finished run which has the result for this key.
+std::optional<uint64_t> find_cached_run(pqxx::connection& connection, ResultKey const& key);
+
+// Copies the result of source_run_id into run_id, marking it as cached.
+// Returns false without copying if run_id is no longer claimed by runner_name.
+bool copy_cached_run(pqxx::connection& connection, uint64_t run_id, uint64_t source_run_id, std::string const& runner_name);
+
+void store_cached_run(pqxx::connection& connection, ResultKey const& key, uint64_t run_id);
+
+}
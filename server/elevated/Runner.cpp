@@ -1,22 +1,62 @@
 #include "Runner.h"
 #include "../../util/Assertions.h"
+#include "../../util/CoreAllocator.h"
 #include "../database/ConnectionPool.h"
+#include "LatestRuns.h"
+#include "Progress.h"
+#include "ResultCache.h"
 #include "elevated/algorithm/CyclingAlgorithm.h"
 #include "elevated/algorithm/ProcessAlgorithm.h"
 #include "elevated/generation/FullGenerators.h"
+#include "elevated/generation/RequestTrace.h"
+#include "elevated/generation/factory/CompiledScenario.h"
 #include "elevated/generation/factory/StringSettings.h"
 #include <crow/json.h>
 #include <elevated/Simulation.h>
-#include <elevated/stats/ElevatorStatsListener.h>
-#include <elevated/stats/PassengerStats.h>
-#include <elevated/stats/PowerStatsListener.h>
-#include <elevated/stats/SpecialEventsListener.h>
+#include <elevated/stats/EventLogStats.h>
+#include <filesystem>
 #include <iostream>
+#include <mutex>
+#include <optional>
 #include <pqxx/connection>
 #include <pqxx/transaction>
 
 namespace BBServer {
 
+static std::string const& sandbox_cgroup_parent()
+{
+    // Prepared by whoever runs the server, without it the limits are rlimits (see util::SubProcess::Sandbox).
+    static std::string const parent = [] {
+        std::string path = "/sys/fs/cgroup/bottlebats";
+        if (std::filesystem::is_directory(path))
+            return path;
+        std::cerr << "No cgroup at " << path << ", sandboxed bots are limited through rlimits\n";
+        return std::string {};
+    }();
+    return parent;
+}
+
+static std::shared_ptr<util::Zygote> zygote_for(std::string const& command, std::vector<std::string> const& zygote_command, util::SubProcess::Sandbox const& sandbox)
+{
+    // One zygote per bot command, started on first use and restarted if it died.
+    static std::mutex zygotes_lock;
+    static std::unordered_map<std::string, std::shared_ptr<util::Zygote>> zygotes;
+
+    static constexpr size_t max_idle_zygotes = 16;
+
+    std::lock_guard lock(zygotes_lock);
+    if (zygotes.size() > max_idle_zygotes && !zygotes.contains(command))
+        std::erase_if(zygotes, [](auto const& entry) { return entry.second.use_count() == 1; });
+
+    auto& zygote = zygotes[command];
+    if (!zygote || !zygote->alive()) {
+        zygote = util::Zygote::start(zygote_command, sandbox);
+        if (!zygote)
+            std::cerr << "Failed to start zygote for " << command << '\n';
+    }
+    return zygote;
+}
+
 std::unique_ptr<Elevated::ElevatedAlgorithm> algorithm_from_command(std::string name)
 {
     auto separator_index = name.find(':');
@@ -35,30 +75,219 @@ std::unique_ptr<Elevated::ElevatedAlgorithm> algorithm_from_command(std::string
             return std::make_unique<Elevated::CyclingAlgorithm>();
         }
     } else if (type == "podman") {
-        return std::make_unique<Elevated::ProcessAlgorithm>(std::vector<std::string> {
+        std::vector<std::string> command {
             "podman", "run",
             "--network=none", "--cpus=1.0", "--memory=256m",
             "--cap-drop=all", "--rm", "--interactive",
-            std::string(details)
-        }, Elevated::ProcessAlgorithm::InfoLevel::Low);
+        };
+        // The container is started by conmon, so it does not inherit the pinning of this thread.
+        if (auto core = util::CoreAllocator::reserved_core_of_this_thread(); core.has_value())
+            command.push_back("--cpuset-cpus=" + std::to_string(*core));
+        command.push_back(std::string(details));
+        return std::make_unique<Elevated::ProcessAlgorithm>(std::move(command), Elevated::ProcessAlgorithm::InfoLevel::Low);
+    } else if (type == "sandbox" || type == "zygote") {
+        // sandbox:<exported image root> <absolute entrypoint> [arguments...]
+        // zygote: the same but the entrypoint is a zygote (see util/Zygote.h) which is kept running
+        std::vector<std::string> parts;
+        while (!details.empty()) {
+            auto next_space = details.find(' ');
+            if (next_space != 0)
+                parts.push_back(details.substr(0, next_space));
+            if (next_space == std::string::npos)
+                break;
+            details = details.substr(next_space + 1);
+        }
+        if (parts.size() < 2)
+            return nullptr;
+
+        // Same limits as the podman bots.
+        util::SubProcess::Sandbox sandbox;
+        sandbox.root_directory = parts.front();
+        sandbox.cgroup_parent = sandbox_cgroup_parent();
+        sandbox.memory_limit_bytes = 256ull * 1024 * 1024;
+        sandbox.cpu_percent = 100;
+
+        parts.erase(parts.begin());
+        auto algorithm = std::make_unique<Elevated::ProcessAlgorithm>(parts, Elevated::ProcessAlgorithm::InfoLevel::Low);
+        // We can see the cpu time of these, so a busy runner does not make bots time out.
+        algorithm->limit_on_cpu_time(4);
+        if (type == "zygote") {
+            auto zygote = zygote_for(name, parts, sandbox);
+            if (!zygote)
+                return nullptr;
+            algorithm->spawn_from(std::move(zygote));
+            return algorithm;
+        }
+
+        algorithm->run_in_sandbox(std::move(sandbox));
+        return algorithm;
     }
 
     return nullptr;
 }
 
+static constexpr long scenario_seed = 783675;
+static constexpr char const* in_process_runner = "in-process";
+static constexpr int64_t enqueue_lock_key = 0x656c6576;
+
+static ConnectionPool::PreparedStatement const disable_invalid_bot {
+    "elevated_disable_invalid_bot", "UPDATE elevated_bots SET running_cases = FALSE, status = 'Disabled: Command is invalid' WHERE bot_id = $1"
+};
+static ConnectionPool::PreparedStatement const disable_invalid_case {
+    "elevated_disable_invalid_case", "UPDATE elevated_cases SET enabled = FALSE WHERE case_id = $1"
+};
+// The claim check drops the result if another runner took over this run in the meantime.
+static ConnectionPool::PreparedStatement const store_run_result {
+    "elevated_store_run_result", "UPDATE elevated_run SET completed = now(), done = TRUE, success = $2, status = $3, output = $4, event_log = $5 WHERE run_id = $1 AND claimed_by = $6"
+};
+static ConnectionPool::PreparedStatement const running_bot_command {
+    "elevated_running_bot_command", "SELECT command FROM elevated_bots WHERE bot_id = $1 AND running_cases LIMIT 1"
+};
+static ConnectionPool::PreparedStatement const enabled_case_command {
+    "elevated_enabled_case_command", "SELECT command FROM elevated_cases WHERE case_id = $1 AND enabled LIMIT 1"
+};
+static ConnectionPool::PreparedStatement const insert_claimed_run {
+    "elevated_insert_claimed_run",
+    "WITH added AS (INSERT INTO elevated_run(bot_id, case_id, claimed_by) VALUES ($1, $2, $3) RETURNING run_id, bot_id, case_id),\n"
+    "latest AS (\n"
+    "    INSERT INTO elevated_latest_run(bot_id, case_id, run_id) SELECT bot_id, case_id, run_id FROM added\n"
+    "    ON CONFLICT (bot_id, case_id) DO UPDATE SET run_id = EXCLUDED.run_id, result = NULL\n"
+    "    RETURNING run_id, bot_id, case_id)\n"
+    "SELECT run_id, pg_notify($4, 'run ' || bot_id || ' ' || case_id) FROM latest"
+};
+static ConnectionPool::PreparedStatement const try_enqueue_lock {
+    "elevated_try_enqueue_lock", "SELECT pg_try_advisory_xact_lock($1)"
+};
+static ConnectionPool::PreparedStatement const enqueue_missing {
+    "elevated_enqueue_missing",
+    "WITH added AS (\n"
+    "    INSERT INTO elevated_run(bot_id, case_id)\n"
+    "    SELECT eb.bot_id, ec.case_id\n"
+    "    FROM elevated_bots eb\n"
+    "        CROSS JOIN elevated_cases ec\n"
+    "        LEFT JOIN elevated_run er on eb.bot_id = er.bot_id AND er.case_id = ec.case_id\n"
+    "    WHERE eb.running_cases AND ec.enabled AND er.run_id IS NULL\n"
+    "    RETURNING run_id, bot_id, case_id),\n"
+    "latest AS (\n"
+    "    INSERT INTO elevated_latest_run(bot_id, case_id, run_id) SELECT bot_id, case_id, run_id FROM added\n"
+    "    ON CONFLICT (bot_id, case_id) DO UPDATE SET run_id = EXCLUDED.run_id, result = NULL\n"
+    "    RETURNING bot_id, case_id)\n"
+    "SELECT pg_notify($1, 'run ' || bot_id || ' ' || case_id) FROM latest"
+};
+// Skipping locked rows lets every runner claim a different run without waiting on each other.
+static ConnectionPool::PreparedStatement const claim_next_run {
+    "elevated_claim_next_run",
+    "UPDATE elevated_run SET claimed_by = $1, heartbeat = now()\n"
+    "WHERE run_id = (\n"
+    "    SELECT er.run_id FROM elevated_run er\n"
+    "        JOIN elevated_bots eb ON eb.bot_id = er.bot_id\n"
+    "        JOIN elevated_cases ec ON ec.case_id = er.case_id\n"
+    "    WHERE NOT er.done AND eb.running_cases AND ec.enabled\n"
+    "        AND (er.claimed_by IS NULL OR er.heartbeat < now() - $2 * interval '1 second')\n"
+    "    ORDER BY er.case_id, er.run_id\n"
+    "    FOR UPDATE OF er SKIP LOCKED\n"
+    "    LIMIT 1)\n"
+    "RETURNING run_id, bot_id, case_id"
+};
+static ConnectionPool::PreparedStatement const run_commands {
+    "elevated_run_commands", "SELECT eb.command, ec.command FROM elevated_bots eb, elevated_cases ec WHERE eb.bot_id = $1 AND ec.case_id = $2"
+};
+static ConnectionPool::PreparedStatement const heartbeat_claimed_runs {
+    "elevated_heartbeat_claimed_runs", "UPDATE elevated_run SET heartbeat = now() WHERE claimed_by = $1 AND NOT done"
+};
+// Event logs are large, so runs are recomputed in batches of recompute_batch_size in run_id order.
+static constexpr int recompute_batch_size = 100;
+static ConnectionPool::PreparedStatement const stored_event_logs {
+    "elevated_stored_event_logs",
+    "SELECT run_id, event_log, output, status, cached_from IS NOT NULL FROM elevated_run\n"
+    "WHERE done AND success AND event_log IS NOT NULL AND run_id > $1\n"
+    "ORDER BY run_id\n"
+    "LIMIT $2"
+};
+static ConnectionPool::PreparedStatement const update_run_output {
+    "elevated_update_run_output", "UPDATE elevated_run SET output = $2 WHERE run_id = $1"
+};
+static Elevated::ScenarioCache scenario_cache;
+
 std::unique_ptr<Elevated::ScenarioGenerator> scenario_from_command(std::string name)
 {
-    auto result = Elevated::parse_scenario(name, 783675);
+    // Every bot runs the same cases with the same seed, so the requests are only generated once per case.
+    static Elevated::RequestTraceCache trace_cache;
+    auto trace = trace_cache.trace_for(name, scenario_seed, [&] {
+        return scenario_cache.parse(name, scenario_seed).generator;
+    });
+    if (trace)
+        return std::make_unique<Elevated::TraceScenarioGenerator>(std::move(trace));
+
+    auto result = scenario_cache.parse(name, scenario_seed);
     if (!result.generator) {
         std::cerr << "Scenario failed: \n";
         for (auto& line : result.errors)
             std::cerr << "    " << line << '\n';
-        throw "failed scenario!";
+        return nullptr;
     }
     return std::move(result.generator);
 }
 
-SimulationResult run_simulation(std::unique_ptr<Elevated::ElevatedAlgorithm> algorithm, std::unique_ptr<Elevated::ScenarioGenerator> generator)
+static void add_log_stats(SimulationResult& result, Elevated::EventLogStats const& stats)
+{
+    result.add_stat("avg-wait", stats.average_wait_time);
+    result.add_stat("max-wait", stats.max_wait_time);
+    result.add_stat("p95-wait", stats.p95_wait_time);
+
+    result.add_stat("max-travel", stats.max_travel_time);
+    result.add_stat("avg-travel", stats.average_travel_time);
+
+    result.add_stat("max-door-open-passenger", stats.max_times_door_opened);
+    result.add_stat("done-at-first-stop", stats.first_stop_passengers);
+    result.add_stat("avg-stops-until-arrival", stats.average_stops_passengers);
+
+    result.add_stat("power", stats.time_stopped_with_passengers + stats.times_door_opened + stats.total_distance_travelled);
+
+    result.add_stat("rollercoaster-events", stats.roller_coaster_events);
+    result.add_stat("travelling-stops-events", stats.travelling_stops);
+
+    result.add_stat("max-elevator-travel-distance", stats.max_elevator_travel_distance);
+    result.add_stat("min-elevator-travel-distance", stats.min_elevator_travel_distance);
+    result.add_stat("avg-elevator-travel-distance", stats.avg_elevator_travel_distance);
+    result.add_stat("sum-elevator-travel-distance", stats.sum_elevator_travel_distance);
+
+    result.add_stat("max-times-elevator-doors-opened", stats.max_elevator_doors_opened);
+    result.add_stat("min-times-elevator-doors-opened", stats.min_elevator_doors_opened);
+    result.add_stat("avg-times-elevator-doors-opened", stats.avg_elevator_doors_opened);
+
+    result.add_stat("max-elevator-time-stopped", stats.max_elevator_time_stopped);
+    result.add_stat("min-elevator-time-stopped", stats.min_elevator_time_stopped);
+    result.add_stat("avg-elevator-time-stopped", stats.avg_elevator_time_stopped);
+
+    result.add_stat("max-elevator-load", stats.max_elevator_load);
+}
+
+static std::string encode_stats(SimulationResult const& result)
+{
+    crow::json::wvalue encoded_result;
+    for (auto& stat : result.stats) {
+        std::visit([&](auto arg) {
+            encoded_result[stat.name] = arg;
+        }, stat.value);
+    }
+    return encoded_result.dump();
+}
+
+static void add_usage_stats(SimulationResult& result, util::SubProcess::ResourceUsage const& usage)
+{
+    result.add_stat("cpu-user-ms", usage.user_microseconds / 1000);
+    result.add_stat("cpu-system-ms", usage.system_microseconds / 1000);
+    result.add_stat("peak-memory-kb", usage.peak_memory_kilobytes);
+    result.add_stat("voluntary-context-switches", usage.voluntary_context_switches);
+    result.add_stat("involuntary-context-switches", usage.involuntary_context_switches);
+}
+
+static constexpr char const* usage_stat_names[] = {
+    "cpu-user-ms", "cpu-system-ms", "peak-memory-kb", "voluntary-context-switches", "involuntary-context-switches"
+};
+
+SimulationResult run_simulation(std::unique_ptr<Elevated::ElevatedAlgorithm> algorithm, std::unique_ptr<Elevated::ScenarioGenerator> generator, bool record_resource_usage)
 {
     static std::unordered_map<Elevated::SimulatorResult::Type, std::string> type_to_message {
         { Elevated::SimulatorResult::Type::AlgorithmFailed, "Algorithm failed/timed out" },
@@ -71,12 +300,11 @@ SimulationResult run_simulation(std::unique_ptr<Elevated::ElevatedAlgorithm> alg
     };
     ASSERT(algorithm);
     ASSERT(generator);
+    auto* process = record_resource_usage ? dynamic_cast<Elevated::ProcessAlgorithm*>(algorithm.get()) : nullptr;
     Elevated::Simulation simulation{std::move(generator), std::move(algorithm)};
 
-    auto passenger_stats = simulation.construct_and_add_listener<Elevated::PassengerStatsListener>();
-    auto power_stats = simulation.construct_and_add_listener<Elevated::PowerStatsListener>();
-    auto elevator_stats = simulation.construct_and_add_listener<Elevated::ElevatorStatsListener>();
-    auto special_stats = simulation.construct_and_add_listener<Elevated::SpecialEventsListener>();
+    // All stats are computed from the log afterwards, so they can be computed again for stored runs.
+    auto event_log = simulation.construct_and_add_listener<Elevated::EventLog>();
 
     auto result = simulation.run_full_simulation();
 
@@ -85,33 +313,12 @@ SimulationResult run_simulation(std::unique_ptr<Elevated::ElevatedAlgorithm> alg
     full_result.messages = std::move(result.output_messages);
 
     if (result.type == Elevated::SimulatorResult::Type::SuccessFull) {
-        full_result.add_stat("avg-wait", passenger_stats->average_wait_time());
-        full_result.add_stat("max-wait", passenger_stats->max_wait_times());
-
-        full_result.add_stat("max-travel", passenger_stats->max_travel_times());
-        full_result.add_stat("avg-travel", passenger_stats->average_travel_time());
-
-        full_result.add_stat("max-door-open-passenger", passenger_stats->max_times_door_opened());
-        full_result.add_stat("done-at-first-stop", passenger_stats->first_stop_passengers());
-        full_result.add_stat("avg-stops-until-arrival", passenger_stats->average_stops_passengers());
-
-        full_result.add_stat("power", power_stats->time_stopped_with_passengers() + power_stats->times_door_opened() + power_stats->total_distance_travelled());
-
-        full_result.add_stat("rollercoaster-events", special_stats->total_roller_coaster_events());
-        full_result.add_stat("travelling-stops-events", special_stats->total_travelling_stops());
-
-        full_result.add_stat("max-elevator-travel-distance", elevator_stats->max_travel_distance());
-        full_result.add_stat("min-elevator-travel-distance", elevator_stats->min_travel_distance());
-        full_result.add_stat("avg-elevator-travel-distance", elevator_stats->avg_travel_distance());
-        full_result.add_stat("sum-elevator-travel-distance", elevator_stats->total_travel_distance());
-
-        full_result.add_stat("max-times-elevator-doors-opened", elevator_stats->max_doors_opened());
-        full_result.add_stat("min-times-elevator-doors-opened", elevator_stats->min_doors_opened());
-        full_result.add_stat("avg-times-elevator-doors-opened", elevator_stats->avg_doors_opened());
-
-        full_result.add_stat("max-elevator-time-stopped", elevator_stats->max_time_stopped());
-        full_result.add_stat("min-elevator-time-stopped", elevator_stats->min_time_stopped());
-        full_result.add_stat("avg-elevator-time-stopped", elevator_stats->avg_time_stopped());
+        add_log_stats(full_result, Elevated::evaluate_event_log(*event_log));
+        full_result.event_log = event_log->serialize();
+        if (process) {
+            if (auto usage = process->resource_usage(); usage.has_value())
+                add_usage_stats(full_result, *usage);
+        }
     } else if (result.type == Elevated::SimulatorResult::Type::AlgorithmRejected) {
         full_result.rejected = true;
     } else {
@@ -121,42 +328,28 @@ SimulationResult run_simulation(std::unique_ptr<Elevated::ElevatedAlgorithm> alg
     return full_result;
 }
 
-void run_and_store_simulation(uint32_t bot_id, uint32_t case_id)
+static void run_and_store(ClaimedRun const& run, std::string const& runner_name)
 {
-    bool fail = true;
-    std::string bot_command;
-    std::string case_command;
-    uint64_t run_id;
-
-    ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
-        pqxx::work transaction{connection};
-        connection.prepare("SELECT command FROM elevated_bots WHERE bot_id = $1 AND running_cases LIMIT 1");
-        auto result = transaction.exec_prepared("", bot_id);
-
-        if (result.empty())
-            return;
-
-        bot_command = result[0][0].c_str();
-
-        connection.prepare("SELECT command FROM elevated_cases WHERE case_id = $1 AND enabled LIMIT 1");
-        auto case_result = transaction.exec_prepared("", case_id);
-
-        if (case_result.empty())
+    auto run_id = run.run_id;
+    auto bot_id = run.bot_id;
+    auto case_id = run.case_id;
+    auto const& bot_command = run.bot_command;
+    auto const& case_command = run.case_command;
+
+    // The same bot on the same scenario gives the same result, so it is only run once.
+    std::optional<ResultKey> result_key;
+    if (auto compiled = scenario_cache.compile(case_command); compiled.scenario)
+        result_key = result_key_for(bot_command, compiled.scenario->canonical(), scenario_seed);
+
+    if (result_key) {
+        auto cached_run = ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
+            auto source_run = find_cached_run(connection, *result_key);
+            if (source_run && !copy_cached_run(connection, run_id, *source_run, runner_name))
+                std::cerr << "Run " << run_id << " is no longer claimed by " << runner_name << ", dropping its cached result\n";
+            return source_run;
+        });
+        if (cached_run)
             return;
-
-        case_command = case_result[0][0].c_str();
-
-        connection.prepare("INSERT INTO elevated_run(bot_id, case_id) VALUES ($1, $2) RETURNING run_id");
-        auto run_result = transaction.exec_prepared1("", bot_id, case_id);
-        transaction.commit();
-        run_id = run_result[0].as<uint64_t>();
-
-        fail = false;
-    });
-
-    if (fail) {
-        std::cerr << "Failed to run bot " << bot_id << " on " << case_id << '\n';
-        return;
     }
 
     auto algorithm = algorithm_from_command(bot_command);
@@ -164,7 +357,8 @@ void run_and_store_simulation(uint32_t bot_id, uint32_t case_id)
     if (!algorithm) {
         ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
             pqxx::work transaction { connection };
-            transaction.exec("UPDATE elevated_bots SET running_cases = FALSE, status = 'Disabled: Command is invalid' WHERE bot_id = " + std::to_string(bot_id));
+            transaction.exec_prepared(disable_invalid_bot.name, bot_id);
+            notify_bot_changed(transaction, bot_id);
             transaction.commit();
         });
         std::cerr << "Invalid bot: " << bot_command << " disabled and skipping this\n";
@@ -176,14 +370,16 @@ void run_and_store_simulation(uint32_t bot_id, uint32_t case_id)
     if (!generator) {
         ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
             pqxx::work transaction { connection };
-            transaction.exec("UPDATE elevated_cases SET running_cases = FALSE WHERE case_id = " + std::to_string(case_id));
+            transaction.exec_prepared(disable_invalid_case.name, case_id);
             transaction.commit();
         });
         std::cerr << "Invalid generator: " << case_command << " disabled and skipping this\n";
         return;
     }
 
-    auto result = run_simulation(std::move(algorithm), std::move(generator));
+    // For podman bots we would only see the podman client, the bot itself runs under conmon.
+    bool own_process = !bot_command.starts_with("podman:");
+    auto result = run_simulation(std::move(algorithm), std::move(generator), own_process);
 
     bool success = !(result.failed || result.rejected);
     std::string status = result.failed ? "failed" : result.rejected ? "rejected" : "done";
@@ -191,25 +387,185 @@ void run_and_store_simulation(uint32_t bot_id, uint32_t case_id)
     std::string output;
 
     if (success) {
-        crow::json::wvalue encoded_result;
-        for (auto& stat : result.stats) {
-            std::visit([&](auto arg) {
-                encoded_result[stat.name] = arg;
-            }, stat.value);
-        }
-
-        output = encoded_result.dump();
+        output = encode_stats(result);
     } else {
         for (auto& message : result.messages)
             output += message + '\n';
     }
+    auto stored = ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
+        pqxx::work transaction{connection};
+        std::optional<std::basic_string<std::byte>> event_log;
+        if (!result.event_log.empty())
+            event_log.emplace(reinterpret_cast<std::byte const*>(result.event_log.data()), result.event_log.size());
+        auto run_result = transaction.exec_prepared(store_run_result.name, run_id, success, status, output, event_log, runner_name);
+        if (run_result.affected_rows() != 1) {
+            std::cerr << "Run " << run_id << " is no longer claimed by " << runner_name << ", dropping its result\n";
+            return false;
+        }
+        store_latest_run_result(transaction, run_id, latest_run_json(true, success, status, output, false));
+        transaction.commit();
+        return true;
+    });
+
+    // Failures can be caused by the machine (e.g. timeouts), so only actual results are reused.
+    if (stored && result_key && !result.failed) {
+        ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
+            store_cached_run(connection, *result_key, run_id);
+        });
+    }
+}
+
+void run_and_store_simulation(uint32_t bot_id, uint32_t case_id)
+{
+    bool fail = true;
+    ClaimedRun run { 0, bot_id, case_id, {}, {} };
+
     ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
         pqxx::work transaction{connection};
-        connection.prepare("UPDATE elevated_run SET completed = now(), done = TRUE, success = $2, status = $3, output = $4 WHERE run_id = $1");
-        auto run_result = transaction.exec_prepared("", run_id, success, status, output);
-        ASSERT(run_result.affected_rows() == 1);
+        auto result = transaction.exec_prepared(running_bot_command.name, bot_id);
+
+        if (result.empty())
+            return;
+
+        run.bot_command = result[0][0].c_str();
+
+        auto case_result = transaction.exec_prepared(enabled_case_command.name, case_id);
+
+        if (case_result.empty())
+            return;
+
+        run.case_command = case_result[0][0].c_str();
+
+        auto run_result = transaction.exec_prepared1(insert_claimed_run.name, bot_id, case_id, in_process_runner, progress_channel);
         transaction.commit();
+        run.run_id = run_result[0].as<uint64_t>();
+
+        fail = false;
     });
+
+    if (fail) {
+        std::cerr << "Failed to run bot " << bot_id << " on " << case_id << '\n';
+        return;
+    }
+
+    run_and_store(run, in_process_runner);
+}
+
+void add_runner_columns(pqxx::connection& connection)
+{
+    pqxx::work transaction { connection };
+    transaction.exec(
+        "ALTER TABLE elevated_run\n"
+        "    ADD COLUMN IF NOT EXISTS claimed_by TEXT,\n"
+        "    ADD COLUMN IF NOT EXISTS heartbeat TIMESTAMPTZ,\n"
+        "    ADD COLUMN IF NOT EXISTS event_log BYTEA,\n"
+        "    ADD COLUMN IF NOT EXISTS cached_from BIGINT");
+    transaction.commit();
+}
+
+size_t enqueue_missing_runs()
+{
+    return ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) -> size_t {
+        pqxx::work transaction{connection};
+        // Only one runner enqueues at a time, otherwise runs could be added twice.
+        auto locked = transaction.exec_prepared1(try_enqueue_lock.name, enqueue_lock_key);
+        if (!locked[0].as<bool>())
+            return 0;
+
+        auto result = transaction.exec_prepared(enqueue_missing.name, progress_channel);
+        transaction.commit();
+        return result.size();
+    });
+}
+
+std::optional<ClaimedRun> claim_run(std::string const& runner_name)
+{
+    return ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) -> std::optional<ClaimedRun> {
+        pqxx::work transaction{connection};
+        auto claimed = transaction.exec_prepared(claim_next_run.name, runner_name, claim_timeout_seconds);
+        if (claimed.empty())
+            return std::nullopt;
+
+        ClaimedRun run { claimed[0][0].as<uint64_t>(), claimed[0][1].as<uint32_t>(), claimed[0][2].as<uint32_t>(), {}, {} };
+
+        auto commands = transaction.exec_prepared1(run_commands.name, run.bot_id, run.case_id);
+        run.bot_command = commands[0].c_str();
+        run.case_command = commands[1].c_str();
+
+        transaction.commit();
+        return run;
+    });
+}
+
+void run_claimed_simulation(ClaimedRun const& run, std::string const& runner_name)
+{
+    run_and_store(run, runner_name);
+}
+
+void heartbeat_claims(std::string const& runner_name)
+{
+    ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
+        pqxx::work transaction{connection};
+        transaction.exec_prepared(heartbeat_claimed_runs.name, runner_name);
+        transaction.commit();
+    });
+}
+
+size_t recompute_stats_from_event_logs()
+{
+    struct StoredRun {
+        uint64_t run_id;
+        std::string event_log;
+        std::string output;
+        std::string status;
+        bool cached;
+    };
+
+    size_t updated = 0;
+    uint64_t after_run_id = 0;
+    while (true) {
+        std::vector<StoredRun> runs;
+        ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
+            pqxx::read_transaction transaction{connection};
+            auto result = transaction.exec_prepared(stored_event_logs.name, after_run_id, recompute_batch_size);
+            for (auto row : result) {
+                auto bytes = row[1].as<std::basic_string<std::byte>>();
+                runs.push_back({ row[0].as<uint64_t>(), std::string(reinterpret_cast<char const*>(bytes.data()), bytes.size()), row[2].c_str(), row[3].c_str(), row[4].as<bool>() });
+            }
+        });
+        if (runs.empty())
+            break;
+        after_run_id = runs.back().run_id;
+
+        for (auto& run : runs) {
+            auto log = Elevated::EventLog::deserialize(run.event_log);
+            if (!log) {
+                std::cerr << "Stored event log of run " << run.run_id << " is invalid\n";
+                continue;
+            }
+
+            // The total time and resource usage are not part of the log, so they are kept from the stored stats.
+            SimulationResult result{};
+            auto stored = crow::json::load(run.output);
+            if (stored && stored.has("total-time"))
+                result.add_stat("total-time", static_cast<uint64_t>(stored["total-time"].u()));
+            for (auto* name : usage_stat_names) {
+                if (stored && stored.has(name))
+                    result.add_stat(name, static_cast<uint64_t>(stored[name].u()));
+            }
+            add_log_stats(result, Elevated::evaluate_event_log(*log));
+
+            ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
+                pqxx::work transaction{connection};
+                auto output = encode_stats(result);
+                transaction.exec_prepared(update_run_output.name, run.run_id, output);
+                store_latest_run_result(transaction, run.run_id, latest_run_json(true, true, run.status, output, run.cached));
+                transaction.commit();
+            });
+            ++updated;
+        }
+    }
+    return updated;
 }
 
 }
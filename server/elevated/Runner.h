@@ -2,6 +2,8 @@
 
 #include <elevated/algorithm/Algorithm.h>
 #include <memory>
+#include <optional>
+#include <pqxx/connection>
 #include <string>
 
 namespace BBServer {
@@ -39,14 +41,51 @@ struct SimulationResult {
 
     std::vector<ResultStats> stats;
 
+    // Every event of a successful run, see Elevated::EventLog::serialize.
+    std::string event_log;
+
     template<typename ValueType>
     void add_stat(std::string name, ValueType value) {
         stats.emplace_back(std::move(name), value);
     }
 };
 
-SimulationResult run_simulation(std::unique_ptr<Elevated::ElevatedAlgorithm>, std::unique_ptr<Elevated::ScenarioGenerator>);
+// With record_resource_usage the cpu time and memory of process bots are added to the stats,
+// only useful if the process is the bot itself and not a wrapper like podman.
+SimulationResult run_simulation(std::unique_ptr<Elevated::ElevatedAlgorithm>, std::unique_ptr<Elevated::ScenarioGenerator>, bool record_resource_usage = false);
 
+// Runs the bot on the case in this process, the run is claimed by "in-process".
 void run_and_store_simulation(uint32_t bot_id, uint32_t case_id);
 
+// Standalone runners (see elevated-runner.cpp) share the work through the
+// elevated_run table: every missing (bot, case) run is added unclaimed, and
+// each runner claims one run at a time. Claims without a heartbeat for
+// claim_timeout_seconds can be taken over by another runner.
+constexpr int claim_timeout_seconds = 60;
+
+// Adds the columns for claims, event logs and cached results to elevated_run if they
+// do not exist yet. Like create_latest_runs_table this has to run before ConnectionPool::initialize_pool.
+void add_runner_columns(pqxx::connection& connection);
+
+struct ClaimedRun {
+    uint64_t run_id;
+    uint32_t bot_id;
+    uint32_t case_id;
+    std::string bot_command;
+    std::string case_command;
+};
+
+// Adds a run for every (bot, case) without one, returns how many were added.
+size_t enqueue_missing_runs();
+
+std::optional<ClaimedRun> claim_run(std::string const& runner_name);
+void run_claimed_simulation(ClaimedRun const& run, std::string const& runner_name);
+
+// Keeps every unfinished claim of this runner alive.
+void heartbeat_claims(std::string const& runner_name);
+
+// Recomputes the stats of every stored run which has an event log, this is how
+// new stats get values for old runs. Returns the number of runs updated.
+size_t recompute_stats_from_event_logs();
+
 }
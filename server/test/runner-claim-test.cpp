@@ -0,0 +1,117 @@
+#include <catch2/catch.hpp>
+#include "../database/ConnectionPool.h"
+#include "../elevated/LatestRuns.h"
+#include "../elevated/ResultCache.h"
+#include "../elevated/Runner.h"
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace BBServer;
+
+// Runs against a scratch database given as BBSERVER_TEST_DATABASE, everything
+// is created in a schema of its own which is dropped afterwards.
+static std::optional<std::string> test_database()
+{
+    auto* database = std::getenv("BBSERVER_TEST_DATABASE");
+    if (database == nullptr || *database == '\0')
+        return std::nullopt;
+    return database;
+}
+
+static void create_runner_tables(pqxx::connection& connection, std::string const& schema)
+{
+    pqxx::work transaction { connection };
+    transaction.exec("CREATE SCHEMA " + schema);
+    transaction.exec("SET LOCAL search_path TO " + schema);
+    // Only the columns the runners use, as they were before the runners added theirs.
+    transaction.exec("CREATE TABLE elevated_bots (bot_id BIGSERIAL PRIMARY KEY, command TEXT NOT NULL, running_cases BOOLEAN, status TEXT)");
+    transaction.exec("CREATE TABLE elevated_cases (case_id BIGSERIAL PRIMARY KEY, command TEXT NOT NULL, enabled BOOLEAN NOT NULL DEFAULT TRUE)");
+    transaction.exec(
+        "CREATE TABLE elevated_run (\n"
+        "    run_id BIGSERIAL PRIMARY KEY,\n"
+        "    bot_id BIGINT NOT NULL REFERENCES elevated_bots(bot_id),\n"
+        "    case_id BIGINT NOT NULL REFERENCES elevated_cases(case_id),\n"
+        "    started TIMESTAMP NOT NULL DEFAULT now(),\n"
+        "    completed TIMESTAMP,\n"
+        "    done BOOLEAN NOT NULL DEFAULT FALSE,\n"
+        "    success BOOLEAN,\n"
+        "    status TEXT,\n"
+        "    output TEXT\n"
+        ")");
+    transaction.commit();
+}
+
+TEST_CASE("Runners claiming from one queue", "[runner][database]") {
+    auto database = test_database();
+    REQUIRE(database);
+
+    auto schema = "runner_test_" + std::to_string(getpid());
+    {
+        pqxx::connection connection { *database };
+        create_runner_tables(connection, schema);
+    }
+
+    // The pool can only be set up once per process, so this is one test case without sections.
+    auto in_schema = *database + (database->find('?') == std::string::npos ? "?" : "&") + "options=-csearch_path%3D" + schema;
+    {
+        pqxx::connection connection { in_schema };
+        add_runner_columns(connection);
+        create_result_cache_table(connection);
+        create_latest_runs_table(connection);
+        pqxx::work transaction { connection };
+        for (int bot = 0; bot < 2; ++bot)
+            transaction.exec("INSERT INTO elevated_bots(command, running_cases) VALUES ('internal:cycle', TRUE)");
+        for (int elevated_case = 0; elevated_case < 10; ++elevated_case)
+            transaction.exec("INSERT INTO elevated_cases(command) VALUES ('named-scenario(basic-1)')");
+        transaction.commit();
+    }
+    ConnectionPool::initialize_pool(4, in_schema);
+
+    auto age_heartbeats_of = [&](std::string const& runner) {
+        pqxx::connection connection { in_schema };
+        pqxx::work transaction { connection };
+        transaction.exec_params("UPDATE elevated_run SET heartbeat = now() - $2 * interval '1 second' WHERE claimed_by = $1",
+            runner, claim_timeout_seconds + 1);
+        transaction.commit();
+    };
+
+    REQUIRE(enqueue_missing_runs() == 20);
+    REQUIRE(enqueue_missing_runs() == 0);
+
+    std::vector<uint64_t> claimed_by_a;
+    std::vector<uint64_t> claimed_by_b;
+    auto claim_all = [](std::string const& runner, std::vector<uint64_t>& claimed) {
+        while (auto run = claim_run(runner))
+            claimed.push_back(run->run_id);
+    };
+    std::thread runner_a(claim_all, "runner-a", std::ref(claimed_by_a));
+    std::thread runner_b(claim_all, "runner-b", std::ref(claimed_by_b));
+    runner_a.join();
+    runner_b.join();
+
+    // Every run is claimed exactly once.
+    std::set<uint64_t> all_claimed { claimed_by_a.begin(), claimed_by_a.end() };
+    all_claimed.insert(claimed_by_b.begin(), claimed_by_b.end());
+    CHECK(all_claimed.size() == 20);
+    CHECK(claimed_by_a.size() + claimed_by_b.size() == 20);
+
+    // Runs of a runner which stopped its heartbeat are taken over, those with one are not.
+    heartbeat_claims("runner-a");
+    age_heartbeats_of("runner-b");
+    std::vector<uint64_t> taken_over;
+    claim_all("runner-a", taken_over);
+    std::sort(taken_over.begin(), taken_over.end());
+    std::sort(claimed_by_b.begin(), claimed_by_b.end());
+    CHECK(taken_over == claimed_by_b);
+    CHECK_FALSE(claim_run("runner-b").has_value());
+
+    pqxx::connection connection { *database };
+    pqxx::work transaction { connection };
+    transaction.exec("DROP SCHEMA " + schema + " CASCADE");
+    transaction.commit();
+}
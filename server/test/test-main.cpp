@@ -0,0 +1,18 @@
+#define CATCH_CONFIG_RUNNER
+#include <catch2/catch.hpp>
+#include <cstdlib>
+#include <iostream>
+
+// ctest treats this as skipped, see SKIP_RETURN_CODE in server/CMakeLists.txt
+static constexpr int skip_return_code = 4;
+
+int main(int argc, char* argv[])
+{
+    auto* database = std::getenv("BBSERVER_TEST_DATABASE");
+    if (database == nullptr || *database == '\0') {
+        std::cerr << "BBSERVER_TEST_DATABASE is not set, skipping the runner tests\n";
+        return skip_return_code;
+    }
+
+    return Catch::Session().run(argc, argv);
+}
@@ -13,13 +13,23 @@ namespace BBServer {
 
 static constexpr std::string_view random_player_command = "internal:random";
 
+static ConnectionPool::PreparedStatement const vijf_bot_state {
+    "vijf_bot_state", "SELECT state, command FROM vijf_bots WHERE bot_id = $1"
+};
+static ConnectionPool::PreparedStatement const vijf_update_bot_state {
+    "vijf_update_bot_state", "UPDATE vijf_bots SET state = $1, failed = $2 WHERE bot_id = $3"
+};
+static ConnectionPool::PreparedStatement const vijf_enable_bot {
+    "vijf_enable_bot", "UPDATE vijf_bots SET state = $1, enabled = TRUE, command = $2 WHERE bot_id = $3"
+};
+
 bool create_vijf_bot_in_container(uint32_t id) {
 
     std::string filename;
     auto start_status = ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) -> std::string {
         pqxx::read_transaction transaction{connection};
 
-        auto result = transaction.exec("SELECT state, command FROM vijf_bots WHERE bot_id = " + std::to_string(id));
+        auto result = transaction.exec_prepared(vijf_bot_state.name, id);
         if (result.size() > 1) {
             ASSERT_NOT_REACHED();
         }
@@ -48,9 +58,7 @@ bool create_vijf_bot_in_container(uint32_t id) {
         ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
             pqxx::work transaction{connection};
 
-            connection.prepare("UPDATE vijf_bots SET state = $1, failed = $2 WHERE bot_id = $3");
-
-            auto result = transaction.exec_prepared0("", new_status, failed, id);
+            auto result = transaction.exec_prepared0(vijf_update_bot_state.name, new_status, failed, id);
             ASSERT(result.affected_rows() == 1);
             transaction.commit();
         });
@@ -117,9 +125,7 @@ bool create_vijf_bot_in_container(uint32_t id) {
     ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
         pqxx::work transaction{connection};
 
-        connection.prepare("UPDATE vijf_bots SET state = $1, enabled = TRUE, command = $2 WHERE bot_id = $3");
-
-        auto result = transaction.exec_prepared0("", "Running in tournament", run_command, id);
+        auto result = transaction.exec_prepared0(vijf_enable_bot.name, "Running in tournament", run_command, id);
         ASSERT(result.affected_rows() == 1);
         transaction.commit();
     });
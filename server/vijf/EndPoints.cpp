@@ -9,6 +9,29 @@
 
 namespace BBServer {
 
+static ConnectionPool::PreparedStatement const vijf_bot_games {
+    "vijf_bot_games", "SELECT COUNT(*) as played, COUNT(*) filter ( where game_result = 5 ) as won FROM vijf_game_players WHERE bot_id = $1"
+};
+static ConnectionPool::PreparedStatement const vijf_bots_of_user {
+    "vijf_bots_of_user", "SELECT bot_id, name, enabled, failed, state FROM vijf_bots WHERE user_id = $1 ORDER BY created DESC LIMIT 50"
+};
+static ConnectionPool::PreparedStatement const vijf_bot_name_taken {
+    "vijf_bot_name_taken", "SELECT 1 FROM vijf_bots WHERE user_id = $1 and name = $2"
+};
+static ConnectionPool::PreparedStatement const vijf_insert_bot {
+    "vijf_insert_bot", "INSERT INTO vijf_bots(name, user_id, command)  VALUES ($1, $2, $3) RETURNING bot_id"
+};
+static ConnectionPool::PreparedStatement const vijf_leaderboard {
+    "vijf_leaderboard",
+    "SELECT vijf_bots.name, vijf_bots.bot_id,  COUNT(*) as played, COUNT(*) filter ( where vgp.game_result = 5 ) as won, u.display_name\n"
+    "FROM vijf_bots INNER JOIN vijf_game_players vgp on vijf_bots.bot_id = vgp.bot_id INNER JOIN users u on vijf_bots.user_id = u.user_id\n"
+    "WHERE enabled\n"
+    "GROUP BY vijf_bots.bot_id, u.user_id\n"
+    "HAVING count(*) > 5\n"
+    "ORDER BY won DESC\n"
+    "LIMIT 100"
+};
+
 void add_vijf_endpoints(ServerType& app, boost::asio::io_service& io_service)
 {
 
@@ -17,8 +40,7 @@ void add_vijf_endpoints(ServerType& app, boost::asio::io_service& io_service)
         auto& base_context = app.get_context<BBServer::BaseMiddleware>(req);
         pqxx::read_transaction transaction {*base_context.database_connection};
 
-        base_context.database_connection->prepare("SELECT COUNT(*) as played, COUNT(*) filter ( where game_result = 5 ) as won FROM vijf_game_players WHERE bot_id = $1");
-        auto results = transaction.exec_prepared1("", bot_id);
+        auto results = transaction.exec_prepared1(vijf_bot_games.name, bot_id);
 
         return crow::json::wvalue {
             {"played", results[0].as<long>()},
@@ -33,9 +55,7 @@ void add_vijf_endpoints(ServerType& app, boost::asio::io_service& io_service)
         auto& base_context = app.get_context<BBServer::BaseMiddleware>(req);
         pqxx::read_transaction transaction {*base_context.database_connection};
 
-        base_context.database_connection->prepare("SELECT bot_id, name, enabled, failed, state FROM vijf_bots WHERE user_id = $1 ORDER BY created DESC LIMIT 50");
-
-        auto results = transaction.exec_prepared("", base_context.user.id);
+        auto results = transaction.exec_prepared(vijf_bots_of_user.name, base_context.user.id);
 
         std::vector<crow::json::wvalue> bots;
         bots.reserve(results.size());
@@ -94,13 +114,11 @@ void add_vijf_endpoints(ServerType& app, boost::asio::io_service& io_service)
         auto& base_context = app.get_context<BBServer::BaseMiddleware>(req);
         pqxx::work transaction {*base_context.database_connection};
 
-        base_context.database_connection->prepare("SELECT 1 FROM vijf_bots WHERE user_id = $1 and name = $2");
-        auto has_result = transaction.exec_prepared("", base_context.user.id, trimmed_name);
+        auto has_result = transaction.exec_prepared(vijf_bot_name_taken.name, base_context.user.id, trimmed_name);
         if (!has_result.empty())
             return BBServer::fail_response_with_message(resp, 400, "You already have a bot with that name");
 
-        base_context.database_connection->prepare("INSERT INTO vijf_bots(name, user_id, command)  VALUES ($1, $2, $3) RETURNING bot_id");
-        auto result = transaction.exec_prepared1("", trimmed_name, base_context.user.id, file_name);
+        auto result = transaction.exec_prepared1(vijf_insert_bot.name, trimmed_name, base_context.user.id, file_name);
         auto bot_id = result[0].as<uint32_t>();
 
         transaction.commit();
@@ -175,13 +193,7 @@ void add_vijf_endpoints(ServerType& app, boost::asio::io_service& io_service)
             auto& base_context = app.get_context<BBServer::BaseMiddleware>(req);
             pqxx::read_transaction transaction{*base_context.database_connection};
 
-            auto db_results = transaction.exec("SELECT vijf_bots.name, vijf_bots.bot_id,  COUNT(*) as played, COUNT(*) filter ( where vgp.game_result = 5 ) as won, u.display_name\n"
-                                               "FROM vijf_bots INNER JOIN vijf_game_players vgp on vijf_bots.bot_id = vgp.bot_id INNER JOIN users u on vijf_bots.user_id = u.user_id\n"
-                                               "WHERE enabled\n"
-                                               "GROUP BY vijf_bots.bot_id, u.user_id\n"
-                                               "HAVING count(*) > 5\n"
-                                               "ORDER BY won DESC\n"
-                                               "LIMIT 100");
+            auto db_results = transaction.exec_prepared(vijf_leaderboard.name);
 
             for (auto row : db_results) {
                 results.emplace_back(PlayerResult{row[0].c_str(), row[1].as<long>(), row[2].as<long>(), row[3].as<long>(), row[4].c_str()});
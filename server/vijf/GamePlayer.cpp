@@ -11,6 +11,25 @@
 
 namespace BBServer {
 
+static ConnectionPool::PreparedStatement const vijf_enabled_bot_command {
+    "vijf_enabled_bot_command", "SELECT command FROM vijf_bots WHERE bot_id = $1 AND enabled LIMIT 1"
+};
+static ConnectionPool::PreparedStatement const vijf_least_played_bots {
+    "vijf_least_played_bots", "SELECT vijf_bots.bot_id, command, COUNT(*) as games FROM vijf_bots LEFT JOIN vijf_game_players vgp ON vijf_bots.bot_id = vgp.bot_id WHERE enabled GROUP BY vijf_bots.bot_id ORDER BY games ASC, created DESC LIMIT 5"
+};
+static ConnectionPool::PreparedStatement const vijf_most_won_bots {
+    "vijf_most_won_bots", "SELECT bot_id, command, COUNT(*) filter ( where game_result = 5 )as won FROM vijf_bots NATURAL JOIN vijf_game_players vgp WHERE enabled GROUP BY bot_id ORDER BY won DESC, created DESC LIMIT 5"
+};
+static ConnectionPool::PreparedStatement const vijf_disable_bot {
+    "vijf_disable_bot", "UPDATE vijf_bots SET enabled = FALSE, state = $2 WHERE bot_id = $1"
+};
+static ConnectionPool::PreparedStatement const vijf_insert_game {
+    "vijf_insert_game", "INSERT INTO vijf_games (start_data, turn_data, rounds_played, moves_played) VALUES ($1, $2, $3, $4) RETURNING game_id"
+};
+static ConnectionPool::PreparedStatement const vijf_insert_game_player {
+    "vijf_insert_game_player", "INSERT INTO vijf_game_players (game_id, game_position, bot_id, instadied, game_result, events) VALUES ($1, $2, $3, $4, $5, $6)"
+};
+
 static std::mutex engine_lock;
 static std::mt19937 rng_engine;
 
@@ -56,7 +75,6 @@ CompleteGameResult play_and_record_game(Vijf::StartData start_data, std::array<s
     std::array<std::string_view, Vijf::player_count> commands = {};
     ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
         pqxx::read_transaction transaction{connection};
-        connection.prepare("SELECT command FROM vijf_bots WHERE bot_id = $1 AND enabled LIMIT 1");
 
         for (int i = 0; i < Vijf::player_count; ++i) {
             if (!bot_ids[i].has_value()) {
@@ -64,7 +82,7 @@ CompleteGameResult play_and_record_game(Vijf::StartData start_data, std::array<s
                 continue;
             }
 
-            auto result = transaction.exec_prepared("", bot_ids[i].value());
+            auto result = transaction.exec_prepared(vijf_enabled_bot_command.name, bot_ids[i].value());
             if (result.empty()) {
                 std::cerr << "Needed to play a game with " << bot_ids[i].value() << " but does not exist (maybe disabled in the mean time??\n";
                 fail = true;
@@ -122,7 +140,7 @@ std::optional<std::array<Bot, Vijf::player_count>> new_players()
     std::array<Bot, Vijf::player_count> bots;
     ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
         pqxx::read_transaction transaction{connection};
-        auto result = transaction.exec("SELECT vijf_bots.bot_id, command, COUNT(*) as games FROM vijf_bots LEFT JOIN vijf_game_players vgp ON vijf_bots.bot_id = vgp.bot_id WHERE enabled GROUP BY vijf_bots.bot_id ORDER BY games ASC, created DESC LIMIT 5");
+        auto result = transaction.exec_prepared(vijf_least_played_bots.name);
 
         if (result.size() < 3) {
             fail = true;
@@ -153,7 +171,7 @@ std::optional<std::array<Bot, Vijf::player_count>> top_players()
     std::array<Bot, Vijf::player_count> bots;
     ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
         pqxx::read_transaction transaction{connection};
-        auto result = transaction.exec("SELECT bot_id, command, COUNT(*) filter ( where game_result = 5 )as won FROM vijf_bots NATURAL JOIN vijf_game_players vgp WHERE enabled GROUP BY bot_id ORDER BY won DESC, created DESC LIMIT 5");
+        auto result = transaction.exec_prepared(vijf_most_won_bots.name);
 
         if (result.size() < 3) {
             fail = true;
@@ -220,13 +238,12 @@ void add_game_result(CompleteGameResult new_result)
     pending_results.emplace_back(std::move(new_result));
 }
 
-void disable_player(pqxx::connection& connection, pqxx::work& transaction, uint32_t bot_id, std::string reason) {
+void disable_player(pqxx::work& transaction, uint32_t bot_id, std::string reason) {
     std::cerr << "Disabling: " << bot_id << " For reason: \n" << reason;
-    connection.prepare("UPDATE vijf_bots SET enabled = FALSE, state = $2 WHERE bot_id = $1");
-    transaction.exec_prepared("", bot_id, reason);
+    transaction.exec_prepared(vijf_disable_bot.name, bot_id, reason);
 }
 
-bool write_game_to_database(pqxx::connection& connection, pqxx::work& transaction, CompleteGameResult full_result)
+bool write_game_to_database(pqxx::work& transaction, CompleteGameResult full_result)
 {
     auto& result = full_result.result;
     auto& start_string = full_result.start_string;
@@ -241,14 +258,14 @@ bool write_game_to_database(pqxx::connection& connection, pqxx::work& transactio
 
     if (result.type == Vijf::Results::Type::PlayerMisbehaved) {
         ASSERT(bot_ids[result.player].has_value());
-        disable_player(connection, transaction, bot_ids[result.player].value(), "Basic Made invalid move or gave incorrect command.\nFor game: " + start_string + " ; " + moves_string.str());
+        disable_player(transaction, bot_ids[result.player].value(), "Basic Made invalid move or gave incorrect command.\nFor game: " + start_string + " ; " + moves_string.str());
         any_failed = true;
     }
 
     for (int i = 0; i < Vijf::player_count; ++i) {
         if (Vijf::has_event<Vijf::EventType::ProcessPlayerMisbehaved>(result.events[i])) {
             ASSERT(bot_ids[i].has_value());
-            disable_player(connection, transaction, bot_ids[result.player].value(), "Event Made invalid move or gave incorrect command.\nFor game: " + start_string + " ; " + moves_string.str());
+            disable_player(transaction, bot_ids[result.player].value(), "Event Made invalid move or gave incorrect command.\nFor game: " + start_string + " ; " + moves_string.str());
             any_failed = true;
         }
     }
@@ -258,19 +275,15 @@ bool write_game_to_database(pqxx::connection& connection, pqxx::work& transactio
 
     ASSERT(result.type == Vijf::Results::Type::PlayerWon);
 
-    connection.prepare("INSERT INTO vijf_games (start_data, turn_data, rounds_played, moves_played) VALUES ($1, $2, $3, $4) RETURNING game_id");
-
-    auto game_id_row = transaction.exec_prepared1("", start_string, moves_string.str(), result.rounds_played, result.moves_made.size());
+    auto game_id_row = transaction.exec_prepared1(vijf_insert_game.name, start_string, moves_string.str(), result.rounds_played, result.moves_made.size());
 
     auto game_id = game_id_row[0].as<uint32_t>();
 
-    connection.prepare("INSERT INTO vijf_game_players (game_id, game_position, bot_id, instadied, game_result, events) VALUES ($1, $2, $3, $4, $5, $6)");
-
     for (int i = 0; i < Vijf::player_count; ++i) {
         if (!bot_ids[i].has_value())
             continue;
 
-        [[maybe_unused]] auto query_result = transaction.exec_prepared0("", game_id, i, bot_ids[i].value(), result.instadied[i], result.final_rank[i], static_cast<std::underlying_type_t<Vijf::EventType>>(result.events[i]));
+        [[maybe_unused]] auto query_result = transaction.exec_prepared0(vijf_insert_game_player.name, game_id, i, bot_ids[i].value(), result.instadied[i], result.final_rank[i], static_cast<std::underlying_type_t<Vijf::EventType>>(result.events[i]));
         ASSERT(query_result.affected_rows() == 1);
     }
 
@@ -295,7 +308,7 @@ void flush_results_to_database()
     ConnectionPool::run_on_temporary_connection([&](pqxx::connection& connection) {
         pqxx::work transaction{connection};
         for (auto& result : new_results)
-            write_game_to_database(connection, transaction, result);
+            write_game_to_database(transaction, result);
 
         transaction.commit();
     });
@@ -0,0 +1,73 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace util {
+
+// Hands out the cores of this machine to simulations, so a run (and the bot
+// it starts, processes inherit the affinity of the thread starting them) has
+// a core to itself. The remaining shared cores are for everything else like
+// the http server and building bots, they are pinned there by pin_to_shared().
+class CoreAllocator {
+public:
+    // Keeps shared_cores cores out of the runs, if there are not enough cores
+    // nothing is pinned and only a single run is admitted at a time.
+    explicit CoreAllocator(size_t shared_cores);
+
+    CoreAllocator(CoreAllocator const&) = delete;
+    CoreAllocator& operator=(CoreAllocator const&) = delete;
+
+    // Pins the calling thread to one core until destroyed, after which the
+    // thread is moved back to the shared cores.
+    class Reservation {
+    public:
+        Reservation(Reservation&& other) noexcept;
+        Reservation& operator=(Reservation&&) = delete;
+        Reservation(Reservation const&) = delete;
+        Reservation& operator=(Reservation const&) = delete;
+        ~Reservation();
+
+        // Nothing if this machine has too few cores to pin anything.
+        [[nodiscard]] std::optional<size_t> core() const { return m_core; }
+
+    private:
+        friend class CoreAllocator;
+        Reservation(CoreAllocator* allocator, size_t index, std::optional<size_t> core);
+
+        CoreAllocator* m_allocator;
+        size_t m_index;
+        std::optional<size_t> m_core;
+    };
+
+    std::optional<Reservation> try_acquire();
+    Reservation acquire();
+
+    // How many runs can go at the same time.
+    [[nodiscard]] size_t capacity() const { return m_in_use.size(); }
+    [[nodiscard]] size_t available() const;
+
+    [[nodiscard]] std::vector<size_t> const& shared_cores() const { return m_shared_cores; }
+    void pin_to_shared() const;
+
+    // The core reserved by the calling thread, if any.
+    static std::optional<size_t> reserved_core_of_this_thread();
+
+    static std::vector<size_t> usable_cores();
+    static bool pin_current_thread(std::vector<size_t> const& cores);
+
+private:
+    Reservation reserve(size_t index);
+    void release(size_t index);
+
+    std::vector<size_t> m_run_cores;
+    std::vector<size_t> m_shared_cores;
+    std::vector<bool> m_in_use;
+
+    mutable std::mutex m_lock;
+    std::condition_variable m_released;
+};
+
+}
@@ -0,0 +1,121 @@
+#include "CoreAllocator.h"
+#include "Assertions.h"
+#include <algorithm>
+#include <iostream>
+
+namespace util {
+
+static thread_local std::optional<size_t> s_reserved_core;
+
+CoreAllocator::CoreAllocator(size_t shared_cores)
+{
+    auto cores = usable_cores();
+    if (cores.size() <= shared_cores || cores.size() < 2) {
+        std::cerr << "Only " << cores.size() << " cores available, running one simulation at a time without pinning\n";
+        m_shared_cores = std::move(cores);
+        m_in_use.resize(1, false);
+        return;
+    }
+
+    // Without any shared cores the other work just has to squeeze in between the runs.
+    if (shared_cores == 0)
+        m_shared_cores = cores;
+    else
+        m_shared_cores.assign(cores.begin(), cores.begin() + static_cast<ptrdiff_t>(shared_cores));
+
+    m_run_cores.assign(cores.begin() + static_cast<ptrdiff_t>(shared_cores), cores.end());
+    m_in_use.resize(m_run_cores.size(), false);
+}
+
+size_t CoreAllocator::available() const
+{
+    std::lock_guard lock(m_lock);
+    return std::count(m_in_use.begin(), m_in_use.end(), false);
+}
+
+std::optional<CoreAllocator::Reservation> CoreAllocator::try_acquire()
+{
+    std::unique_lock lock(m_lock);
+    auto free = std::find(m_in_use.begin(), m_in_use.end(), false);
+    if (free == m_in_use.end())
+        return std::nullopt;
+    *free = true;
+    lock.unlock();
+    return reserve(free - m_in_use.begin());
+}
+
+CoreAllocator::Reservation CoreAllocator::acquire()
+{
+    std::unique_lock lock(m_lock);
+    std::vector<bool>::iterator free;
+    m_released.wait(lock, [&] {
+        free = std::find(m_in_use.begin(), m_in_use.end(), false);
+        return free != m_in_use.end();
+    });
+    *free = true;
+    lock.unlock();
+    return reserve(free - m_in_use.begin());
+}
+
+CoreAllocator::Reservation CoreAllocator::reserve(size_t index)
+{
+    std::optional<size_t> core;
+    if (!m_run_cores.empty()) {
+        core = m_run_cores[index];
+        // Running unpinned is better than not running at all.
+        if (!pin_current_thread({ *core }))
+            std::cerr << "Failed to pin to core " << *core << '\n';
+    }
+    ASSERT(!s_reserved_core.has_value());
+    s_reserved_core = core;
+    return Reservation { this, index, core };
+}
+
+void CoreAllocator::release(size_t index)
+{
+    s_reserved_core.reset();
+    if (!m_run_cores.empty())
+        pin_to_shared();
+
+    {
+        std::lock_guard lock(m_lock);
+        ASSERT(m_in_use[index]);
+        m_in_use[index] = false;
+    }
+    m_released.notify_one();
+}
+
+void CoreAllocator::pin_to_shared() const
+{
+    if (!pin_current_thread(m_shared_cores))
+        std::cerr << "Failed to pin to the shared cores\n";
+}
+
+std::optional<size_t> CoreAllocator::reserved_core_of_this_thread()
+{
+    return s_reserved_core;
+}
+
+CoreAllocator::Reservation::Reservation(CoreAllocator* allocator, size_t index, std::optional<size_t> core)
+    : m_allocator(allocator)
+    , m_index(index)
+    , m_core(core)
+{
+}
+
+CoreAllocator::Reservation::Reservation(Reservation&& other) noexcept
+    : m_allocator(other.m_allocator)
+    , m_index(other.m_index)
+    , m_core(other.m_core)
+{
+    other.m_allocator = nullptr;
+}
+
+CoreAllocator::Reservation::~Reservation()
+{
+    // The pinning belongs to a thread, so this must be destroyed on the thread that acquired it.
+    if (m_allocator)
+        m_allocator->release(m_index);
+}
+
+}
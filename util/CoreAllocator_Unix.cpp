@@ -0,0 +1,66 @@
+#include "CoreAllocator.h"
+#include <thread>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace util {
+
+#ifdef __linux__
+
+std::vector<size_t> CoreAllocator::usable_cores()
+{
+    // Only the cores we are allowed on (e.g. within a container), not every core of the machine.
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    std::vector<size_t> cores;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        perror("sched_getaffinity");
+        cores.push_back(0);
+        return cores;
+    }
+
+    for (size_t core = 0; core < CPU_SETSIZE; ++core) {
+        if (CPU_ISSET(core, &set))
+            cores.push_back(core);
+    }
+    return cores;
+}
+
+bool CoreAllocator::pin_current_thread(std::vector<size_t> const& cores)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto core : cores) {
+        if (core < CPU_SETSIZE)
+            CPU_SET(core, &set);
+    }
+    // On linux pid 0 is the calling thread, not the whole process.
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        perror("sched_setaffinity");
+        return false;
+    }
+    return true;
+}
+
+#else
+
+std::vector<size_t> CoreAllocator::usable_cores()
+{
+    std::vector<size_t> cores;
+    for (size_t core = 0; core < std::max(1u, std::thread::hardware_concurrency()); ++core)
+        cores.push_back(core);
+    return cores;
+}
+
+bool CoreAllocator::pin_current_thread(std::vector<size_t> const&)
+{
+    // There is no way to pin threads on macOS, it only takes hints.
+    return true;
+}
+
+#endif
+
+}
@@ -0,0 +1,40 @@
+#include "CoreAllocator.h"
+#pragma warning(push, 0)
+#define NOMINMAX
+#include <windows.h>
+#undef NOMINMAX
+#pragma warning(pop)
+
+namespace util {
+
+std::vector<size_t> CoreAllocator::usable_cores()
+{
+    // Only the first processor group, which is all we can pin to with a single mask.
+    DWORD_PTR process_mask = 0;
+    DWORD_PTR system_mask = 0;
+    std::vector<size_t> cores;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask) || process_mask == 0) {
+        cores.push_back(0);
+        return cores;
+    }
+
+    for (size_t core = 0; core < sizeof(DWORD_PTR) * 8; ++core) {
+        if (process_mask & (DWORD_PTR(1) << core))
+            cores.push_back(core);
+    }
+    return cores;
+}
+
+// Processes get the affinity of our process and not of the thread starting
+// them, so on windows only the simulation itself is pinned and not the bot.
+bool CoreAllocator::pin_current_thread(std::vector<size_t> const& cores)
+{
+    DWORD_PTR mask = 0;
+    for (auto core : cores) {
+        if (core < sizeof(DWORD_PTR) * 8)
+            mask |= DWORD_PTR(1) << core;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+}
+
+}
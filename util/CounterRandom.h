@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <span>
+
+namespace util {
+
+// Counter based random numbers: the n-th number only depends on the seed and n.
+// Any block of numbers can be generated on its own, in any order or on any thread,
+// and filling a block is a plain loop without dependencies which compilers vectorize.
+class CounterRandom {
+public:
+    explicit CounterRandom(uint64_t seed)
+    {
+        // Spread small consecutive seeds over both halves of the key.
+        seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ull;
+        seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebull;
+        seed ^= seed >> 31;
+        m_key_low = static_cast<uint32_t>(seed);
+        m_key_high = static_cast<uint32_t>(seed >> 32);
+    }
+
+    [[nodiscard]] uint32_t at(uint64_t counter) const
+    {
+        return mix(mix(static_cast<uint32_t>(counter) ^ m_key_low) ^ static_cast<uint32_t>(counter >> 32) ^ m_key_high);
+    }
+
+    void fill(uint64_t first_counter, std::span<uint32_t> values) const
+    {
+        for (size_t i = 0; i < values.size(); ++i)
+            values[i] = at(first_counter + i);
+    }
+
+    // Maps a random value to [0, bound) by multiplication, bound must be positive.
+    [[nodiscard]] static uint32_t bounded(uint32_t value, uint32_t bound)
+    {
+        return static_cast<uint32_t>((static_cast<uint64_t>(value) * bound) >> 32);
+    }
+
+    // Maps a random value to [0, 1).
+    [[nodiscard]] static double unit(uint32_t value)
+    {
+        return static_cast<double>(value) * 0x1p-32;
+    }
+
+private:
+    // lowbias32 integer hash by Chris Wellons.
+    static uint32_t mix(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    uint32_t m_key_low;
+    uint32_t m_key_high;
+};
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+
+#ifdef POSIX_PROCESS
+#elif defined(WINDOWS_PROCESS)
+#pragma warning(push, 0)
+#    define NOMINMAX
+#    include <windows.h>
+#    undef NOMINMAX
+#    pragma warning(pop)
+#else
+#error Must define one of POSIX_PROCESS or WINDOWS_PROCESS
+#endif
+
+namespace util {
+
+// A read only view of a whole file, mapped into memory instead of read.
+class MappedFile {
+public:
+    static std::unique_ptr<MappedFile> open(std::string const& path);
+
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    [[nodiscard]] std::span<std::byte const> bytes() const { return { m_data, m_size }; }
+    [[nodiscard]] size_t size() const { return m_size; }
+
+private:
+    static bool setup(MappedFile& file, std::string const& path);
+
+    std::byte const* m_data { nullptr };
+    size_t m_size { 0 };
+
+#ifdef POSIX_PROCESS
+#elif WINDOWS_PROCESS
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#else
+#error Must be one of posix of windows
+#endif
+};
+
+}
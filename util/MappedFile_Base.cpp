@@ -0,0 +1,14 @@
+#include "MappedFile.h"
+
+namespace util {
+
+std::unique_ptr<MappedFile> MappedFile::open(std::string const& path)
+{
+    auto file = std::make_unique<MappedFile>();
+    auto passed = setup(*file, path);
+    if (!passed)
+        return nullptr;
+    return file;
+}
+
+}
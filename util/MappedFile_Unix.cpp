@@ -0,0 +1,46 @@
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace util {
+
+bool MappedFile::setup(MappedFile& file, std::string const& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+        close(fd);
+        return false;
+    }
+
+    file.m_size = static_cast<size_t>(file_stat.st_size);
+    // Mapping zero bytes is not allowed, an empty span is just as good.
+    if (file.m_size == 0) {
+        close(fd);
+        return true;
+    }
+
+    void* data = mmap(nullptr, file.m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file.
+    close(fd);
+    if (data == MAP_FAILED) {
+        file.m_size = 0;
+        return false;
+    }
+
+    file.m_data = static_cast<std::byte const*>(data);
+    return true;
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data)
+        munmap(const_cast<std::byte*>(m_data), m_size);
+}
+
+}
@@ -0,0 +1,38 @@
+#include "MappedFile.h"
+
+namespace util {
+
+bool MappedFile::setup(MappedFile& file, std::string const& path)
+{
+    file.m_file = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file.m_file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file.m_file, &size))
+        return false;
+
+    file.m_size = static_cast<size_t>(size.QuadPart);
+    // Mapping zero bytes is not allowed, an empty span is just as good.
+    if (file.m_size == 0)
+        return true;
+
+    file.m_mapping = CreateFileMapping(file.m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!file.m_mapping)
+        return false;
+
+    file.m_data = static_cast<std::byte const*>(MapViewOfFile(file.m_mapping, FILE_MAP_READ, 0, 0, 0));
+    return file.m_data != nullptr;
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+}
+
+}
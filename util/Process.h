@@ -17,6 +17,8 @@
 
 namespace util {
 
+    class Zygote;
+
     class SubProcess {
     public:
         constexpr static uint32_t BufferSize = 4096;
@@ -39,23 +41,77 @@ namespace util {
 
         static std::unique_ptr<SubProcess> create(std::vector<std::string> command, StderrState state = StderrState::Ignored, std::string const& working_directory = "");
 
+        // The command runs as pid 1 of its own user, mount, pid, network, ipc
+        // and uts namespaces, so it has no network and sees none of our processes.
+        // The root directory (e.g. an exported container image) is mounted read only
+        // as its root, with a fresh /proc, /tmp and a minimal /dev if those exist in it.
+        // A seccomp filter blocks the syscalls a bot never needs, like creating namespaces.
+        struct Sandbox {
+            std::string root_directory;
+            // Existing cgroup v2 directory with the memory, cpu and pids controllers
+            // enabled for its children. Every process gets its own child cgroup with
+            // the limits below. When empty the memory and process limits are applied as
+            // rlimits, and instead of cpu_percent each process may use max_cpu_seconds.
+            // The process rlimit counts per user, which is only per sandbox on linux 5.14 and up.
+            std::string cgroup_parent;
+            uint64_t memory_limit_bytes = 256ull * 1024 * 1024;
+            uint32_t cpu_percent = 100;
+            uint32_t max_processes = 64;
+            uint32_t max_cpu_seconds = 600;
+        };
+
+        // The command must be an absolute path inside the sandbox, only supported on linux.
+        static std::unique_ptr<SubProcess> create_sandboxed(std::vector<std::string> command, Sandbox const& sandbox, StderrState state = StderrState::Ignored);
+
         bool writeTo(std::string_view) const;
         bool readLine(std::string&) const;
 
 
         std::optional<std::string> sendAndWaitForResponse(std::string_view message, size_t milliseconds, size_t* outTiming= nullptr);
 
+        // Like sendAndWaitForResponse but the limit is on the cpu time the process
+        // spends on the response, so a busy machine does not make it fail. The wall
+        // clock limit still stops processes which wait forever. Without a way to
+        // measure cpu time (see cpu_time_microseconds) the cpu limit is a wall clock limit.
+        std::optional<std::string> sendAndWaitForResponseWithCpuLimit(std::string_view message, size_t cpu_milliseconds, size_t wall_milliseconds, size_t* outCpuTiming = nullptr);
+
+        // Cpu time used so far. Sandboxed processes are only measured through their cgroup,
+        // which includes all their children. Without one this is empty for them, as the
+        // process itself could hand its work to children.
+        std::optional<uint64_t> cpu_time_microseconds() const;
+
         bool writeToWithTimeout(std::string_view, size_t milliseconds) const;
         bool readLineWithTimeout(std::string& line, size_t milliseconds) const;
 
+        struct ResourceUsage {
+            uint64_t user_microseconds = 0;
+            uint64_t system_microseconds = 0;
+            uint64_t peak_memory_kilobytes = 0;
+            uint64_t voluntary_context_switches = 0;
+            uint64_t involuntary_context_switches = 0;
+
+            [[nodiscard]] uint64_t cpu_microseconds() const { return user_microseconds + system_microseconds; }
+        };
+
         struct ProcessExit {
             bool stopped = false;
             std::optional<int> exitCode;
+            // Only known once the process has been waited for.
+            std::optional<ResourceUsage> usage;
         };
 
         ProcessExit stop();
     private:
-        static bool setup(SubProcess& process, std::vector<std::string> command, StderrState state, std::string const& working_directory);
+        friend class Zygote;
+
+        // With socket_io the child's stdin and stdout are one unix socket instead of two pipes.
+        static bool setup(SubProcess& process, std::vector<std::string> command, StderrState state, std::string const& working_directory, bool socket_io = false);
+        // A zygote also gets a socket for stdin and stdout, and may isolate its children itself (see Zygote.h).
+        static bool setup_sandboxed(SubProcess& process, std::vector<std::string> command, Sandbox const& sandbox, StderrState state, bool zygote = false);
+        static bool create_sandbox_cgroup(std::string const& cgroup, Sandbox const& sandbox);
+        static std::optional<uint64_t> cgroup_cpu_microseconds(std::string const& cgroup);
+        // Replaces the cpu times (and peak memory if known) with those of the whole cgroup.
+        static void add_cgroup_usage(std::string const& cgroup, ResourceUsage& usage);
 
         mutable bool running = false;
 
@@ -70,9 +126,19 @@ namespace util {
         int m_std_out = -1;
 
         std::optional<int> m_exitCode;
+        std::optional<ResourceUsage> m_usage;
 
         StderrState m_stderr_state = StderrState::Ignored;
 
+        // Pid 1 of a pid namespace ignores signals it has no handler for.
+        bool m_sandboxed = false;
+        std::string m_cgroup;
+
+        // Set for processes spawned by a zygote, they are not our children so
+        // their exit is reported over this socket (see Zygote.h).
+        int m_lifetime = -1;
+        ProcessExit stop_spawned();
+
 #elif defined(WINDOWS_PROCESS)
         HANDLE m_childProc { nullptr };
 
@@ -40,4 +40,12 @@ namespace util {
             return nullptr;
         return process;
     }
+
+    std::unique_ptr<SubProcess> SubProcess::create_sandboxed(std::vector<std::string> command, Sandbox const& sandbox, StderrState state) {
+        auto process = std::make_unique<SubProcess>();
+        auto passed = setup_sandboxed(*process, std::move(command), sandbox, state);
+        if (!passed)
+            return nullptr;
+        return process;
+    }
 }
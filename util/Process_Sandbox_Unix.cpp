@@ -0,0 +1,646 @@
+#include "Process.h"
+#include "Assertions.h"
+
+#ifndef POSIX_PROCESS
+#error Only for posix process handling
+#endif
+
+#include <iostream>
+#include <string>
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <grp.h>
+#include <linux/audit.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <sched.h>
+#include <sys/mount.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if defined(__x86_64__)
+#define SANDBOX_AUDIT_ARCH AUDIT_ARCH_X86_64
+#elif defined(__aarch64__)
+#define SANDBOX_AUDIT_ARCH AUDIT_ARCH_AARCH64
+#endif
+
+namespace util {
+
+    constexpr int pipeRead = 0;
+    constexpr int pipeWrite = 1;
+    constexpr int maxCommandSize = 64;
+    constexpr size_t childStackSize = 256 * 1024;
+    constexpr uid_t sandboxId = 1000;
+
+    // Everything the child needs is prepared before cloning, after the clone
+    // the child only makes system calls (the other threads of this process
+    // might hold the allocator lock in the copy the child got).
+    struct SandboxChild {
+        char* args[maxCommandSize];
+        char const* env[4];
+
+        std::string child_filter;
+        std::string root;
+        std::string proc;
+        std::string tmp;
+        std::string dev;
+        std::string devices[4][2];
+        size_t device_count = 0;
+
+        bool has_proc = false;
+        bool has_tmp = false;
+        bool has_dev = false;
+        bool drop_groups = false;
+
+        int std_in = -1;
+        int std_out = -1;
+        int std_err = -1;
+        int dev_null = -1;
+        int sync_read = -1;
+        int error_write = -1;
+
+        // Only set without a cgroup, then these limits apply to the processes instead.
+        uint64_t memory_rlimit = 0;
+        rlim_t process_rlimit = 0;
+        rlim_t cpu_seconds_rlimit = 0;
+
+        sock_fprog* filter = nullptr;
+    };
+
+    // What the child reports back if it fails before exec, nothing is written on success.
+    struct SandboxError {
+        int step;
+        int error;
+    };
+
+    [[noreturn]] static void child_failed(SandboxChild const& child, int step)
+    {
+        SandboxError error { step, errno };
+        [[maybe_unused]] auto written = write(child.error_write, &error, sizeof(error));
+        _exit(127);
+    }
+
+    // Closes every descriptor above stderr except keep.
+    static void close_other_descriptors(int keep)
+    {
+        int first = STDERR_FILENO + 1;
+#ifdef SYS_close_range
+        // Needs linux 5.9, older kernels get the loop below.
+        bool closed = keep < first
+            ? syscall(SYS_close_range, first, ~0U, 0) == 0
+            : (keep == first || syscall(SYS_close_range, first, keep - 1, 0) == 0) && syscall(SYS_close_range, keep + 1, ~0U, 0) == 0;
+        if (closed)
+            return;
+#endif
+        struct rlimit files {};
+        rlim_t max_fd = 1024;
+        if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur != RLIM_INFINITY)
+            max_fd = std::min<rlim_t>(files.rlim_cur, 65536);
+        for (int fd = first; fd < static_cast<int>(max_fd); ++fd) {
+            if (fd != keep)
+                close(fd);
+        }
+    }
+
+    static unsigned long locked_mount_flags(char const* path)
+    {
+        // Remounting in a user namespace must keep the flags of the mount we got.
+        struct statvfs stats {};
+        if (statvfs(path, &stats) < 0)
+            return 0;
+
+        unsigned long flags = 0;
+        if (stats.f_flag & ST_NOSUID)
+            flags |= MS_NOSUID;
+        if (stats.f_flag & ST_NODEV)
+            flags |= MS_NODEV;
+        if (stats.f_flag & ST_NOEXEC)
+            flags |= MS_NOEXEC;
+        if (stats.f_flag & ST_NOATIME)
+            flags |= MS_NOATIME;
+        if (stats.f_flag & ST_NODIRATIME)
+            flags |= MS_NODIRATIME;
+        if (stats.f_flag & ST_RELATIME)
+            flags |= MS_RELATIME;
+        return flags;
+    }
+
+    static int run_sandbox_child(void* data)
+    {
+        auto& child = *static_cast<SandboxChild*>(data);
+
+        // Wait until the parent has set up our user mapping and cgroup.
+        char go = 0;
+        if (read(child.sync_read, &go, 1) != 1)
+            child_failed(child, 0);
+
+        // Become the only mapped user, this keeps our capabilities inside the
+        // namespace until exec (as the user is not root there).
+        if (child.drop_groups && setgroups(0, nullptr) < 0)
+            child_failed(child, 13);
+
+        if (setresgid(sandboxId, sandboxId, sandboxId) < 0 || setresuid(sandboxId, sandboxId, sandboxId) < 0)
+            child_failed(child, 13);
+
+        if (mount(nullptr, "/", nullptr, MS_REC | MS_PRIVATE, nullptr) < 0)
+            child_failed(child, 1);
+
+        if (mount(child.root.c_str(), child.root.c_str(), nullptr, MS_BIND | MS_REC, nullptr) < 0)
+            child_failed(child, 2);
+
+        // The extra mounts are a convenience for the bot, not a requirement.
+        if (child.has_proc)
+            mount("proc", child.proc.c_str(), "proc", MS_NOSUID | MS_NODEV | MS_NOEXEC, nullptr);
+
+        if (child.has_tmp)
+            mount("tmpfs", child.tmp.c_str(), "tmpfs", MS_NOSUID | MS_NODEV, "size=64m,mode=1777");
+
+        if (child.has_dev && mount("tmpfs", child.dev.c_str(), "tmpfs", MS_NOSUID | MS_NOEXEC, "size=64k,mode=755") == 0) {
+            for (size_t i = 0; i < child.device_count; ++i) {
+                int fd = open(child.devices[i][1].c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0666);
+                if (fd < 0)
+                    continue;
+                close(fd);
+                mount(child.devices[i][0].c_str(), child.devices[i][1].c_str(), nullptr, MS_BIND, nullptr);
+            }
+        }
+
+        if (mount(nullptr, child.root.c_str(), nullptr, MS_REMOUNT | MS_BIND | MS_RDONLY | locked_mount_flags(child.root.c_str()), nullptr) < 0)
+            child_failed(child, 3);
+
+        if (chdir(child.root.c_str()) < 0)
+            child_failed(child, 4);
+
+        // Stack the old root below the new one and detach it.
+        if (syscall(SYS_pivot_root, ".", ".") < 0)
+            child_failed(child, 5);
+
+        if (umount2(".", MNT_DETACH) < 0)
+            child_failed(child, 6);
+
+        if (chdir("/") < 0)
+            child_failed(child, 7);
+
+        if (dup2(child.std_in, STDIN_FILENO) < 0 || dup2(child.std_out, STDOUT_FILENO) < 0)
+            child_failed(child, 8);
+
+        if (child.std_err >= 0 && dup2(child.std_err, STDERR_FILENO) < 0)
+            child_failed(child, 8);
+
+        // Nothing else of ours (database connections, other bots) may leak in.
+        close_other_descriptors(child.error_write);
+
+        struct rlimit no_core { 0, 0 };
+        setrlimit(RLIMIT_CORE, &no_core);
+
+        if (child.memory_rlimit != 0) {
+            struct rlimit memory { child.memory_rlimit, child.memory_rlimit };
+            struct rlimit processes { child.process_rlimit, child.process_rlimit };
+            struct rlimit cpu { child.cpu_seconds_rlimit, child.cpu_seconds_rlimit };
+            if (setrlimit(RLIMIT_AS, &memory) < 0 || setrlimit(RLIMIT_NPROC, &processes) < 0 || setrlimit(RLIMIT_CPU, &cpu) < 0)
+                child_failed(child, 9);
+        }
+
+        if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) < 0)
+            child_failed(child, 10);
+
+        if (child.filter && prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, child.filter) < 0)
+            child_failed(child, 11);
+
+        execve(child.args[0], child.args, const_cast<char* const*>(child.env));
+        child_failed(child, 12);
+    }
+
+    static char const* describe_step(int step)
+    {
+        switch (step) {
+        case 0:
+            return "waiting for parent";
+        case 1:
+        case 2:
+        case 3:
+            return "mounting root";
+        case 4:
+        case 5:
+        case 6:
+        case 7:
+            return "switching root";
+        case 8:
+            return "redirecting output";
+        case 9:
+            return "setting resource limits";
+        case 10:
+        case 11:
+            return "installing seccomp filter";
+        case 12:
+            return "executing command";
+        case 13:
+            return "switching user";
+        default:
+            return "unknown";
+        }
+    }
+
+    // A zygote may still unshare and mount, it gives each child its own namespaces
+    // and /tmp. The children install the full bot filter before running bot code.
+    static std::vector<sock_filter> build_sandbox_filter(bool zygote)
+    {
+        std::vector<sock_filter> instructions;
+
+#ifdef SANDBOX_AUDIT_ARCH
+        // Bots have no business with (un)mounting, namespaces, tracing, kernel modules or keys.
+        static constexpr int denied[] = {
+            SYS_ptrace, SYS_mount, SYS_umount2, SYS_pivot_root, SYS_chroot,
+            SYS_unshare, SYS_setns, SYS_kexec_load, SYS_init_module,
+            SYS_finit_module, SYS_delete_module, SYS_bpf, SYS_perf_event_open,
+            SYS_keyctl, SYS_add_key, SYS_request_key, SYS_reboot, SYS_swapon,
+            SYS_swapoff, SYS_process_vm_readv, SYS_process_vm_writev,
+            SYS_userfaultfd, SYS_open_by_handle_at, SYS_name_to_handle_at,
+            SYS_acct, SYS_quotactl, SYS_settimeofday, SYS_clock_settime,
+            SYS_adjtimex, SYS_sethostname, SYS_setdomainname,
+        };
+
+        instructions.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, arch)));
+        instructions.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SANDBOX_AUDIT_ARCH, 1, 0));
+        instructions.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_KILL_PROCESS));
+        instructions.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, nr)));
+#if defined(__x86_64__)
+        // The x32 abi numbers the same calls differently.
+        instructions.push_back(BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, 0x40000000, 0, 1));
+        instructions.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_KILL_PROCESS));
+#endif
+        for (auto syscall_number : denied) {
+            if (zygote && (syscall_number == SYS_unshare || syscall_number == SYS_mount))
+                continue;
+            instructions.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(syscall_number), 0, 1));
+            instructions.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | EPERM));
+        }
+
+#ifdef SYS_clone3
+        // Its flags are behind a pointer which a filter cannot follow. Libc falls
+        // back to clone when it is missing, so it looks like an older kernel.
+        instructions.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SYS_clone3, 0, 1));
+        instructions.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | ENOSYS));
+#endif
+
+        // Threads and processes are fine, new namespaces are not. The flags are the
+        // first argument, all CLONE_NEW* fit in its lower half (first on little endian).
+        static_assert(std::endian::native == std::endian::little);
+        constexpr uint32_t namespace_flags = CLONE_NEWNS | CLONE_NEWCGROUP | CLONE_NEWUTS | CLONE_NEWIPC | CLONE_NEWUSER | CLONE_NEWPID | CLONE_NEWNET;
+        instructions.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SYS_clone, 0, 3));
+        instructions.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, args[0])));
+        instructions.push_back(BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, namespace_flags, 0, 1));
+        instructions.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | EPERM));
+        instructions.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW));
+#endif
+
+        return instructions;
+    }
+
+    static std::vector<sock_filter> const& sandbox_filter()
+    {
+        static std::vector<sock_filter> filter = build_sandbox_filter(false);
+        return filter;
+    }
+
+    static std::vector<sock_filter> const& zygote_filter()
+    {
+        static std::vector<sock_filter> filter = build_sandbox_filter(true);
+        return filter;
+    }
+
+    // The raw bytes of the filter in hex, for a zygote to install in its children.
+    static std::string filter_as_hex(std::vector<sock_filter> const& filter)
+    {
+        static constexpr char digits[] = "0123456789abcdef";
+        auto const* bytes = reinterpret_cast<unsigned char const*>(filter.data());
+        std::string hex;
+        hex.reserve(filter.size() * sizeof(sock_filter) * 2);
+        for (size_t i = 0; i < filter.size() * sizeof(sock_filter); ++i) {
+            hex += digits[bytes[i] >> 4];
+            hex += digits[bytes[i] & 0xf];
+        }
+        return hex;
+    }
+
+    static bool write_file(std::string const& path, std::string const& content)
+    {
+        int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0) {
+            perror(path.c_str());
+            return false;
+        }
+        auto written = write(fd, content.data(), content.size());
+        if (written != static_cast<ssize_t>(content.size())) {
+            perror(path.c_str());
+            close(fd);
+            return false;
+        }
+        close(fd);
+        return true;
+    }
+
+    static bool is_directory(std::string const& path)
+    {
+        struct stat info {};
+        return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+    }
+
+    bool SubProcess::create_sandbox_cgroup(std::string const& cgroup, Sandbox const& sandbox)
+    {
+        if (mkdir(cgroup.c_str(), 0755) < 0) {
+            perror(cgroup.c_str());
+            return false;
+        }
+
+        constexpr uint32_t cpu_period = 100000;
+        return write_file(cgroup + "/memory.max", std::to_string(sandbox.memory_limit_bytes))
+            && write_file(cgroup + "/memory.swap.max", "0")
+            && write_file(cgroup + "/cpu.max", std::to_string(cpu_period / 100 * sandbox.cpu_percent) + ' ' + std::to_string(cpu_period))
+            && write_file(cgroup + "/pids.max", std::to_string(sandbox.max_processes));
+    }
+
+    // Reads "<key> <value>" lines, or the single value of the file if key is empty.
+    static std::optional<uint64_t> read_cgroup_value(std::string const& path, std::string_view key)
+    {
+        std::ifstream file(path);
+        std::string name;
+        uint64_t value;
+        if (key.empty()) {
+            if (file >> value)
+                return value;
+            return std::nullopt;
+        }
+        while (file >> name >> value) {
+            if (name == key)
+                return value;
+        }
+        return std::nullopt;
+    }
+
+    std::optional<uint64_t> SubProcess::cgroup_cpu_microseconds(std::string const& cgroup)
+    {
+        return read_cgroup_value(cgroup + "/cpu.stat", "usage_usec");
+    }
+
+    void SubProcess::add_cgroup_usage(std::string const& cgroup, ResourceUsage& usage)
+    {
+        auto user = read_cgroup_value(cgroup + "/cpu.stat", "user_usec");
+        auto system = read_cgroup_value(cgroup + "/cpu.stat", "system_usec");
+        if (user.has_value() && system.has_value()) {
+            usage.user_microseconds = *user;
+            usage.system_microseconds = *system;
+        }
+
+        // Only on newer kernels (5.19).
+        if (auto peak = read_cgroup_value(cgroup + "/memory.peak", ""); peak.has_value())
+            usage.peak_memory_kilobytes = *peak / 1024;
+    }
+
+    bool SubProcess::setup_sandboxed(SubProcess& process, std::vector<std::string> command, Sandbox const& sandbox, StderrState state, bool zygote) {
+        if (command.size() >= maxCommandSize || command.empty()) {
+            ASSERT_NOT_REACHED();
+            return false;
+        }
+
+        if (command[0].empty() || command[0][0] != '/') {
+            std::cerr << "Sandboxed command must be an absolute path, got: " << command[0] << '\n';
+            return false;
+        }
+
+        char resolved_root[PATH_MAX];
+        if (!realpath(sandbox.root_directory.c_str(), resolved_root) || !is_directory(resolved_root)) {
+            std::cerr << "Sandbox root " << sandbox.root_directory << " is not a directory\n";
+            return false;
+        }
+
+        SandboxChild child;
+        int i = 0;
+        for (auto& sv : command)
+            child.args[i++] = sv.data();
+        child.args[i] = nullptr;
+
+        child.env[0] = "PATH=/usr/local/sbin:/usr/local/bin:/usr/sbin:/usr/bin:/sbin:/bin";
+        child.env[1] = "HOME=/tmp";
+        child.env[2] = nullptr;
+        child.env[3] = nullptr;
+
+        child.root = resolved_root;
+        child.proc = child.root + "/proc";
+        child.tmp = child.root + "/tmp";
+        child.dev = child.root + "/dev";
+        child.has_proc = is_directory(child.proc);
+        child.has_tmp = is_directory(child.tmp);
+        child.has_dev = is_directory(child.dev);
+        for (auto device : { "null", "zero", "random", "urandom" }) {
+            child.devices[child.device_count][0] = std::string("/dev/") + device;
+            child.devices[child.device_count][1] = child.dev + '/' + device;
+            ++child.device_count;
+        }
+
+        if (sandbox.cgroup_parent.empty()) {
+            child.memory_rlimit = sandbox.memory_limit_bytes;
+            child.process_rlimit = sandbox.max_processes;
+            child.cpu_seconds_rlimit = sandbox.max_cpu_seconds;
+        }
+
+        auto& filter = zygote ? zygote_filter() : sandbox_filter();
+        sock_fprog filter_program { static_cast<unsigned short>(filter.size()), const_cast<sock_filter*>(filter.data()) };
+        if (!filter.empty())
+            child.filter = &filter_program;
+        if (zygote && !filter.empty()) {
+            child.child_filter = "ZYGOTE_CHILD_FILTER=" + filter_as_hex(sandbox_filter());
+            child.env[2] = child.child_filter.c_str();
+        }
+
+        // All our ends are close on exec so other children never inherit them.
+        int inPipe[2] = { -1, -1 };
+        int outPipe[2] = { -1, -1 };
+        int syncPipe[2] = { -1, -1 };
+        int errorPipe[2] = { -1, -1 };
+
+        auto close_all = [&] {
+            for (int* ends : { inPipe, outPipe, syncPipe, errorPipe }) {
+                for (int end : { pipeRead, pipeWrite }) {
+                    if (ends[end] >= 0)
+                        close(ends[end]);
+                    ends[end] = -1;
+                }
+            }
+            if (child.dev_null >= 0)
+                close(child.dev_null);
+            child.dev_null = -1;
+        };
+
+        if (zygote) {
+            int sockets[2] = { -1, -1 };
+            if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) < 0) {
+                perror("socketpair");
+                return false;
+            }
+            inPipe[pipeRead] = sockets[1];
+            inPipe[pipeWrite] = sockets[0];
+            outPipe[pipeRead] = fcntl(sockets[0], F_DUPFD_CLOEXEC, 0);
+            outPipe[pipeWrite] = fcntl(sockets[1], F_DUPFD_CLOEXEC, 0);
+            if (outPipe[pipeRead] < 0 || outPipe[pipeWrite] < 0) {
+                perror("fcntl");
+                close_all();
+                return false;
+            }
+        } else if (pipe2(inPipe, O_CLOEXEC) < 0 || pipe2(outPipe, O_CLOEXEC) < 0) {
+            perror("pipe2");
+            close_all();
+            return false;
+        }
+
+        if (pipe2(syncPipe, O_CLOEXEC) < 0 || pipe2(errorPipe, O_CLOEXEC) < 0) {
+            perror("pipe2");
+            close_all();
+            return false;
+        }
+
+        child.dev_null = open("/dev/null", O_RDWR | O_CLOEXEC);
+        if (child.dev_null < 0) {
+            perror("open");
+            close_all();
+            return false;
+        }
+
+        child.std_in = inPipe[pipeRead];
+        if (state == StderrState::Readable) {
+            child.std_out = child.dev_null;
+            child.std_err = outPipe[pipeWrite];
+        } else {
+            child.std_out = outPipe[pipeWrite];
+            child.std_err = state == StderrState::Ignored ? child.dev_null : -1;
+        }
+        child.drop_groups = getuid() == 0;
+        child.sync_read = syncPipe[pipeRead];
+        child.error_write = errorPipe[pipeWrite];
+
+        // Without CLONE_VM the child runs on its own copy of this stack.
+        auto stack = std::make_unique<char[]>(childStackSize);
+        int flags = CLONE_NEWUSER | CLONE_NEWNS | CLONE_NEWPID | CLONE_NEWNET | CLONE_NEWIPC | CLONE_NEWUTS | SIGCHLD;
+        pid_t pid = clone(run_sandbox_child, stack.get() + childStackSize, flags, &child);
+        if (pid < 0) {
+            perror("clone");
+            close_all();
+            return false;
+        }
+
+        auto abandon_child = [&] {
+            kill(pid, SIGKILL);
+            int status;
+            waitpid(pid, &status, 0);
+            close_all();
+        };
+
+        // The bot runs as a regular user inside, so it loses every capability on exec.
+        // Only root may map another user (nobody) and keep setgroups to drop its groups.
+        bool as_root = getuid() == 0;
+        uid_t outer_uid = as_root ? 65534 : getuid();
+        gid_t outer_gid = as_root ? 65534 : getgid();
+        auto proc_dir = "/proc/" + std::to_string(pid);
+        if ((!as_root && !write_file(proc_dir + "/setgroups", "deny"))
+            || !write_file(proc_dir + "/uid_map", std::to_string(sandboxId) + ' ' + std::to_string(outer_uid) + " 1")
+            || !write_file(proc_dir + "/gid_map", std::to_string(sandboxId) + ' ' + std::to_string(outer_gid) + " 1")) {
+            abandon_child();
+            return false;
+        }
+
+        std::string cgroup;
+        if (!sandbox.cgroup_parent.empty()) {
+            cgroup = sandbox.cgroup_parent + "/bot-" + std::to_string(pid);
+            if (!create_sandbox_cgroup(cgroup, sandbox) || !write_file(cgroup + "/cgroup.procs", std::to_string(pid))) {
+                abandon_child();
+                rmdir(cgroup.c_str());
+                return false;
+            }
+        }
+
+        char go = 1;
+        if (write(syncPipe[pipeWrite], &go, 1) != 1) {
+            perror("write");
+            abandon_child();
+            if (!cgroup.empty())
+                rmdir(cgroup.c_str());
+            return false;
+        }
+
+        // Our copy of the write end has to go, otherwise a successful exec never ends this read.
+        close(errorPipe[pipeWrite]);
+        errorPipe[pipeWrite] = -1;
+
+        SandboxError error {};
+        ssize_t error_size;
+        do {
+            error_size = read(errorPipe[pipeRead], &error, sizeof(error));
+        } while (error_size < 0 && errno == EINTR);
+
+        if (error_size != 0) {
+            if (error_size == sizeof(error))
+                std::cerr << "Sandbox failed while " << describe_step(error.step) << ": " << strerror(error.error) << '\n';
+            else
+                std::cerr << "Sandbox failed before starting " << command[0] << '\n';
+            abandon_child();
+            if (!cgroup.empty())
+                rmdir(cgroup.c_str());
+            return false;
+        }
+
+        process.m_procPid = pid;
+        process.m_std_in = inPipe[pipeWrite];
+        process.m_std_out = outPipe[pipeRead];
+        process.m_sandboxed = true;
+        process.m_cgroup = std::move(cgroup);
+        process.running = true;
+
+        inPipe[pipeWrite] = -1;
+        outPipe[pipeRead] = -1;
+        close_all();
+
+        return true;
+    }
+
+}
+
+#else
+
+namespace util {
+
+    bool SubProcess::setup_sandboxed(SubProcess&, std::vector<std::string>, Sandbox const&, StderrState, bool) {
+        std::cerr << "Sandboxed processes are only supported on linux\n";
+        return false;
+    }
+
+    bool SubProcess::create_sandbox_cgroup(std::string const&, Sandbox const&) {
+        return false;
+    }
+
+    std::optional<uint64_t> SubProcess::cgroup_cpu_microseconds(std::string const&) {
+        return std::nullopt;
+    }
+
+    void SubProcess::add_cgroup_usage(std::string const&, ResourceUsage&) {
+    }
+
+}
+
+#endif
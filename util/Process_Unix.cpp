@@ -12,10 +12,16 @@
 #include <iostream>
 #include <spawn.h>
 #include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <poll.h>
 #include <future>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
 
 #ifdef __APPLE__
 extern char **environ;
@@ -209,7 +215,28 @@ namespace util {
       return response;
     }
 
+    static SubProcess::ResourceUsage usage_from(struct rusage const& usage) {
+        auto microseconds = [](struct timeval const& time) {
+            return static_cast<uint64_t>(time.tv_sec) * 1000000 + static_cast<uint64_t>(time.tv_usec);
+        };
+
+        SubProcess::ResourceUsage result;
+        result.user_microseconds = microseconds(usage.ru_utime);
+        result.system_microseconds = microseconds(usage.ru_stime);
+#ifdef __APPLE__
+        result.peak_memory_kilobytes = static_cast<uint64_t>(usage.ru_maxrss) / 1024;
+#else
+        result.peak_memory_kilobytes = static_cast<uint64_t>(usage.ru_maxrss);
+#endif
+        result.voluntary_context_switches = static_cast<uint64_t>(usage.ru_nvcsw);
+        result.involuntary_context_switches = static_cast<uint64_t>(usage.ru_nivcsw);
+        return result;
+    }
+
     SubProcess::ProcessExit SubProcess::stop() {
+        if (m_lifetime >= 0)
+            return stop_spawned();
+
         if (running) {
             running = false;
 
@@ -221,13 +248,14 @@ namespace util {
             }
 
             int status;
+            struct rusage child_usage {};
 
             std::future<bool> processDied =
-                std::async(std::launch::async, [pid = m_procPid, &status]() {
+                std::async(std::launch::async, [pid = m_procPid, &status, &child_usage]() {
                     do {
-                        if (pid_t waited = waitpid(pid, &status, 0);
+                        if (pid_t waited = wait4(pid, &status, 0, &child_usage);
                             waited < 0) {
-                            perror("waitpid");
+                            perror("wait4");
                             return false;
                         }
                     } while (!(WIFEXITED(status) || WIFSIGNALED(status)));
@@ -242,24 +270,128 @@ namespace util {
               break;
             case std::future_status::timeout:
             case std::future_status::deferred:
-              if (kill(m_procPid, SIGTERM) < 0) {
+              // Killing pid 1 of the sandbox takes everything inside with it.
+              if (kill(m_procPid, m_sandboxed ? SIGKILL : SIGTERM) < 0) {
                 perror("kill");
               }
               break;
             }
 
+            // Going out of scope would wait for it as well.
+            if (processDied.get())
+                m_usage = usage_from(child_usage);
+
             close(m_std_out);
 
         }
 
-        return {true, m_exitCode};
+        if (!m_cgroup.empty()) {
+            // Only possible once the process is gone, which the wait above guarantees.
+            if (m_usage.has_value())
+                add_cgroup_usage(m_cgroup, *m_usage);
+            if (rmdir(m_cgroup.c_str()) < 0)
+                perror("rmdir");
+            m_cgroup.clear();
+        }
+
+        return {true, m_exitCode, m_usage};
+    }
+
+    std::optional<uint64_t> SubProcess::cpu_time_microseconds() const {
+        if (!running)
+            return m_usage.has_value() ? std::optional<uint64_t>(m_usage->cpu_microseconds()) : std::nullopt;
+
+        if (!m_cgroup.empty())
+            return cgroup_cpu_microseconds(m_cgroup);
+
+        // Only counts the process itself, a sandboxed bot gets the wall clock limit instead.
+        if (m_procPid <= 0 || m_sandboxed)
+            return std::nullopt;
+
+        // Fields 14 and 15 are user and system time in clock ticks, the name before them can contain spaces.
+        std::ifstream stat_file("/proc/" + std::to_string(m_procPid) + "/stat");
+        std::string stat;
+        if (!std::getline(stat_file, stat))
+            return std::nullopt;
+
+        auto name_end = stat.rfind(')');
+        if (name_end == std::string::npos)
+            return std::nullopt;
+
+        std::istringstream fields(stat.substr(name_end + 1));
+        std::string skipped;
+        for (int field = 3; field < 14; ++field)
+            fields >> skipped;
+
+        uint64_t user_ticks = 0;
+        uint64_t system_ticks = 0;
+        if (!(fields >> user_ticks >> system_ticks))
+            return std::nullopt;
+
+        static long const ticks_per_second = sysconf(_SC_CLK_TCK);
+        if (ticks_per_second <= 0)
+            return std::nullopt;
+        return (user_ticks + system_ticks) * 1000000 / static_cast<uint64_t>(ticks_per_second);
+    }
+
+    std::optional<std::string>
+    SubProcess::sendAndWaitForResponseWithCpuLimit(std::string_view message, size_t cpu_milliseconds,
+                                                   size_t wall_milliseconds, size_t* outCpuTiming) {
+      if (!running)
+        return std::nullopt;
+
+      auto cpu_start = cpu_time_microseconds();
+      if (!cpu_start.has_value())
+        return sendAndWaitForResponse(message, std::min(cpu_milliseconds, wall_milliseconds), outCpuTiming);
+
+      auto start_time = std::chrono::steady_clock::now();
+      auto millis_since = [](std::chrono::steady_clock::time_point since) {
+        return static_cast<size_t>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - since).count());
+      };
+
+      if (!writeToWithTimeout(message, wall_milliseconds)) {
+        std::cerr << "Failed to write " << message << '\n';
+        return std::nullopt;
+      }
+
+      std::string response;
+      size_t cpu_taken = 0;
+      while (true) {
+        size_t wall_taken = millis_since(start_time);
+        auto cpu_now = cpu_time_microseconds();
+        cpu_taken = cpu_now.has_value() ? (*cpu_now - *cpu_start) / 1000 : wall_taken;
+
+        if (cpu_taken >= cpu_milliseconds || wall_taken >= wall_milliseconds) {
+          std::cerr << "Failed to read in response to _" << message << "_ (cpu " << cpu_taken << "ms, wall " << wall_taken << "ms)\n";
+          return std::nullopt;
+        }
+
+        // A single threaded process cannot use more cpu time than this.
+        size_t wait = std::min(cpu_milliseconds - cpu_taken, wall_milliseconds - wall_taken);
+        auto wait_start = std::chrono::steady_clock::now();
+        if (readLineWithTimeout(response, wait))
+          break;
+
+        // Returning before the timeout means the output was closed.
+        if (millis_since(wait_start) < wait) {
+          std::cerr << "Failed to read in response to _" << message << "_\n";
+          return std::nullopt;
+        }
+      }
+
+      if (outCpuTiming) {
+        auto cpu_now = cpu_time_microseconds();
+        *outCpuTiming = cpu_now.has_value() ? (*cpu_now - *cpu_start) / 1000 : cpu_taken;
+      }
+
+      return response;
     }
 
     constexpr int pipeRead = 0;
     constexpr int pipeWrite = 1;
     constexpr int maxCommandSize = 64;
 
-    bool SubProcess::setup(SubProcess& process, std::vector<std::string> command, SubProcess::StderrState state, std::string const& working_directory) {
+    bool SubProcess::setup(SubProcess& process, std::vector<std::string> command, SubProcess::StderrState state, std::string const& working_directory, bool socket_io) {
         if (command.size() >= maxCommandSize || command.empty()) {
             ASSERT_NOT_REACHED();
             return false;
@@ -278,21 +410,40 @@ namespace util {
             return false;
         }
 
-        int inPipe[2] = {-1, -1};
-        if (pipe(inPipe) < 0) {
-            perror("pipe");
-            return false;
-        }
-
 #define CLOSE_PIPE(pipe) \
     close((pipe)[0]); \
     close((pipe)[1])
 
+        int inPipe[2] = {-1, -1};
         int outPipe[2] = {-1, -1};
-        if (pipe(outPipe) < 0) {
-            perror("pipe");
-            CLOSE_PIPE(inPipe);
-            return false;
+        if (socket_io) {
+            // Both directions over one socket, every end is duplicated so it can be closed like a pipe.
+            int sockets[2] = {-1, -1};
+            if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) < 0) {
+                perror("socketpair");
+                return false;
+            }
+            inPipe[pipeRead] = sockets[1];
+            inPipe[pipeWrite] = sockets[0];
+            outPipe[pipeRead] = fcntl(sockets[0], F_DUPFD_CLOEXEC, 0);
+            outPipe[pipeWrite] = fcntl(sockets[1], F_DUPFD_CLOEXEC, 0);
+            if (outPipe[pipeRead] < 0 || outPipe[pipeWrite] < 0) {
+                perror("fcntl");
+                CLOSE_PIPE(inPipe);
+                CLOSE_PIPE(outPipe);
+                return false;
+            }
+        } else {
+            if (pipe(inPipe) < 0) {
+                perror("pipe");
+                return false;
+            }
+
+            if (pipe(outPipe) < 0) {
+                perror("pipe");
+                CLOSE_PIPE(inPipe);
+                return false;
+            }
         }
 
         // Setup child operations
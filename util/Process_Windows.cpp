@@ -211,6 +211,23 @@ namespace util {
         return response;
     }
 
+    // User and kernel time in microseconds.
+    static std::optional<std::pair<uint64_t, uint64_t>> process_cpu_times(HANDLE process) {
+        FILETIME creation, exit, kernel, user;
+        if (!GetProcessTimes(process, &creation, &exit, &kernel, &user)) {
+            outputError("GetProcessTimes");
+            return std::nullopt;
+        }
+
+        auto microseconds = [](FILETIME const& time) {
+            ULARGE_INTEGER value;
+            value.LowPart = time.dwLowDateTime;
+            value.HighPart = time.dwHighDateTime;
+            return value.QuadPart / 10;
+        };
+        return std::pair { microseconds(user), microseconds(kernel) };
+    }
+
     SubProcess::ProcessExit SubProcess::stop() {
         if (running) {
             running = false;
@@ -252,16 +269,50 @@ namespace util {
                     break;
             }
 
+            if (exitState.stopped) {
+                if (auto cpu_times = process_cpu_times(m_childProc); cpu_times.has_value()) {
+                    ResourceUsage usage;
+                    usage.user_microseconds = cpu_times->first;
+                    usage.system_microseconds = cpu_times->second;
+                    exitState.usage = usage;
+                }
+            }
+
             CloseHandle(m_childProc);
             CloseHandle(m_event);
         }
         return exitState;
     }
 
+    std::optional<uint64_t> SubProcess::cpu_time_microseconds() const {
+        if (!running)
+            return exitState.usage.has_value() ? std::optional<uint64_t>(exitState.usage->cpu_microseconds()) : std::nullopt;
+
+        auto cpu_times = process_cpu_times(m_childProc);
+        if (!cpu_times.has_value())
+            return std::nullopt;
+        return cpu_times->first + cpu_times->second;
+    }
+
+    std::optional<std::string> SubProcess::sendAndWaitForResponseWithCpuLimit(std::string_view message, size_t cpu_milliseconds, size_t wall_milliseconds, size_t* outCpuTiming) {
+        // A timed out overlapped read cannot be continued, so this is only a wall clock limit.
+        // (std::min) as windows.h defines a min macro.
+        return sendAndWaitForResponse(message, (std::min)(cpu_milliseconds, wall_milliseconds), outCpuTiming);
+    }
+
+    bool SubProcess::setup_sandboxed(SubProcess&, std::vector<std::string>, Sandbox const&, StderrState, bool) {
+        std::cerr << "Sandboxed processes are only supported on linux\n";
+        return false;
+    }
+
     static size_t unique_id = 0;
 
-    bool SubProcess::setup(SubProcess& process, std::vector<std::string> command, StderrState stderr_state, std::string const& working_directory) {
+    bool SubProcess::setup(SubProcess& process, std::vector<std::string> command, StderrState stderr_state, std::string const& working_directory, bool socket_io) {
         assert(!command.empty());
+        if (socket_io) {
+            std::cerr << "Socket io is not supported on windows\n";
+            return false;
+        }
 
         bool done = false;
 
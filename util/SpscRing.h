@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Assertions.h"
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace util {
+
+// A bounded queue between exactly one producer thread and one consumer thread.
+// Pushing and popping never lock, the wait functions block until the other side
+// made progress or the ring is closed.
+template<typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : m_slots(std::bit_ceil(capacity))
+        , m_mask(m_slots.size() - 1)
+    {
+        ASSERT(capacity > 0);
+    }
+
+    SpscRing(SpscRing const&) = delete;
+    SpscRing& operator=(SpscRing const&) = delete;
+
+    [[nodiscard]] size_t capacity() const { return m_slots.size(); }
+
+    // Producer side, returns false if the ring is full.
+    template<typename... Args>
+    bool try_emplace(Args&&... args)
+    {
+        auto tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == m_slots.size())
+            return false;
+
+        m_slots[tail & m_mask].emplace(std::forward<Args>(args)...);
+        m_tail.store(tail + 1, std::memory_order_release);
+        signal(m_pushed);
+        return true;
+    }
+
+    // Producer side, blocks until there is space. Returns false if the ring was closed.
+    bool wait_for_space()
+    {
+        return wait(m_popped, [&] { return m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_acquire) < m_slots.size(); });
+    }
+
+    // Producer side, blocks until the consumer popped everything. Returns false if the ring was closed.
+    bool wait_until_empty()
+    {
+        return wait(m_popped, [&] { return m_tail.load(std::memory_order_relaxed) == m_head.load(std::memory_order_acquire); });
+    }
+
+    // Consumer side, nullptr if the ring is empty.
+    T* front()
+    {
+        auto head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return nullptr;
+        return &*m_slots[head & m_mask];
+    }
+
+    // Consumer side, frees the slot of front() for the producer.
+    void pop()
+    {
+        auto head = m_head.load(std::memory_order_relaxed);
+        ASSERT(head != m_tail.load(std::memory_order_acquire));
+        m_slots[head & m_mask].reset();
+        m_head.store(head + 1, std::memory_order_release);
+        signal(m_popped);
+    }
+
+    // Consumer side, blocks until there is an item. Returns false if the ring was closed.
+    bool wait_for_item()
+    {
+        return wait(m_pushed, [&] { return m_head.load(std::memory_order_relaxed) != m_tail.load(std::memory_order_acquire); });
+    }
+
+    // Wakes up both sides, after this all waits return false.
+    void close()
+    {
+        m_closed.store(true);
+        signal(m_pushed);
+        signal(m_popped);
+    }
+
+    [[nodiscard]] bool closed() const { return m_closed.load(); }
+
+private:
+    // The signals only exist to sleep on, they count changes so a change between
+    // checking the condition and sleeping is never missed.
+    static void signal(std::atomic<uint32_t>& counter)
+    {
+        counter.fetch_add(1);
+        counter.notify_all();
+    }
+
+    template<typename Condition>
+    bool wait(std::atomic<uint32_t>& counter, Condition const& condition)
+    {
+        while (true) {
+            auto seen = counter.load();
+            if (m_closed.load())
+                return false;
+            if (condition())
+                return true;
+            counter.wait(seen);
+        }
+    }
+
+    std::vector<std::optional<T>> m_slots;
+    size_t const m_mask;
+
+    alignas(64) std::atomic<size_t> m_head { 0 };
+    alignas(64) std::atomic<size_t> m_tail { 0 };
+
+    alignas(64) std::atomic<uint32_t> m_pushed { 0 };
+    std::atomic<uint32_t> m_popped { 0 };
+    std::atomic<bool> m_closed { false };
+};
+
+}
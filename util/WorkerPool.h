@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Assertions.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+// A fixed set of threads which can run a batch of indexed tasks.
+// The thread calling run() also works on the batch and only returns once
+// every task has finished.
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t threads)
+    {
+        ASSERT(threads > 0);
+        // The calling thread is one of the workers.
+        for (size_t i = 1; i < threads; ++i)
+            m_threads.emplace_back([this] { work(); });
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard lock(m_lock);
+            m_stopping = true;
+        }
+        m_work_available.notify_all();
+        for (auto& thread : m_threads)
+            thread.join();
+    }
+
+    WorkerPool(WorkerPool const&) = delete;
+    WorkerPool& operator=(WorkerPool const&) = delete;
+
+    [[nodiscard]] size_t size() const { return m_threads.size() + 1; }
+
+    void run(size_t tasks, std::function<void(size_t)> const& task)
+    {
+        if (tasks == 0)
+            return;
+
+        if (tasks == 1 || m_threads.empty()) {
+            for (size_t i = 0; i < tasks; ++i)
+                task(i);
+            return;
+        }
+
+        auto batch = std::make_shared<Batch>(task, tasks);
+        {
+            std::lock_guard lock(m_lock);
+            m_batch = batch;
+            ++m_generation;
+        }
+        m_work_available.notify_all();
+
+        batch->work();
+
+        std::unique_lock lock(batch->done_lock);
+        batch->done.wait(lock, [&] { return batch->remaining.load() == 0; });
+    }
+
+private:
+    struct Batch {
+        Batch(std::function<void(size_t)> const& task_, size_t count_)
+            : task(task_)
+            , count(count_)
+            , remaining(count_)
+        {
+        }
+
+        void work()
+        {
+            for (size_t i = next++; i < count; i = next++) {
+                task(i);
+                if (--remaining == 0) {
+                    std::lock_guard lock(done_lock);
+                    done.notify_all();
+                }
+            }
+        }
+
+        std::function<void(size_t)> const& task;
+        size_t const count;
+        std::atomic<size_t> next { 0 };
+        std::atomic<size_t> remaining;
+
+        std::mutex done_lock;
+        std::condition_variable done;
+    };
+
+    void work()
+    {
+        uint64_t seen_generation = 0;
+        while (true) {
+            std::shared_ptr<Batch> batch;
+            {
+                std::unique_lock lock(m_lock);
+                m_work_available.wait(lock, [&] { return m_stopping || m_generation != seen_generation; });
+                if (m_stopping)
+                    return;
+                seen_generation = m_generation;
+                batch = m_batch;
+            }
+            batch->work();
+        }
+    }
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_lock;
+    std::condition_variable m_work_available;
+    std::shared_ptr<Batch> m_batch;
+    uint64_t m_generation { 0 };
+    bool m_stopping { false };
+};
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Process.h"
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace util {
+
+// A resident process with a runtime and bot code already loaded, which forks
+// a fresh instance of the bot whenever one is needed. This saves the startup
+// of interpreters on every run.
+//
+// The zygote gets one unix socket as both stdin and stdout. It must write
+// "ready\n" once it is loaded, and for every "spawn\n" message (carrying the
+// file descriptors for stdin, stdout, a lifetime socket and optionally an
+// opened cgroup.procs) fork a child using those as its stdin and stdout and
+// answer "ok\n". A "spawn <core>\n" pins the child to that core, as it would
+// have been when started from the thread holding that core reservation. When the child exits it writes "exit <code> <usage>\n" or
+// "killed <signal> <usage>\n" to the lifetime socket, usage being user and
+// system microseconds, peak rss in kilobytes and voluntary and involuntary
+// context switches (the rusage of wait4). When that socket is closed or shut
+// down the child is killed. Closing stdin stops the zygote and all its children.
+// In a sandbox the zygote may still create namespaces, and ZYGOTE_CHILD_FILTER in
+// its environment holds the seccomp program of bots in hex. Before running any
+// bot code every child must move into new user, mount and pid namespaces with
+// its own /tmp, and then install that program.
+// See bots-scripts/py/zygote.py for an example.
+class Zygote {
+public:
+    static std::unique_ptr<Zygote> start(std::vector<std::string> command, std::optional<SubProcess::Sandbox> sandbox = std::nullopt,
+        SubProcess::StderrState state = SubProcess::StderrState::Ignored, size_t startup_milliseconds = 10000);
+
+    Zygote() = default;
+    ~Zygote();
+
+    Zygote(Zygote const&) = delete;
+    Zygote& operator=(Zygote const&) = delete;
+
+    // The spawned process is used like any other SubProcess. With a sandbox
+    // configured with a cgroup parent each instance gets its own cgroup.
+    std::unique_ptr<SubProcess> spawn(size_t milliseconds = 1000);
+
+    [[nodiscard]] bool alive() const;
+
+private:
+    std::unique_ptr<SubProcess> m_process;
+    std::optional<SubProcess::Sandbox> m_sandbox;
+
+    std::mutex m_lock;
+    uint64_t m_spawned { 0 };
+};
+
+}
@@ -0,0 +1,240 @@
+#include "Zygote.h"
+#include "Assertions.h"
+#include "CoreAllocator.h"
+
+#ifndef POSIX_PROCESS
+#error Only for posix process handling
+#endif
+
+#include <cerrno>
+#include <sstream>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace util {
+
+    constexpr int pipeRead = 0;
+    constexpr int pipeWrite = 1;
+
+    std::unique_ptr<Zygote> Zygote::start(std::vector<std::string> command, std::optional<SubProcess::Sandbox> sandbox, SubProcess::StderrState state, size_t startup_milliseconds) {
+        auto zygote = std::make_unique<Zygote>();
+        zygote->m_process = std::make_unique<SubProcess>();
+
+        bool started = sandbox.has_value()
+            ? SubProcess::setup_sandboxed(*zygote->m_process, std::move(command), *sandbox, state, true)
+            : SubProcess::setup(*zygote->m_process, std::move(command), state, "", true);
+        if (!started)
+            return nullptr;
+
+        std::string line;
+        if (!zygote->m_process->readLineWithTimeout(line, startup_milliseconds) || line != "ready\n") {
+            std::cerr << "Zygote did not get ready\n";
+            return nullptr;
+        }
+
+        zygote->m_sandbox = std::move(sandbox);
+        return zygote;
+    }
+
+    Zygote::~Zygote() {
+        if (!m_process)
+            return;
+        // Closing our stdin end alone does not end the socket, the other direction still uses it.
+        if (m_process->running)
+            shutdown(m_process->m_std_in, SHUT_WR);
+        m_process->stop();
+    }
+
+    bool Zygote::alive() const {
+        if (!m_process || !m_process->running)
+            return false;
+
+        struct pollfd control {
+            m_process->m_std_out, POLLIN, 0
+        };
+        if (poll(&control, 1, 0) < 0)
+            return false;
+        // It only ever writes after we ask for something, so anything readable here is the end.
+        return (control.revents & (POLLIN | POLLHUP | POLLERR)) == 0;
+    }
+
+    static bool send_with_fds(int socket, std::string_view message, std::vector<int> const& fds) {
+        struct iovec data {
+            const_cast<char*>(message.data()), message.size()
+        };
+
+        std::vector<char> control(CMSG_SPACE(sizeof(int) * fds.size()));
+        struct msghdr header {};
+        header.msg_iov = &data;
+        header.msg_iovlen = 1;
+        header.msg_control = control.data();
+        header.msg_controllen = control.size();
+
+        struct cmsghdr* rights = CMSG_FIRSTHDR(&header);
+        rights->cmsg_level = SOL_SOCKET;
+        rights->cmsg_type = SCM_RIGHTS;
+        rights->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+        std::memcpy(CMSG_DATA(rights), fds.data(), sizeof(int) * fds.size());
+
+        ssize_t sent;
+        do {
+            sent = sendmsg(socket, &header, MSG_NOSIGNAL);
+        } while (sent < 0 && errno == EINTR);
+
+        if (sent != static_cast<ssize_t>(message.size())) {
+            perror("sendmsg");
+            return false;
+        }
+        return true;
+    }
+
+    std::unique_ptr<SubProcess> Zygote::spawn(size_t milliseconds) {
+        std::lock_guard lock(m_lock);
+        if (!alive())
+            return nullptr;
+
+        int inPipe[2] = { -1, -1 };
+        int outPipe[2] = { -1, -1 };
+        int lifetime[2] = { -1, -1 };
+        int cgroup_procs = -1;
+
+        auto close_all = [&] {
+            for (int* ends : { inPipe, outPipe, lifetime }) {
+                for (int end : { pipeRead, pipeWrite }) {
+                    if (ends[end] >= 0)
+                        close(ends[end]);
+                    ends[end] = -1;
+                }
+            }
+            if (cgroup_procs >= 0)
+                close(cgroup_procs);
+            cgroup_procs = -1;
+        };
+
+        if (pipe2(inPipe, O_CLOEXEC) < 0 || pipe2(outPipe, O_CLOEXEC) < 0
+            || socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, lifetime) < 0) {
+            perror("pipe2");
+            close_all();
+            return nullptr;
+        }
+
+        std::vector<int> fds { inPipe[pipeRead], outPipe[pipeWrite], lifetime[1] };
+
+        // The child moves itself into its own cgroup by writing to this file,
+        // we cannot do it for it since we do not know its pid.
+        std::string cgroup;
+        if (m_sandbox.has_value() && !m_sandbox->cgroup_parent.empty()) {
+            cgroup = m_sandbox->cgroup_parent + "/bot-" + std::to_string(getpid()) + "-" + std::to_string(++m_spawned);
+            if (!SubProcess::create_sandbox_cgroup(cgroup, *m_sandbox)) {
+                rmdir(cgroup.c_str());
+                close_all();
+                return nullptr;
+            }
+            cgroup_procs = open((cgroup + "/cgroup.procs").c_str(), O_WRONLY | O_CLOEXEC);
+            if (cgroup_procs < 0) {
+                perror("open");
+                rmdir(cgroup.c_str());
+                close_all();
+                return nullptr;
+            }
+            fds.push_back(cgroup_procs);
+        }
+
+        // A forked child has the affinity of the zygote, not of us.
+        std::string message = "spawn\n";
+        if (auto core = CoreAllocator::reserved_core_of_this_thread(); core.has_value())
+            message = "spawn " + std::to_string(*core) + '\n';
+
+        std::string answer;
+        if (!send_with_fds(m_process->m_std_in, message, fds)
+            || !m_process->readLineWithTimeout(answer, milliseconds) || answer != "ok\n") {
+            std::cerr << "Zygote failed to spawn\n";
+            close_all();
+            if (!cgroup.empty())
+                rmdir(cgroup.c_str());
+            return nullptr;
+        }
+
+        auto process = std::make_unique<SubProcess>();
+        process->m_std_in = inPipe[pipeWrite];
+        process->m_std_out = outPipe[pipeRead];
+        process->m_lifetime = lifetime[0];
+        process->m_cgroup = std::move(cgroup);
+        process->running = true;
+
+        inPipe[pipeWrite] = -1;
+        outPipe[pipeRead] = -1;
+        lifetime[0] = -1;
+        close_all();
+
+        return process;
+    }
+
+    static std::optional<std::string> read_line_from(int fd, size_t milliseconds) {
+        std::string line;
+        struct pollfd read_poll {
+            fd, POLLIN, 0
+        };
+
+        while (line.empty() || line.back() != '\n') {
+            int poll_result = poll(&read_poll, 1, static_cast<int>(milliseconds));
+            if (poll_result <= 0)
+                return std::nullopt;
+
+            char next;
+            ssize_t read_bytes = read(fd, &next, 1);
+            if (read_bytes <= 0)
+                return std::nullopt;
+            line += next;
+        }
+        return line;
+    }
+
+    SubProcess::ProcessExit SubProcess::stop_spawned() {
+        // Unlike stop() this does not depend on running, a failed write still needs the cleanup.
+        running = false;
+
+        // should trigger command ending
+        close(m_std_in);
+
+        auto report = read_line_from(m_lifetime, 1000);
+        if (!report.has_value()) {
+            // Asks the zygote to kill it, it still reports the exit.
+            shutdown(m_lifetime, SHUT_WR);
+            report = read_line_from(m_lifetime, 1000);
+        }
+
+        // "exit <code>" or "killed <signal>", followed by the resource usage of the child.
+        if (report.has_value()) {
+            std::istringstream fields(*report);
+            std::string kind;
+            int code = -1;
+            ResourceUsage usage;
+            fields >> kind >> code;
+            if (fields && kind == "exit")
+                m_exitCode = code;
+            if (fields >> usage.user_microseconds >> usage.system_microseconds >> usage.peak_memory_kilobytes
+                    >> usage.voluntary_context_switches >> usage.involuntary_context_switches)
+                m_usage = usage;
+        }
+
+        close(m_lifetime);
+        m_lifetime = -1;
+        close(m_std_out);
+
+        if (!m_cgroup.empty()) {
+            if (m_usage.has_value())
+                add_cgroup_usage(m_cgroup, *m_usage);
+            if (rmdir(m_cgroup.c_str()) < 0)
+                perror("rmdir");
+            m_cgroup.clear();
+        }
+
+        return { true, m_exitCode, m_usage };
+    }
+
+}
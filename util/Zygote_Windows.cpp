@@ -0,0 +1,21 @@
+#include "Zygote.h"
+#include <iostream>
+
+namespace util {
+
+    std::unique_ptr<Zygote> Zygote::start(std::vector<std::string>, std::optional<SubProcess::Sandbox>, SubProcess::StderrState, size_t) {
+        std::cerr << "Zygotes are not supported on windows\n";
+        return nullptr;
+    }
+
+    Zygote::~Zygote() = default;
+
+    std::unique_ptr<SubProcess> Zygote::spawn(size_t) {
+        return nullptr;
+    }
+
+    bool Zygote::alive() const {
+        return false;
+    }
+
+}